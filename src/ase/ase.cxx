@@ -5,6 +5,8 @@
 */
 #include <string.h>
 
+#include <emu/emu_state.h>
+
 #include "ase.h"
 
 #ifdef WIN32
@@ -29,38 +31,95 @@ void trace( const char * fmt, ... )
 
 #endif // WIN32
 
-const unsigned SamplingRate = 44100;
+AContext::AContext( unsigned samplingRate, unsigned initialBufferSize )
+{
+    sampling_rate_ = samplingRate;
+    initial_buffer_size_ = initialBufferSize;
+    steady_threshold_ = 1e-6;
+    channels_ = 0;
+}
 
-unsigned ASE::samplingRate = SamplingRate;
+void AContext::setSamplingRate( unsigned samplingRate )
+{
+    if( samplingRate != sampling_rate_ ) {
+        sampling_rate_ = samplingRate;
 
-AFloat ASE::samplesPerMs = ((AFloat) SamplingRate) / 1000.0;
+        for( AChannel * channel = channels_; channel != 0; channel = channel->next_ ) {
+            channel->onSamplingRateChanged();
+            channel->invalidate();
+        }
+    }
+}
+
+void AContext::serialize( TStateStream & state )
+{
+    for( AChannel * channel = channels_; channel != 0; channel = channel->next_ ) {
+        channel->serialize( state );
+    }
+}
 
-unsigned ASE::initialBufferSize = 0;
+void AContext::addChannel( AChannel * channel )
+{
+    channel->next_ = channels_;
+    channels_ = channel;
+}
 
-AChannel::AChannel()
+void AContext::removeChannel( AChannel * channel )
 {
-    if( ASE::initialBufferSize == 0 ) {
+    AChannel ** link = &channels_;
+
+    while( *link != 0 ) {
+        if( *link == channel ) {
+            *link = channel->next_;
+            break;
+        }
+
+        link = &(*link)->next_;
+    }
+}
+
+AChannel::AChannel( AContext & context ) : context_(context)
+{
+    if( context.initialBufferSize() == 0 ) {
         buffer_ = 0;
         buflen_ = 0;
     }
     else {
-        buffer_ = new AFloat [ ASE::initialBufferSize ];
-        buflen_ = ASE::initialBufferSize;
+        buffer_ = new AFloat [ context.initialBufferSize() ];
+        buflen_ = context.initialBufferSize();
     }
 
     bufofs_ = 0;
 
     enabled_ = true;
+
+    steady_ = false;
+    steady_value_ = 0;
+    changes_ = 0;
+    input_changes_ = 0;
+
+    context.addChannel( this );
 }
 
 AChannel::~AChannel()
 {
+    context_.removeChannel( this );
+
     delete [] buffer_;
 }
 
+void AChannel::serialize( TStateStream & state )
+{
+    state.value( enabled_ );
+    state.value( steady_ );
+    state.value( steady_value_ );
+    state.value( changes_ );
+    state.value( input_changes_ );
+}
+
 void AChannel::updateToTime( double time )
 {
-    unsigned offset = (unsigned) (time * ASE::samplingRate);
+    unsigned offset = (unsigned) (time * context_.samplingRate());
 
     updateTo( offset );
 }
@@ -68,33 +127,25 @@ void AChannel::updateToTime( double time )
 void AChannel::updateTo( unsigned offset )
 {
     if( bufofs_ < offset ) {
-        // Expand buffer if needed
-        if( buflen_ < offset ) {
-            // Allocate new buffer
-            buflen_ = offset;
-
-            AFloat * buf = new AFloat [ buflen_ ];
+        expandBuffer( offset );
 
-            // Copy content and dispose old buffer
-            if( buffer_ != 0 ) {
-                memcpy( buf, buffer_, sizeof(AFloat)*bufofs_ );
-                delete [] buffer_;
-            }
-
-            buffer_ = buf;
-        }
-
-        if( enabled_ ) {
-            // Invoke the update implementation
-            updateBuffer( buffer_ + bufofs_, offset - bufofs_, offset );
-        }
-        else {
+        if( ! enabled_ ) {
             // Fill the buffer with zeroes
             while( bufofs_ < offset ) {
                 buffer_[ bufofs_ ] = 0;
                 bufofs_++;
             }
         }
+        else if( steady_ && updateInputs( offset ) ) {
+            // Nothing has changed since last update
+            fillSteady( offset );
+        }
+        else {
+            // Invoke the update implementation
+            updateBuffer( buffer_ + bufofs_, offset - bufofs_, offset );
+
+            setUpdated( offset );
+        }
 
         // Update the buffer offset
         bufofs_ = offset;
@@ -106,6 +157,65 @@ void AChannel::updateTo( unsigned offset )
     }
 }
 
+void AChannel::expandBuffer( unsigned size )
+{
+    if( buflen_ < size ) {
+        // Allocate new buffer
+        buflen_ = size;
+
+        AFloat * buf = new AFloat [ buflen_ ];
+
+        // Copy content and dispose old buffer
+        if( buffer_ != 0 ) {
+            memcpy( buf, buffer_, sizeof(AFloat)*bufofs_ );
+            delete [] buffer_;
+        }
+
+        buffer_ = buf;
+    }
+}
+
+bool AChannel::updateInputs( unsigned offset )
+{
+    unsigned changes = 0;
+
+    for( unsigned i=0; i<inputCount(); i++ ) {
+        if( dependsOnInput( i ) ) {
+            AChannel * channel = input( i );
+
+            channel->updateTo( offset );
+
+            changes += channel->changes_;
+        }
+    }
+
+    // Counters only increase, so the sum is unchanged only if all inputs are unchanged
+    return changes == input_changes_;
+}
+
+void AChannel::fillSteady( unsigned offset )
+{
+    while( bufofs_ < offset ) {
+        buffer_[ bufofs_ ] = steady_value_;
+        bufofs_++;
+    }
+}
+
+void AChannel::setUpdated( unsigned offset )
+{
+    steady_value_ = buffer_[ offset-1 ];
+    steady_ = isSteady();
+    changes_++;
+
+    input_changes_ = 0;
+
+    for( unsigned i=0; i<inputCount(); i++ ) {
+        if( dependsOnInput( i ) ) {
+            input_changes_ += input( i )->changes_;
+        }
+    }
+}
+
 void AChannel::mixStream( int * dest, AFloat gain )
 {
     unsigned len = bufofs_;
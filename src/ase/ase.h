@@ -16,17 +16,34 @@ void trace( const char * fmt, ... );
 #include <math.h>
 #include <string.h>
 
-typedef double AFloat; // Doesn't seem to work with less than double precision!
+/*
+    Precision of the analog emulation, define ASE_SINGLE_PRECISION to build
+    the library with float samples. On the Galaga hit circuit (noise, capacitor
+    and bandpass filter, mixed to 8 bits) the output of the two builds differs
+    by one step in about 1.5% of the samples; "make check" renders the circuit
+    with both and fails if the difference exceeds 5 steps or 2% of the samples
+    (see regress/ase_precision.cxx). The old 4th order direct form bandpass
+    filter did not work at all in single precision, which is why double is
+    still the default.
+*/
+#ifdef ASE_SINGLE_PRECISION
+typedef float AFloat;
+#else
+typedef double AFloat;
+#endif
+
+class AChannel;
+class TStateStream;
 
 class ASE
 {
 public:
-    static unsigned samplingRate;
-    static AFloat samplesPerMs;
-    static unsigned initialBufferSize;
+    enum {
+        DefaultSamplingRate = 44100
+    };
 
-    static AFloat getRCFactor( AFloat r, AFloat c ) {
-        return exp( -1.0 / (r * c * ASE::samplingRate) );
+    static AFloat getRCFactor( AFloat r, AFloat c, unsigned samplingRate ) {
+        return exp( -1.0 / (r * c * samplingRate) );
     }
 
     static AFloat resInParallel( AFloat r1, AFloat r2 ) {
@@ -34,10 +51,70 @@ public:
     }
 };
 
+/*
+    Parameters shared by all the channels of a circuit.
+
+    Each board that uses the library owns a context and passes it to the
+    channels it creates (filters take it from their source). When the sampling
+    rate changes all the channels are notified, so they can recompute their
+    coefficients.
+*/
+class AContext
+{
+public:
+    AContext( unsigned samplingRate = ASE::DefaultSamplingRate, unsigned initialBufferSize = 0 );
+
+    unsigned samplingRate() const {
+        return sampling_rate_;
+    }
+
+    AFloat samplesPerMs() const {
+        return ((AFloat) sampling_rate_) / 1000.0;
+    }
+
+    unsigned initialBufferSize() const {
+        return initial_buffer_size_;
+    }
+
+    void setSamplingRate( unsigned samplingRate );
+
+    void setInitialBufferSize( unsigned size ) {
+        initial_buffer_size_ = size;
+    }
+
+    AFloat getRCFactor( AFloat r, AFloat c ) const {
+        return ASE::getRCFactor( r, c, sampling_rate_ );
+    }
+
+    // Channels whose state is within this distance from steady state are considered settled
+    AFloat steadyThreshold() const {
+        return steady_threshold_;
+    }
+
+    void setSteadyThreshold( AFloat threshold ) {
+        steady_threshold_ = threshold;
+    }
+
+    // Saves or loads the state of all the channels that use this context
+    void serialize( TStateStream & state );
+
+private:
+    friend class AChannel;
+
+    void addChannel( AChannel * channel );
+
+    void removeChannel( AChannel * channel );
+
+    unsigned sampling_rate_;
+    unsigned initial_buffer_size_;
+    AFloat steady_threshold_;
+    AChannel * channels_;   // List of channels using this context
+};
+
 class AChannel
 {
 public:
-    AChannel();
+    AChannel( AContext & context );
 
     virtual ~AChannel();
 
@@ -66,18 +143,108 @@ public:
     }
 
     void setEnabled( bool enabled ) {
-        enabled_ = enabled;
+        if( enabled != enabled_ ) {
+            // Output switches between the stream and zeroes, channels that use it must see the change
+            enabled_ = enabled;
+            invalidate();
+            changes_++;
+        }
+    }
+
+    AContext & context() {
+        return context_;
+    }
+
+    // Inputs of this channel, used to walk the circuit graph
+    virtual unsigned inputCount() {
+        return 0;
+    }
+
+    virtual AChannel * input( unsigned index ) {
+        return 0;
+    }
+
+    /*
+        Channels whose output only depends on their single input stream also
+        process blocks of samples directly, so that AGraph can run a chain of
+        them without storing the intermediate streams. Source and destination
+        may be the same buffer.
+    */
+    virtual bool isSimpleFilter() {
+        return false;
+    }
+
+    virtual void filter( AFloat * dst, const AFloat * src, unsigned len ) {
     }
 
+    /*
+        Saves or loads the channel state. States are taken between frames, so
+        the streams are not saved: they are reset at the start of every frame.
+        Channels with a state override this and call the base implementation.
+    */
+    virtual void serialize( TStateStream & state );
+
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs ) = 0;
 
+    // Called when the sampling rate of the context changes
+    virtual void onSamplingRateChanged() {
+    }
+
+    /*
+        Steady state detection.
+
+        After each update a channel is asked whether it has settled, i.e. its
+        output will stay at the last value for as long as its inputs don't
+        change. While this holds and the inputs it depends on are unchanged,
+        the channel is not updated at all and its stream is filled with the
+        last value. Inputs that don't affect the output in the current state
+        (see dependsOnInput) are not even updated.
+
+        Channels must call invalidate() when they are modified from outside
+        in a way that changes their output.
+    */
+    virtual bool isSteady() {
+        return false;
+    }
+
+    virtual bool dependsOnInput( unsigned index ) {
+        return true;
+    }
+
+    void invalidate() {
+        steady_ = false;
+    }
+
+    bool isSettled( AFloat value ) {
+        return fabs( value ) < context_.steadyThreshold();
+    }
+
 private:
+    friend class AContext;
+    friend class AGraph;
+
+    void expandBuffer( unsigned size );
+
+    bool updateInputs( unsigned offset );
+
+    void fillSteady( unsigned offset );
+
+    void setUpdated( unsigned offset );
+
+    AContext & context_;
+    AChannel * next_;       // Next channel in the context list
+
     AFloat * buffer_;
     unsigned buflen_;
     unsigned bufofs_;
 
     bool enabled_;
+
+    bool steady_;           // Output will not change unless inputs do
+    AFloat steady_value_;   // Last output value
+    unsigned changes_;      // Incremented every time the stream is actually computed
+    unsigned input_changes_;// Sum of the input changes at last computation
 };
 
 inline AFloat Mega( AFloat x ) {
@@ -6,7 +6,10 @@
 #include <assert.h>
 #include <math.h>
 
+#include <emu/emu_state.h>
+
 #include "ase_bandpass_filter.h"
+#include "ase_kernels.h"
 
 const double PI = 3.1415926535898;
 
@@ -18,23 +21,51 @@ AButterworthBandPassFilter::AButterworthBandPassFilter( AChannel & source )
 
 void AButterworthBandPassFilter::clear()
 {
-    for( int i=0; i<5; i++ ) {
-        x[i] = 0.0;
-        y[i] = 0.0;
+    for( int i=0; i<4; i++ ) {
+        state_[0][i] = 0.0;
+        state_[1][i] = 0.0;
     }
+
+    invalidate();
+}
+
+bool AButterworthBandPassFilter::isSteady()
+{
+    // There is a zero at DC, so the filter settles to zero if the input is constant
+    return state_[0][0] == state_[0][1] &&
+        isSettled( state_[0][2] ) && isSettled( state_[0][3] ) &&
+        isSettled( state_[1][0] ) && isSettled( state_[1][1] ) &&
+        isSettled( state_[1][2] ) && isSettled( state_[1][3] );
 }
 
 void AButterworthBandPassFilter::setBand( double lo_freq, double hi_freq )
+{
+    lo_freq_ = lo_freq;
+    hi_freq_ = hi_freq;
+
+    setSections();
+
+    // Set gain
+    gain_ = 1.0;
+
+    invalidate();
+}
+
+void AButterworthBandPassFilter::onSamplingRateChanged()
+{
+    setSections();
+}
+
+void AButterworthBandPassFilter::setSections()
 {
     Complex s_pole[4];
     Complex z_pole[4];
-    Complex z_zero[4];
 
     int i;
 
     // Scale frequencies to sampling rate
-    lo_freq /= ASE::samplingRate;
-    hi_freq /= ASE::samplingRate;
+    double lo_freq = lo_freq_ / context().samplingRate();
+    double hi_freq = hi_freq_ / context().samplingRate();
 
     // Initialize s-plane (4 poles for order 2, but only two are created here)
     int poles = 0;
@@ -69,73 +100,42 @@ void AButterworthBandPassFilter::setBand( double lo_freq, double hi_freq )
         s_pole[i+2] = hba * (1.0 - temp);
     }
 
-    // Bilinear transform from s-plane to z-plane
+    // Bilinear transform from s-plane to z-plane (zeros are at +1 and -1)
     for( i=0; i<4; i++ ) {
         z_pole[i] = Complex( (2.0 + s_pole[i]) / (2.0 - s_pole[i]) );
-        z_zero[i] = (i < 2) ? Complex( +1.0 ) : Complex( -1.0 );
     }
 
-    // Compute polynomials in z
-    Complex a_coeff[5] = { 1.0, 0.0, 0.0, 0.0, 0.0 };
-    Complex b_coeff[5] = { 1.0, 0.0, 0.0, 0.0, 0.0 };
-
-    for( i=0; i<4; i++ ) {
-        int j;
-        Complex c;
-        
-        c = - z_zero[i];
-
-        for( j=4; j>=1; j-- ) {
-            a_coeff[j] = (c * a_coeff[j]) + a_coeff[j-1];
-        }
-
-        a_coeff[0] = c * a_coeff[0];
-
-        c = - z_pole[i];
-
-        for( j=4; j>=1; j-- ) {
-            b_coeff[j] = (c * b_coeff[j]) + b_coeff[j-1];
-        }
+    /*
+        Poles come in two conjugate pairs and each pair shares a zero at +1 and
+        one at -1, so the transfer function factors into two sections:
 
-        b_coeff[0] = c * b_coeff[0];
-    }
+        H(z) = (z^2 - 1) / (z^2 - 2*Re(p)*z + |p|^2) * (z^2 - 1) / (...)
 
-    // Compute coefficients
-    for( i=0; i<=4; i++ ) {
-        a[i] = (AFloat) +(a_coeff[i].real / b_coeff[4].real);
-        b[i] = (AFloat) -(b_coeff[i].real / b_coeff[4].real);
+        This is the same filter as the expanded 4th order polynomial, but the
+        cascade is much less sensitive to rounding of the coefficients.
+    */
+    for( i=0; i<2; i++ ) {
+        Complex p = z_pole[i*2];
+
+        section_[i][0] = +1.0;
+        section_[i][1] = 0.0;
+        section_[i][2] = -1.0;
+        section_[i][3] = (AFloat) (2 * p.real);
+        section_[i][4] = (AFloat) -(p.real*p.real + p.imag*p.imag);
     }
-
-    // Set gain
-    gain_ = 1.0;
 }
 
 void AButterworthBandPassFilter::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
 {
     source().updateTo( ofs );
 
-    AFloat * src = source().stream() + streamSize();
-
-    while( len > 0 ) {
-        x[0] = x[1]; 
-        x[1] = x[2]; 
-        x[2] = x[3]; 
-        x[3] = x[4]; 
-
-        x[4] = *src++ / gain_;
-
-        y[0] = y[1]; 
-        y[1] = y[2]; 
-        y[2] = y[3]; 
-        y[3] = y[4]; 
-
-        y[4] = a[0]*x[0] + a[1]*x[1] + a[2]*x[2] + a[3]*x[3] + a[4]*x[4] +
-               b[0]*y[0] + b[1]*y[1] + b[2]*y[2] + b[3]*y[3];
-
-        *buf++ = y[4];
+    filter( buf, source().stream() + streamSize(), len );
+}
 
-        len--;
-    }
+void AButterworthBandPassFilter::filter( AFloat * buf, const AFloat * src, unsigned len )
+{
+    AKernel::biquad( buf, src, len, 1 / gain_, section_[0], state_[0] );
+    AKernel::biquad( buf, buf, len, 1, section_[1], state_[1] );
 }
 
 AActiveBandPassFilter::AActiveBandPassFilter( AChannel & source, double r1, double r2, double r3, double c1, double c2 )
@@ -169,3 +169,21 @@ void AActiveBandPassFilter::setBand()
 
     AButterworthBandPassFilter::setBand( f_lo, f_hi );
 }
+
+void AButterworthBandPassFilter::serialize( TStateStream & state )
+{
+    AFilter::serialize( state );
+
+    state.value( lo_freq_ );
+    state.value( hi_freq_ );
+    state.value( gain_ );
+    state.bytes( section_, sizeof(section_) );
+    state.bytes( state_, sizeof(state_) );
+}
+
+void AActiveBandPassFilter::serialize( TStateStream & state )
+{
+    AButterworthBandPassFilter::serialize( state );
+
+    state.value( r1_ );
+}
@@ -29,17 +29,32 @@ public:
 
     void setGain( AFloat gain ) {
         gain_ = gain;
+        invalidate();
     }
 
+    virtual bool isSimpleFilter() {
+        return true;
+    }
+
+    virtual void filter( AFloat * buf, const AFloat * src, unsigned len );
+
+    virtual void serialize( TStateStream & state );
+
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual void onSamplingRateChanged();
+
+    virtual bool isSteady();
+
 private:
+    void setSections();
+
+    double lo_freq_;
+    double hi_freq_;
     AFloat gain_;
-    AFloat x[5];
-    AFloat y[5];
-    AFloat a[5];
-    AFloat b[5]; // For simmetry, actually b[0] is never used
+    AFloat section_[2][5];  // Coefficients of the two second order sections
+    AFloat state_[2][4];
 };
 
 /*
@@ -74,6 +89,8 @@ public:
 
     void setBand();
 
+    virtual void serialize( TStateStream & state );
+
 private:
     double r1_;
     double r2_;
@@ -3,22 +3,35 @@
 
     Copyright (c) 2004 Alessandro Scotti
 */
+#include <emu/emu_state.h>
+
 #include "ase_capacitor_with_switch.h"
 
 const AFloat ControlOnThreshold = 1.0;
 
 ACapacitorWithSwitch ::ACapacitorWithSwitch( AChannel & input, AChannel & control, AFloat cr, AFloat dr, AFloat c )
-    : input_(input), control_(control)
+    : AChannel( input.context() ), input_(input), control_(control)
 {
     c_ = c;
     r0_ = cr;
     r1_ = dr;
 
     y_ = 0; // No charge in the capacitor yet
+    charging_ = false;
+
+    setCoefficients();
+}
 
-    b0_ = ASE::getRCFactor( cr, c ); // Charge path
+void ACapacitorWithSwitch::setCoefficients()
+{
+    b0_ = context().getRCFactor( r0_, c_ ); // Charge path
     a0_ = 1 - b0_;
-    b1_ = ASE::getRCFactor( dr, c ); // Discharge path
+    b1_ = context().getRCFactor( r1_, c_ ); // Discharge path
+}
+
+void ACapacitorWithSwitch::onSamplingRateChanged()
+{
+    setCoefficients();
 }
 
 void ACapacitorWithSwitch ::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
@@ -31,7 +44,9 @@ void ACapacitorWithSwitch ::updateBuffer( AFloat * buf, unsigned len, unsigned o
 
     while( len > 0 ) {
         // Charge (avoid discharging thru this resistor)
-        if( *inp > 0.1 ) {
+        charging_ = *inp > 0.1;
+
+        if( charging_ ) {
             y_ = a0_ * (*inp) + b0_ * y_;
         }
 
@@ -53,3 +68,11 @@ void ACapacitorWithSwitch ::updateBuffer( AFloat * buf, unsigned len, unsigned o
         len--;
     }
 }
+
+void ACapacitorWithSwitch::serialize( TStateStream & state )
+{
+    AChannel::serialize( state );
+
+    state.value( y_ );
+    state.value( charging_ );
+}
@@ -27,12 +27,36 @@ public:
 
     void setCharge( AFloat charge ) {
         y_ = charge;
+        invalidate();
+    }
+
+    virtual void serialize( TStateStream & state );
+
+    virtual unsigned inputCount() {
+        return 2;
+    }
+
+    virtual AChannel * input( unsigned index ) {
+        return (index == 0) ? &input_ : &control_;
     }
 
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual void onSamplingRateChanged();
+
+    // Once discharged and with no input, the output is zero whatever the control does
+    virtual bool isSteady() {
+        return ! charging_ && isSettled( y_ );
+    }
+
+    virtual bool dependsOnInput( unsigned index ) {
+        return (index == 0) || ! isSettled( y_ );
+    }
+
 private:
+    void setCoefficients();
+
     AChannel & input_;
     AChannel & control_;
     AFloat c_;
@@ -42,6 +66,7 @@ private:
     AFloat b0_;
     AFloat b1_;
     AFloat y_;
+    bool charging_;
 };
 
 #endif // ASE_CAPACITOR_WITH_SWITCH_H_
@@ -15,8 +15,11 @@ void AClipperLo::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
 {
     source().updateTo( ofs );
 
-    AFloat * src = source().stream() + streamSize();
+    filter( buf, source().stream() + streamSize(), len );
+}
 
+void AClipperLo::filter( AFloat * buf, const AFloat * src, unsigned len )
+{
     while( len > 0 ) {
         if( *src >= lo_ ) {
             *buf = *src;
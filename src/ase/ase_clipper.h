@@ -14,9 +14,19 @@ class AClipperLo : public AFilter
 public:
     AClipperLo( AChannel & source, AFloat lo );
 
+    virtual bool isSimpleFilter() {
+        return true;
+    }
+
+    virtual void filter( AFloat * buf, const AFloat * src, unsigned len );
+
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual bool isSteady() {
+        return true;
+    }
+
 private:
     AFloat lo_;
 };
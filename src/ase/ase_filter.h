@@ -11,7 +11,15 @@
 class AFilter : public AChannel
 {
 public:
-    AFilter( AChannel & source ) : source_(source) {
+    AFilter( AChannel & source ) : AChannel( source.context() ), source_(source) {
+    }
+
+    virtual unsigned inputCount() {
+        return 1;
+    }
+
+    virtual AChannel * input( unsigned index ) {
+        return &source_;
     }
 
 protected:
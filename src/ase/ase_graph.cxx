@@ -0,0 +1,233 @@
+/*
+    Analog sound emulation library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#include "ase_graph.h"
+
+AGraph::AGraph()
+{
+    output_count_ = 0;
+    node_count_ = 0;
+    step_count_ = 0;
+    stage_count_ = 0;
+    fused_count_ = 0;
+}
+
+void AGraph::addOutput( AChannel * channel )
+{
+    assert( output_count_ < MaxOutputs );
+
+    output_[ output_count_++ ] = channel;
+}
+
+int AGraph::findNode( AChannel * channel )
+{
+    for( unsigned i=0; i<node_count_; i++ ) {
+        if( node_[i] == channel ) {
+            return (int) i;
+        }
+    }
+
+    return -1;
+}
+
+void AGraph::addNode( AChannel * channel )
+{
+    if( findNode( channel ) >= 0 ) {
+        return;
+    }
+
+    // Add inputs first, so that nodes end up in topological order
+    for( unsigned i=0; i<channel->inputCount(); i++ ) {
+        addNode( channel->input( i ) );
+    }
+
+    assert( node_count_ < MaxNodes );
+
+    node_[ node_count_ ] = channel;
+    consumers_[ node_count_ ] = 0;
+    is_output_[ node_count_ ] = false;
+    node_count_++;
+}
+
+bool AGraph::isFusedIntoConsumer( int node )
+{
+    // A simple filter can be fused into the next stage if nobody else needs its stream
+    return node_[node]->isSimpleFilter() && ! is_output_[node] && consumers_[node] == 1;
+}
+
+void AGraph::compile()
+{
+    unsigned i;
+
+    node_count_ = 0;
+    step_count_ = 0;
+    stage_count_ = 0;
+    fused_count_ = 0;
+
+    // Collect all the channels
+    for( i=0; i<output_count_; i++ ) {
+        addNode( output_[i] );
+    }
+
+    for( i=0; i<output_count_; i++ ) {
+        is_output_[ findNode( output_[i] ) ] = true;
+    }
+
+    for( i=0; i<node_count_; i++ ) {
+        for( unsigned j=0; j<node_[i]->inputCount(); j++ ) {
+            consumers_[ findNode( node_[i]->input( j ) ) ]++;
+        }
+    }
+
+    // Build the schedule: a stage fused into its consumer is not scheduled by
+    // itself, it's run as part of the chain ending with the first stage that
+    // must keep its stream. Chains are run in topological order, so that their
+    // output is ready when another channel pulls it
+    for( i=0; i<node_count_; i++ ) {
+        AChannel * channel = node_[i];
+
+        Step & step = step_[ step_count_ ];
+
+        step.channel = channel;
+        step.first = 0;
+        step.stages = 0;
+
+        if( channel->isSimpleFilter() ) {
+            if( isFusedIntoConsumer( (int) i ) ) {
+                // Check that the consumer is a simple filter too
+                bool fused = false;
+
+                for( unsigned j=i+1; j<node_count_; j++ ) {
+                    if( node_[j]->inputCount() > 0 && node_[j]->input( 0 ) == channel ) {
+                        fused = node_[j]->isSimpleFilter();
+                        break;
+                    }
+                }
+
+                if( fused ) {
+                    fused_count_++;
+                    continue;
+                }
+            }
+
+            // Walk back along the chain
+            unsigned stages = 1;
+            AChannel * stage = channel;
+
+            while( true ) {
+                int source = findNode( stage->input( 0 ) );
+
+                if( ! isFusedIntoConsumer( source ) ) {
+                    break;
+                }
+
+                stage = node_[source];
+                stages++;
+            }
+
+            if( stages > 1 ) {
+                step.first = stage_count_;
+                step.stages = stages;
+
+                stage_count_ += stages;
+
+                for( unsigned j=stages; j>0; j-- ) {
+                    stage_[ step.first + j - 1 ] = channel;
+                    channel = channel->input( 0 );
+                }
+            }
+        }
+
+        // Other channels are updated on demand by the channels that use them,
+        // so that inputs that are not needed in the current state are skipped
+        if( step.stages > 0 || is_output_[i] ) {
+            step_count_++;
+        }
+    }
+}
+
+void AGraph::runChain( const Step & step, unsigned offset )
+{
+    AChannel * tail = step.channel;
+    unsigned start = tail->bufofs_;
+
+    if( offset == 0 || offset <= start ) {
+        // Nothing to compute, but let the channel reset its stream if needed
+        tail->updateTo( offset );
+        return;
+    }
+
+    AChannel * source = stage_[ step.first ]->input( 0 );
+
+    source->updateTo( offset );
+
+    tail->expandBuffer( offset );
+
+    // Any stage may have been modified (e.g. disabled) since the chain settled
+    bool steady = tail->steady_ && source->changes_ == tail->input_changes_;
+
+    for( unsigned i=0; steady && i<step.stages; i++ ) {
+        steady = stage_[ step.first + i ]->steady_;
+    }
+
+    if( steady ) {
+        // All stages have settled and the input hasn't changed
+        tail->fillSteady( offset );
+        return;
+    }
+
+    const AFloat * src = source->stream();
+    AFloat * buf = tail->buffer_;
+
+    // Run all stages on a block before moving to the next one
+    for( unsigned ofs = start; ofs < offset; ofs += BlockSize ) {
+        unsigned len = offset - ofs;
+
+        if( len > BlockSize ) {
+            len = BlockSize;
+        }
+
+        for( unsigned i=0; i<step.stages; i++ ) {
+            AChannel * stage = stage_[ step.first + i ];
+
+            if( stage->enabled_ ) {
+                stage->filter( buf + ofs, (i == 0) ? src + ofs : buf + ofs, len );
+            }
+            else {
+                memset( buf + ofs, 0, sizeof(AFloat)*len );
+            }
+        }
+    }
+
+    tail->bufofs_ = offset;
+
+    // The chain has settled only if all of its stages have (fused stages are
+    // not updated by themselves, their flag only records that they settled)
+    steady = true;
+
+    for( unsigned i=0; i<step.stages; i++ ) {
+        AChannel * stage = stage_[ step.first + i ];
+
+        stage->steady_ = ! stage->enabled_ || stage->isSteady();
+        steady = steady && stage->steady_;
+    }
+
+    tail->steady_value_ = buf[ offset-1 ];
+    tail->steady_ = steady;
+    tail->changes_++;
+    tail->input_changes_ = source->changes_;
+}
+
+void AGraph::updateTo( unsigned offset )
+{
+    for( unsigned i=0; i<step_count_; i++ ) {
+        if( step_[i].stages > 0 ) {
+            runChain( step_[i], offset );
+        }
+        else {
+            step_[i].channel->updateTo( offset );
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/*
+    Analog sound emulation library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#ifndef ASE_GRAPH_H_
+#define ASE_GRAPH_H_
+
+#include "ase.h"
+
+/*
+    Schedules the evaluation of a circuit.
+
+    The graph is walked once from the output channels and sorted so that each
+    channel is updated after its inputs. Chains of simple filters (see
+    AChannel::filter) where each intermediate stage only feeds the next one
+    are fused: the chain is run a block at a time in the buffer of the last
+    stage, and the intermediate streams are never stored.
+
+    Chains that have settled (see AChannel::isSteady) are not run at all.
+
+    Fused stages don't keep a stream of their own, so channels that are read
+    or updated directly by the board must be added as outputs.
+*/
+class AGraph
+{
+public:
+    AGraph();
+
+    void addOutput( AChannel * channel );
+
+    void compile();
+
+    // Updates all the outputs to the specified offset
+    void updateTo( unsigned offset );
+
+    // Number of channels in the graph
+    unsigned nodeCount() const {
+        return node_count_;
+    }
+
+    // Number of channels whose stream is not stored anymore
+    unsigned fusedCount() const {
+        return fused_count_;
+    }
+
+private:
+    enum {
+        MaxNodes = 64,
+        MaxOutputs = 16,
+        BlockSize = 64  // Block size for fused chains, small enough to stay in the cache
+    };
+
+    struct Step {
+        AChannel *  channel;    // Channel to update, or last stage of a fused chain
+        unsigned    first;      // Index of the first stage in stage_
+        unsigned    stages;     // Number of fused stages, zero for a normal channel
+    };
+
+    int findNode( AChannel * channel );
+
+    void addNode( AChannel * channel );
+
+    bool isFusedIntoConsumer( int node );
+
+    void runChain( const Step & step, unsigned offset );
+
+    AChannel *  output_[ MaxOutputs ];
+    unsigned    output_count_;
+    AChannel *  node_[ MaxNodes ];      // Channels in topological order
+    unsigned    consumers_[ MaxNodes ]; // Number of channels that use each node as input
+    bool        is_output_[ MaxNodes ];
+    unsigned    node_count_;
+    Step        step_[ MaxNodes ];
+    unsigned    step_count_;
+    AChannel *  stage_[ MaxNodes ];     // Stages of all fused chains, in order
+    unsigned    stage_count_;
+    unsigned    fused_count_;
+};
+
+#endif // ASE_GRAPH_H_
@@ -17,8 +17,11 @@ void AInverter::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
 {
     source().updateTo( ofs );
 
-    AFloat * src = source().stream() + streamSize();
+    filter( buf, source().stream() + streamSize(), len );
+}
 
+void AInverter::filter( AFloat * buf, const AFloat * src, unsigned len )
+{
     while( len > 0 ) {
         if( *src++ > threshold_ ) {
             *buf = lo_;
@@ -14,9 +14,19 @@ class AInverter : public AFilter
 public:
     AInverter( AChannel & source, AFloat hi, AFloat lo, AFloat threshold = 2.5 );
 
+    virtual bool isSimpleFilter() {
+        return true;
+    }
+
+    virtual void filter( AFloat * buf, const AFloat * src, unsigned len );
+
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual bool isSteady() {
+        return true;
+    }
+
 private:
     AFloat hi_;
     AFloat lo_;
@@ -0,0 +1,102 @@
+/*
+    Analog sound emulation library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#include "ase_kernels.h"
+
+void AKernel::scale( AFloat * dst, const AFloat * src, unsigned len, AFloat gain )
+{
+    for( unsigned i=0; i<len; i++ ) {
+        dst[i] = src[i] * gain;
+    }
+}
+
+void AKernel::mix( AFloat * dst, const AFloat * src, unsigned len, AFloat gain )
+{
+    for( unsigned i=0; i<len; i++ ) {
+        dst[i] += src[i] * gain;
+    }
+}
+
+void AKernel::onePole( AFloat * dst, const AFloat * src, unsigned len, AFloat a, AFloat b, AFloat & y )
+{
+    AFloat b2 = b * b;
+    AFloat b3 = b2 * b;
+    AFloat b4 = b3 * b;
+    AFloat s = y;
+
+    // Four samples at a time, each output only depends on the previous block
+    while( len >= 4 ) {
+        AFloat x0 = a * src[0];
+        AFloat x1 = a * src[1];
+        AFloat x2 = a * src[2];
+        AFloat x3 = a * src[3];
+
+        dst[0] = x0 + b * s;
+        dst[1] = x1 + b * x0 + b2 * s;
+        dst[2] = x2 + b * x1 + b2 * x0 + b3 * s;
+        s = x3 + b * x2 + b2 * x1 + b3 * x0 + b4 * s;
+        dst[3] = s;
+
+        src += 4;
+        dst += 4;
+        len -= 4;
+    }
+
+    while( len > 0 ) {
+        s = a * (*src++) + b * s;
+
+        *dst++ = s;
+
+        len--;
+    }
+
+    y = s;
+}
+
+void AKernel::biquad( AFloat * dst, const AFloat * src, unsigned len, AFloat gain, const AFloat * c, AFloat * state )
+{
+    AFloat c0 = c[0] * gain;
+    AFloat c1 = c[1];
+    AFloat c2 = c[2];
+    AFloat c3 = c[3];
+    AFloat c4 = c[4];
+    AFloat x1 = state[0];
+    AFloat x2 = state[1];
+    AFloat y1 = state[2];
+    AFloat y2 = state[3];
+
+    while( len > 0 ) {
+        AFloat x0 = *src++;
+        AFloat y0 = c0*x0 + c1*x1 + c2*x2 + c3*y1 + c4*y2;
+
+        *dst++ = y0;
+
+        x2 = x1;
+        x1 = x0 * gain;
+        y2 = y1;
+        y1 = y0;
+
+        len--;
+    }
+
+    state[0] = x1;
+    state[1] = x2;
+    state[2] = y1;
+    state[3] = y2;
+}
+
+void AKernel::fill( AFloat * dst, unsigned len, AFloat value )
+{
+    for( unsigned i=0; i<len; i++ ) {
+        dst[i] = value;
+    }
+}
+
+void AKernel::ramp( AFloat * dst, unsigned len, AFloat start, AFloat step )
+{
+    for( unsigned i=0; i<len; i++ ) {
+        dst[i] = start + step * (AFloat) i;
+    }
+}
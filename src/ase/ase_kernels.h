@@ -0,0 +1,51 @@
+/*
+    Analog sound emulation library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#ifndef ASE_KERNELS_H_
+#define ASE_KERNELS_H_
+
+#include "ase.h"
+
+/*
+    Block kernels shared by the linear nodes.
+
+    The one-pole filter is written in a look-ahead form that computes four
+    outputs from the state of the previous block: the only serial dependency
+    left is one multiply-add per block instead of one per sample, and the
+    remaining work can be vectorized by the compiler. Higher order filters
+    are split into second order sections, which keep their state in registers
+    and are accurate enough to run in single precision.
+*/
+class AKernel
+{
+public:
+    // dst[i] = src[i] * gain
+    static void scale( AFloat * dst, const AFloat * src, unsigned len, AFloat gain );
+
+    // dst[i] += src[i] * gain
+    static void mix( AFloat * dst, const AFloat * src, unsigned len, AFloat gain );
+
+    // y = a*x + b*y, y carries the filter state across calls
+    static void onePole( AFloat * dst, const AFloat * src, unsigned len, AFloat a, AFloat b, AFloat & y );
+
+    /*
+        Second order section (biquad), direct form I:
+
+        y[n] = c0*x[n] + c1*x[n-1] + c2*x[n-2] + c3*y[n-1] + c4*y[n-2]
+
+        Input is scaled by gain before filtering, state is { x[n-1], x[n-2],
+        y[n-1], y[n-2] }. Source and destination may be the same buffer, so
+        that sections can be cascaded in place.
+    */
+    static void biquad( AFloat * dst, const AFloat * src, unsigned len, AFloat gain, const AFloat * c, AFloat * state );
+
+    // dst[i] = value
+    static void fill( AFloat * dst, unsigned len, AFloat value );
+
+    // dst[i] = start + i*step
+    static void ramp( AFloat * dst, unsigned len, AFloat start, AFloat step );
+};
+
+#endif // ASE_KERNELS_H_
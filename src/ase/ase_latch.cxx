@@ -3,9 +3,12 @@
 
     Copyright (c) 2004 Alessandro Scotti
 */
+#include <emu/emu_state.h>
+
 #include "ase_latch.h"
 
-ALatch::ALatch( AFloat value )
+ALatch::ALatch( AContext & context, AFloat value )
+    : AChannel( context )
 {
     value_ = value;
 }
@@ -18,3 +21,10 @@ void ALatch::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
         len--;
     }
 }
+
+void ALatch::serialize( TStateStream & state )
+{
+    AChannel::serialize( state );
+
+    state.value( value_ );
+}
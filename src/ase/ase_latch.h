@@ -11,15 +11,24 @@
 class ALatch : public AChannel
 {
 public:
-    ALatch( AFloat value = 0 );
+    ALatch( AContext & context, AFloat value = 0 );
 
     void setValue( AFloat value ) {
-        value_ = value;
+        if( value != value_ ) {
+            value_ = value;
+            invalidate();
+        }
     }
 
+    virtual void serialize( TStateStream & state );
+
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual bool isSteady() {
+        return true;
+    }
+
 private:
     AFloat value_;
 };
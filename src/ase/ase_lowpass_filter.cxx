@@ -3,6 +3,9 @@
 
     Copyright (c) 2004 Alessandro Scotti
 */
+#include <emu/emu_state.h>
+
+#include "ase_kernels.h"
 #include "ase_lowpass_filter.h"
 
 ALowPassRCFilter::ALowPassRCFilter( AChannel & source, AFloat r, AFloat c )
@@ -11,25 +14,43 @@ ALowPassRCFilter::ALowPassRCFilter( AChannel & source, AFloat r, AFloat c )
     r_ = r;
     c_ = c;
 
-    AFloat d = r_ * c_ * ASE::samplingRate;
+    setCoefficients();
+
+    y_ = 0;
+    x_ = 0;
+}
 
-    b_ = exp( -1.0 / d );
+void ALowPassRCFilter::setCoefficients()
+{
+    b_ = context().getRCFactor( r_, c_ );
     a_ = 1.0 - b_;
+}
 
-    y_ = 0;
+void ALowPassRCFilter::onSamplingRateChanged()
+{
+    setCoefficients();
 }
 
 void ALowPassRCFilter::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
 {
     source().updateTo( ofs );
 
-    AFloat * src = source().stream() + streamSize();
-
-    while( len > 0 ) {
-        y_ = a_ * (*src++) + b_ * y_;
+    filter( buf, source().stream() + streamSize(), len );
+}
 
-        *buf++ = y_;
+void ALowPassRCFilter::filter( AFloat * buf, const AFloat * src, unsigned len )
+{
+    if( len > 0 ) {
+        x_ = src[len-1];
 
-        len--;
+        AKernel::onePole( buf, src, len, a_, b_, y_ );
     }
 }
+
+void ALowPassRCFilter::serialize( TStateStream & state )
+{
+    AFilter::serialize( state );
+
+    state.value( y_ );
+    state.value( x_ );
+}
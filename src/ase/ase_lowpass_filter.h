@@ -16,17 +16,35 @@ public:
 
     void setCharge( AFloat y ) {
         y_ = y;
+        invalidate();
     }
 
+    virtual bool isSimpleFilter() {
+        return true;
+    }
+
+    virtual void filter( AFloat * buf, const AFloat * src, unsigned len );
+
+    virtual void serialize( TStateStream & state );
+
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual void onSamplingRateChanged();
+
+    virtual bool isSteady() {
+        return isSettled( y_ - x_ );
+    }
+
 private:
+    void setCoefficients();
+
     AFloat r_;
     AFloat c_;
     AFloat a_;
     AFloat b_;
     AFloat y_;
+    AFloat x_;  // Last input
 };
 
 #endif // ASE_LOWPASS_FILTER_H_
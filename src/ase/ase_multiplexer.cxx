@@ -3,9 +3,13 @@
 
     Copyright (c) 2004 Alessandro Scotti
 */
+#include <emu/emu_state.h>
+
+#include "ase_kernels.h"
 #include "ase_multiplexer.h"
 
-AMultiplexer::AMultiplexer()
+AMultiplexer::AMultiplexer( AContext & context )
+    : AChannel( context )
 {
     channel_count_ = 0;
 }
@@ -17,6 +21,8 @@ void AMultiplexer::addChannel( AChannel * channel, AFloat level )
         channel_level_[ channel_count_ ] = level;
 
         channel_count_++;
+
+        invalidate();
     }
 }
 
@@ -31,22 +37,18 @@ void AMultiplexer::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
         }
 
         // Copy first channel into buffer
-        unsigned n;
-        AFloat * src = channel_[0]->stream() + streamSize();
-        AFloat * dst = buf;
-
-        for( n=0; n<len; n++ ) {
-            *dst++ = channel_level_[0] * (*src++);
-        }
+        AKernel::scale( buf, channel_[0]->stream() + streamSize(), len, channel_level_[0] );
 
         // Mix all other channels
         for( i=1; i<channel_count_; i++ ) {
-            AFloat * src = channel_[i]->stream() + streamSize();
-            AFloat * dst = buf;
-
-            for( n=0; n<len; n++ ) {
-                *dst++ += channel_level_[i] * (*src++);
-            }
+            AKernel::mix( buf, channel_[i]->stream() + streamSize(), len, channel_level_[i] );
         }
     }
 }
+
+void AMultiplexer::serialize( TStateStream & state )
+{
+    AChannel::serialize( state );
+
+    state.bytes( channel_level_, sizeof(channel_level_[0]) * channel_count_ );
+}
@@ -11,13 +11,27 @@
 class AMultiplexer : public AChannel
 {
 public:
-    AMultiplexer();
+    AMultiplexer( AContext & context );
 
     void addChannel( AChannel * channel, AFloat level );
 
+    virtual void serialize( TStateStream & state );
+
+    virtual unsigned inputCount() {
+        return channel_count_;
+    }
+
+    virtual AChannel * input( unsigned index ) {
+        return channel_[ index ];
+    }
+
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual bool isSteady() {
+        return true;
+    }
+
 private:
     enum {
         MaxChannels = 8
@@ -3,10 +3,14 @@
 
     Copyright (c) 2004 Alessandro Scotti
 */
+#include <emu/emu_state.h>
+
 #include "ase_noise.h"
 
-AWhiteNoise::AWhiteNoise()
+AWhiteNoise::AWhiteNoise( AContext & context )
+    : AChannel( context )
 {
+    frequency_ = 0;
     t_ = 0;
     t_step_ = 1;
     t_half_period_ = 0;
@@ -16,10 +20,12 @@ AWhiteNoise::AWhiteNoise()
     setTapMask( 0x30009 );
 }
 
-AWhiteNoise::AWhiteNoise( AFloat frequency )
+AWhiteNoise::AWhiteNoise( AContext & context, AFloat frequency )
+    : AChannel( context )
 {
+    frequency_ = frequency;
     t_ = 0;
-    t_step_ = 1.0 / ASE::samplingRate;
+    t_step_ = 1.0 / context.samplingRate();
     t_half_period_ = (1 / frequency) / 2;
 
     setOutput( 1, 0 );
@@ -27,6 +33,13 @@ AWhiteNoise::AWhiteNoise( AFloat frequency )
     setTapMask( 0x30009 );
 }
 
+void AWhiteNoise::onSamplingRateChanged()
+{
+    if( frequency_ > 0 ) {
+        t_step_ = 1.0 / context().samplingRate();
+    }
+}
+
 void AWhiteNoise::setValue( unsigned value )
 {
     value_ = value;
@@ -71,3 +84,15 @@ void AWhiteNoise::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
         len--;
     }
 }
+
+void AWhiteNoise::serialize( TStateStream & state )
+{
+    AChannel::serialize( state );
+
+    state.value( value_ );
+    state.value( tap_mask_ );
+    state.value( o_hi_ );
+    state.value( o_lo_ );
+    state.value( t_ );
+    state.value( output_ );
+}
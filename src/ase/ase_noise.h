@@ -11,9 +11,9 @@
 class AWhiteNoise : public AChannel
 {
 public:
-    AWhiteNoise();
+    AWhiteNoise( AContext & context );
 
-    AWhiteNoise( AFloat frequency );
+    AWhiteNoise( AContext & context, AFloat frequency );
 
     void setValue( unsigned value );
 
@@ -21,10 +21,15 @@ public:
 
     void setOutput( AFloat hi, AFloat lo );
 
+    virtual void serialize( TStateStream & state );
+
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual void onSamplingRateChanged();
+
 private:
+    AFloat frequency_;  // Zero if the output changes at every sample
     unsigned value_;
     unsigned tap_mask_;
     AFloat o_hi_;
@@ -38,8 +38,11 @@ void AOpAmp_NonInv1::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
 {
     source().updateTo( ofs );
 
-    AFloat * src = source().stream() + streamSize();
+    filter( buf, source().stream() + streamSize(), len );
+}
 
+void AOpAmp_NonInv1::filter( AFloat * buf, const AFloat * src, unsigned len )
+{
     while( len > 0 ) {
         *buf = (*src - a_) / b_;
 
@@ -32,9 +32,19 @@ class AOpAmp_NonInv1 : public AFilter
 public:
     AOpAmp_NonInv1( AChannel & source, AFloat r1, AFloat r2, AFloat r3, AFloat vcc );
 
+    virtual bool isSimpleFilter() {
+        return true;
+    }
+
+    virtual void filter( AFloat * buf, const AFloat * src, unsigned len );
+
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual bool isSteady() {
+        return true;
+    }
+
 private:
     AFloat r1_;
     AFloat r2_;
@@ -14,9 +14,21 @@ class ASwitch : public AFilter
 public:
     ASwitch( AChannel & source, AChannel & control );
 
+    virtual unsigned inputCount() {
+        return 2;
+    }
+
+    virtual AChannel * input( unsigned index ) {
+        return (index == 0) ? &source() : &control_;
+    }
+
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual bool isSteady() {
+        return true;
+    }
+
 private:
     AChannel & control_;
 };
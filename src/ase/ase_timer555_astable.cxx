@@ -3,9 +3,19 @@
 
     Copyright (c) 2004 Alessandro Scotti
 */
+#include <emu/emu_blep.h>
+#include <emu/emu_state.h>
+
+#include "ase_kernels.h"
 #include "ase_timer555_astable.h"
 
-ATimer555Astable::ATimer555Astable( AFloat ra, AFloat rb, AFloat c )
+// Shortest time constant (in samples) the timer is rendered with: a zero
+// resistance would otherwise give a zero period, and the edges of the closed
+// form renderer would never move past the end of the block
+const double MinTimeConstant = 1.0;
+
+ATimer555Astable::ATimer555Astable( AContext & context, AFloat ra, AFloat rb, AFloat c )
+    : AChannel( context )
 {
     c_ = c;
     ra_ = ra;
@@ -16,6 +26,7 @@ ATimer555Astable::ATimer555Astable( AFloat ra, AFloat rb, AFloat c )
     flipflop_ = 1;  // Charging
     reset_ = false;
     control_ = 0;
+    blep_carry_ = 0;
     
     setVcc( 5.0 );
     setVin( vcc_ );
@@ -54,21 +65,29 @@ void ATimer555Astable::setControl( AChannel * control, AFloat level )
 
 void ATimer555Astable::setCapacitorCoefficients()
 {
-    AFloat d;
-
     // Charging
-    d = c_ * (ra_ + rb_) * ASE::samplingRate;
-    b0_ = (AFloat) exp( -1.0 / d );
+    tau0_ = c_ * (ra_ + rb_) * context().samplingRate();
+    if( tau0_ < MinTimeConstant ) tau0_ = MinTimeConstant;
+    b0_ = (AFloat) exp( -1.0 / tau0_ );
     a0_ = (AFloat) 1.0 - b0_;
 
     // Discharging
-    d = c_ * rb_ * ASE::samplingRate;
-    b1_ = (AFloat) exp( -1.0 / d );
-    a1_ = (AFloat) 1.0 - a0_;
+    tau1_ = c_ * rb_ * context().samplingRate();
+    if( tau1_ < MinTimeConstant ) tau1_ = MinTimeConstant;
+    b1_ = (AFloat) exp( -1.0 / tau1_ );
+}
+
+void ATimer555Astable::onSamplingRateChanged()
+{
+    setCapacitorCoefficients();
 }
 
 void ATimer555Astable::setReset( bool reset )
 {
+    if( reset != reset_ ) {
+        invalidate();
+    }
+
     reset_ = reset;
 
     if( reset ) {
@@ -78,77 +97,192 @@ void ATimer555Astable::setReset( bool reset )
     }
 }
 
-void ATimer555Astable::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
+// Returns the time (in samples) until the capacitor reaches the next threshold
+double ATimer555Astable::timeToThreshold( int charging, double v ) const
 {
-    // Update control if defined (regardless of whether we're using it or not)
-    if( control_ != 0 ) {
-        control_->updateTo( ofs );
+    if( charging ) {
+        // Charging towards Vin
+        if( v >= threshold_hi_ ) {
+            return 0;
+        }
+
+        if( vin_ <= threshold_hi_ ) {
+            return 1e30; // Never
+        }
+
+        return tau0_ * log( (vin_ - v) / (vin_ - threshold_hi_) );
     }
 
-    if( reset_ ) {
-        // If reset, output is always low
-        while( len > 0 ) {
-            *buf++ = out_lo_;
+    // Discharging towards ground
+    if( v <= threshold_lo_ ) {
+        return 0;
+    }
 
-            len--;
-        }
+    if( threshold_lo_ <= 0 ) {
+        return 1e30; // Never
     }
-    else if( control_ == 0 ) {
-        // Threshold points are fixed (set by resistors)
-        while( len > 0 ) {
-            if( flipflop_ ) {
-                *buf++ = out_hi_;
 
-                // Capacitor is charging
-                c_voltage_ = a0_ * vin_ + b0_ * c_voltage_;
+    return tau1_ * log( v / threshold_lo_ );
+}
 
-                if( c_voltage_ >= threshold_hi_ ) {
-                    flipflop_ = 0;
-                }
-            }
-            else {
-                *buf++ = out_lo_;
+// Returns the capacitor voltage after t samples in the current state
+double ATimer555Astable::advance( int charging, double v, double t ) const
+{
+    if( charging ) {
+        return vin_ + (v - vin_) * exp( -t / tau0_ );
+    }
+
+    return v * exp( -t / tau1_ );
+}
 
-                // Capacitor is discharging
-                c_voltage_ = b1_ * c_voltage_;
+void ATimer555Astable::updateFixed( AFloat * buf, unsigned len )
+{
+    // Once started from a threshold, each state lasts a fixed time
+    double period[2] = {
+        timeToThreshold( 0, threshold_hi_ ),
+        timeToThreshold( 1, threshold_lo_ )
+    };
 
-                if( c_voltage_ <= threshold_lo_ ) {
-                    flipflop_ = 1;
-                }
-            }
+    AFloat pending = blep_carry_;
+    double v = c_voltage_;  // Voltage at time t (last transition)
+    double t = 0;
+    double edge = timeToThreshold( flipflop_, v );
+    unsigned pos = 0;
+
+    while( pos < len ) {
+        AFloat out = flipflop_ ? out_hi_ : out_lo_;
+
+        if( edge >= len ) {
+            // No transition left in this block
+            AKernel::fill( buf + pos, len - pos, out );
+            buf[pos] += pending;
+            pending = 0;
+            break;
+        }
+
+        // Output holds until the first sample after the crossing
+        unsigned next = (unsigned) ceil( edge );
+
+        if( next > pos ) {
+            AKernel::fill( buf + pos, next - pos, out );
+            buf[pos] += pending;
+            pending = 0;
+        }
 
-            len--;
+        // Flip and restart from the threshold voltage
+        v = flipflop_ ? threshold_hi_ : threshold_lo_;
+        t = edge;
+        flipflop_ = 1 - flipflop_;
+
+        AFloat h = (flipflop_ ? out_hi_ : out_lo_) - out;
+        AFloat x = (AFloat) (next - edge);
+
+        if( next > 0 ) {
+            buf[next-1] += h * TBlep::before( x - 1 );
         }
+        pending += h * TBlep::after( x );
+
+        edge += period[flipflop_];
+        pos = next;
     }
-    else {
-        // Threshold points are set externally by control voltage
-        AFloat * ctl = control_->stream() + streamSize();
 
-        while( len > 0 ) {
-            AFloat level = *ctl++ * control_level_;
+    c_voltage_ = (AFloat) advance( flipflop_, v, len - t );
+    blep_carry_ = pending;
+}
+
+void ATimer555Astable::updateControlled( AFloat * buf, unsigned len, const AFloat * ctl )
+{
+    AFloat v = c_voltage_;
+    AFloat pending = blep_carry_;
 
-            if( flipflop_ ) {
-                *buf++ = out_hi_;
+    for( unsigned i=0; i<len; i++ ) {
+        AFloat level = ctl[i] * control_level_;
+        AFloat out = flipflop_ ? out_hi_ : out_lo_;
+        AFloat t;
 
-                // Capacitor is charging
-                c_voltage_ = a0_ * vin_ + b0_ * c_voltage_;
+        buf[i] = out + pending;
+        pending = 0;
 
-                if( c_voltage_ >= level ) {
-                    flipflop_ = 0;
-                }
+        if( flipflop_ ) {
+            // Capacitor is charging
+            AFloat w = a0_ * vin_ + b0_ * v;
+
+            if( w < level ) {
+                v = w;
+                continue;
             }
-            else {
-                *buf++ = out_lo_;
 
-                // Capacitor is discharging
-                c_voltage_ = b1_ * c_voltage_;
+            // Crossed the upper threshold during this sample, discharge for the rest of it
+            t = (v >= level) ? 0 : (AFloat) (tau0_ * log( (vin_ - v) / (vin_ - level) ));
+            t = (t < 1) ? t : 1;
+            v = (AFloat) (level * exp( -(1 - t) / tau1_ ));
+            flipflop_ = 0;
+        }
+        else {
+            // Capacitor is discharging
+            AFloat w = b1_ * v;
 
-                if( c_voltage_ <= (level / 2) ) {
-                    flipflop_ = 1;
-                }
+            if( w > level / 2 ) {
+                v = w;
+                continue;
             }
 
-            len--;
+            // Crossed the lower threshold during this sample, charge for the rest of it
+            t = (v <= level / 2) ? 0 : (AFloat) (tau1_ * log( v / (level / 2) ));
+            t = (t < 1) ? t : 1;
+            v = (AFloat) (vin_ + (level / 2 - vin_) * exp( -(1 - t) / tau0_ ));
+            flipflop_ = 1;
         }
+
+        // The new state shows from the next sample on
+        AFloat h = (flipflop_ ? out_hi_ : out_lo_) - out;
+
+        buf[i] += h * TBlep::before( -t );
+        pending = h * TBlep::after( 1 - t );
+    }
+
+    c_voltage_ = v;
+    blep_carry_ = pending;
+}
+
+void ATimer555Astable::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
+{
+    // Update control if defined (regardless of whether we're using it or not)
+    if( control_ != 0 ) {
+        control_->updateTo( ofs );
+    }
+
+    if( reset_ ) {
+        // If reset, output is always low
+        AKernel::fill( buf, len, out_lo_ );
+        blep_carry_ = 0;
+    }
+    else if( control_ == 0 ) {
+        // Threshold points are fixed (set by resistors)
+        updateFixed( buf, len );
+    }
+    else {
+        // Threshold points are set externally by control voltage
+        updateControlled( buf, len, control_->stream() + streamSize() );
+    }
+}
+
+void ATimer555Astable::serialize( TStateStream & state )
+{
+    AChannel::serialize( state );
+
+    state.value( ra_ );
+    state.value( vcc_ );
+    state.value( vin_ );
+    state.value( threshold_hi_ );
+    state.value( threshold_lo_ );
+    state.value( control_level_ );
+    state.value( flipflop_ );
+    state.value( reset_ );
+    state.value( c_voltage_ );
+    state.value( blep_carry_ );
+
+    if( state.isLoading() ) {
+        setCapacitorCoefficients();
     }
 }
@@ -28,11 +28,18 @@
 
     (*) if control line not specified, 5 is grounded by default.
 
+    With fixed thresholds the capacitor voltage follows a closed-form
+    exponential between crossings, so the time of the next crossing is
+    computed directly and the output is filled a whole run at a time. With
+    a control voltage the thresholds move every sample and the capacitor is
+    still stepped per sample, but the crossing time within the sample is
+    solved analytically. In both cases the output transitions are rendered
+    as band-limited steps, placed at their exact fractional position.
 */
 class ATimer555Astable : public AChannel
 {
 public:
-    ATimer555Astable( AFloat ra, AFloat rb, AFloat c );
+    ATimer555Astable( AContext & context, AFloat ra, AFloat rb, AFloat c );
 
     void setRa( AFloat ra );
 
@@ -57,6 +64,16 @@ public:
 
     void setControl( AChannel * control, AFloat level );
 
+    virtual void serialize( TStateStream & state );
+
+    virtual unsigned inputCount() {
+        return (control_ != 0) ? 1 : 0;
+    }
+
+    virtual AChannel * input( unsigned index ) {
+        return control_;
+    }
+
     void setControl( AChannel * control, AFloat r1, AFloat r2 ) {
         setControl( control, r2 / (r1+r2) );
     }
@@ -68,9 +85,28 @@ public:
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual void onSamplingRateChanged();
+
+    // Output is fixed while the device is reset
+    virtual bool isSteady() {
+        return reset_;
+    }
+
+    virtual bool dependsOnInput( unsigned index ) {
+        return ! reset_;
+    }
+
 private:
     void setCapacitorCoefficients();
 
+    double timeToThreshold( int charging, double v ) const;
+
+    double advance( int charging, double v, double t ) const;
+
+    void updateFixed( AFloat * buf, unsigned len );
+
+    void updateControlled( AFloat * buf, unsigned len, const AFloat * ctl );
+
     AFloat ra_;
     AFloat rb_;
     AFloat c_;
@@ -91,8 +127,10 @@ private:
 
     AFloat a0_;
     AFloat b0_;
-    AFloat a1_;
     AFloat b1_;
+    double tau0_;       // Charge time constant (in samples)
+    double tau1_;       // Discharge time constant (in samples)
+    AFloat blep_carry_; // Step correction pending for the next sample
 };
 
 #endif // ASE_TIMER555_ASTABLE_H_
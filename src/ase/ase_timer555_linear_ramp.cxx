@@ -3,15 +3,21 @@
 
     Copyright (c) 2004 Alessandro Scotti
 */
+#include <emu/emu_blep.h>
+#include <emu/emu_state.h>
+
+#include "ase_kernels.h"
 #include "ase_timer555_linear_ramp.h"
 
-ATimer555LinearRamp::ATimer555LinearRamp( AFloat c )
+ATimer555LinearRamp::ATimer555LinearRamp( AContext & context, AFloat c )
+    : AChannel( context )
 {
     c_ = c;
     c_voltage_ = 0; // Initial charge
     flipflop_ = 1;  // Charging
     current_ = 0;
-    c_dt_ = c * ASE::samplingRate;
+    blep_carry_ = 0;
+    c_dt_ = c * context.samplingRate();
     
     setVcc( 5.0 );
 }
@@ -23,11 +29,69 @@ void ATimer555LinearRamp::setVcc( AFloat vcc )
     threshold_hi_ = threshold_lo_ * 2;
 }
 
+void ATimer555LinearRamp::onSamplingRateChanged()
+{
+    c_dt_ = c_ * context().samplingRate();
+}
+
 void ATimer555LinearRamp::setCurrent( AChannel * current )
 {
     current_ = current;
 }
 
+// Fills a run with constant current, i.e. a ramp with the specified slope
+void ATimer555LinearRamp::updateRamp( AFloat * buf, unsigned len, AFloat step )
+{
+    unsigned pos = 0;
+
+    while( pos < len ) {
+        // Should check for zero voltage: for now, this check
+        // must be performed somewhere else (i.e. when setting the
+        // controlling current)
+        AFloat edge = (step > 0) ? pos + (threshold_hi_ - c_voltage_) / step : len;
+
+        if( edge < pos ) {
+            // Already above threshold (e.g. after a change of Vcc)
+            edge = (AFloat) pos;
+        }
+
+        if( edge >= len ) {
+            AKernel::ramp( buf + pos, len - pos, c_voltage_, step );
+            buf[pos] += blep_carry_;
+            blep_carry_ = 0;
+            c_voltage_ += step * (len - pos);
+            break;
+        }
+
+        unsigned next = (unsigned) ceil( edge );
+
+        if( next > pos ) {
+            AKernel::ramp( buf + pos, next - pos, c_voltage_, step );
+            buf[pos] += blep_carry_;
+            blep_carry_ = 0;
+        }
+
+        // For practical purposes, we can assume voltage drop instantaneously
+        // (actually it will take 25-30 microseconds or so)
+        AFloat h = threshold_lo_ - threshold_hi_;
+        AFloat x = next - edge;
+
+        if( next > 0 ) {
+            buf[next-1] += h * TBlep::before( x - 1 );
+        }
+        blep_carry_ += h * TBlep::after( x );
+
+        c_voltage_ = threshold_lo_ + step * x;
+
+        if( c_voltage_ >= threshold_hi_ ) {
+            // More than one cycle per sample, just keep the phase
+            c_voltage_ = threshold_lo_ + (AFloat) fmod( c_voltage_ - threshold_lo_, -h );
+        }
+
+        pos = next;
+    }
+}
+
 void ATimer555LinearRamp::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
 {
     assert( current_ != 0 );
@@ -35,23 +99,30 @@ void ATimer555LinearRamp::updateBuffer( AFloat * buf, unsigned len, unsigned ofs
     current_->updateTo( ofs );
 
     AFloat * ctl = current_->stream() + streamSize();
+    unsigned pos = 0;
 
-    while( len > 0 ) {
-        *buf++ = c_voltage_;
+    while( pos < len ) {
+        // Find the run of samples with the same current
+        unsigned end = pos + 1;
 
-        AFloat s = *ctl++ / c_dt_;
-
-        // Should check for zero voltage: for now, this check
-        // must be performed somewhere else (i.e. when setting the
-        // controlling current)
-        c_voltage_ += s;
-
-        if( c_voltage_ >= threshold_hi_ ) {
-            // For practical purposes, we can assume voltage drop instantaneously
-            // (actually it will take 25-30 microseconds or so)
-            c_voltage_ = threshold_lo_;
+        while( (end < len) && (ctl[end] == ctl[pos]) ) {
+            end++;
         }
 
-        len--;
+        updateRamp( buf + pos, end - pos, ctl[pos] / c_dt_ );
+
+        pos = end;
     }
 }
+
+void ATimer555LinearRamp::serialize( TStateStream & state )
+{
+    AChannel::serialize( state );
+
+    state.value( vcc_ );
+    state.value( threshold_hi_ );
+    state.value( threshold_lo_ );
+    state.value( flipflop_ );
+    state.value( c_voltage_ );
+    state.value( blep_carry_ );
+}
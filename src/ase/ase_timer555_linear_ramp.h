@@ -14,16 +14,31 @@
     Although this is still an astable setup, here the capacitor doesn't follow the
     usual charge/discharge path using resistors but is charged thru a current
     source (typically, a transistor).
+
+    The current is normally held by a latch, so the output is computed a run
+    of constant current at a time: each run is a straight ramp, and the
+    drops at the upper threshold are placed at their exact crossing time and
+    rendered as band-limited steps.
 */
 class ATimer555LinearRamp : public AChannel
 {
 public:
-    ATimer555LinearRamp( AFloat c );
+    ATimer555LinearRamp( AContext & context, AFloat c );
 
     void setVcc( AFloat vcc );
 
     void setCurrent( AChannel * current );
 
+    virtual void serialize( TStateStream & state );
+
+    virtual unsigned inputCount() {
+        return (current_ != 0) ? 1 : 0;
+    }
+
+    virtual AChannel * input( unsigned index ) {
+        return current_;
+    }
+
     void dischargeCapacitor() {
         c_voltage_ = 0;
     }
@@ -31,9 +46,13 @@ public:
 protected:
     virtual void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual void onSamplingRateChanged();
+
 private:
     void setCapacitorCoefficients();
 
+    void updateRamp( AFloat * buf, unsigned len, AFloat step );
+
     AFloat c_;
     AFloat vcc_;
     AFloat threshold_hi_;
@@ -45,6 +64,7 @@ private:
     int flipflop_;
 
     AFloat c_voltage_;  // Voltage across capacitor
+    AFloat blep_carry_; // Step correction pending for the next sample
 };
 
 #endif // ASE_TIMER555_LINEAR_RAMP_H_
@@ -3,6 +3,8 @@
 
     Copyright (c) 2004 Alessandro Scotti
 */
+#include <emu/emu_state.h>
+
 #include "ase_triangle_wave_vco1.h"
 
 /*
@@ -30,10 +32,14 @@
     I have used a "Spice" program to simulate the circuits, followed by a semi-manual
     regression to correlate the output values of the two oscillators.
 */
-ATriangleWaveVCO::ATriangleWaveVCO( double rampTime1, double rampTime2, double vcoControl )
+ATriangleWaveVCO::ATriangleWaveVCO( AContext & context, double rampTime1, double rampTime2, double vcoControl )
+    : context_(context)
 {
-    wf1_period_[0] = rampTime1 * ASE::samplesPerMs;
-    wf1_period_[1] = rampTime2 * ASE::samplesPerMs;
+    ramp_time_[0] = rampTime1;
+    ramp_time_[1] = rampTime2;
+    sampling_rate_ = 0;
+    
+    updatePeriods();
     
     vco_control_ = vcoControl;
     
@@ -42,19 +48,32 @@ ATriangleWaveVCO::ATriangleWaveVCO( double rampTime1, double rampTime2, double v
     stop();
 }
 
+void ATriangleWaveVCO::updatePeriods()
+{
+    // Periods are expressed in samples, recompute them if the sampling rate has changed
+    if( sampling_rate_ != context_.samplingRate() ) {
+        sampling_rate_ = context_.samplingRate();
+        
+        wf1_period_[0] = ramp_time_[0] * context_.samplesPerMs();
+        wf1_period_[1] = ramp_time_[1] * context_.samplesPerMs();
+    }
+}
+
 void ATriangleWaveVCO::play( double stopTime, double fadeTime )
 {
+    updatePeriods();
+    
     stopped_ = false;
     
-    stopCount_ = (int) ((AFloat) ASE::samplingRate * stopTime);
-    fadeCount_ = (int) ((AFloat) ASE::samplingRate * fadeTime);
+    stopCount_ = (int) ((AFloat) context_.samplingRate() * stopTime);
+    fadeCount_ = (int) ((AFloat) context_.samplingRate() * fadeTime);
     fadeOffset_ = 0;
 }
 
 void ATriangleWaveVCO::fade( double fadeTime )
 {
     stopCount_ = 0;
-    fadeCount_ = (int) ((AFloat) ASE::samplingRate * fadeTime);
+    fadeCount_ = (int) ((AFloat) context_.samplingRate() * fadeTime);
     fadeOffset_ = 0;
 }
 
@@ -99,7 +118,7 @@ void ATriangleWaveVCO::mix( int * buf, int len )
         }
         
         // Update second (VCO) oscillator
-        double p2 = ASE::samplesPerMs * (vco_control_ / pow(vout_[0], 1.1 )); // Obtained by simulation and then regression
+        double p2 = context_.samplesPerMs() * (vco_control_ / pow(vout_[0], 1.1 )); // Obtained by simulation and then regression
         double s2 = 8.5 / p2; // Step, 8.5 is the amplitude of the second oscillator output (min=0.5, max=9.0)
         
         if( asc_ ) { // Ascending
@@ -129,3 +148,17 @@ void ATriangleWaveVCO::mix( int * buf, int len )
         }
     }
 }
+
+void ATriangleWaveVCO::serialize( TStateStream & state )
+{
+    state.value( wf1_period_index_ );
+    state.value( o_ );
+    state.value( p_ );
+    state.value( step_ );
+    state.bytes( vout_, sizeof(vout_) );
+    state.value( asc_ );
+    state.value( stopCount_ );
+    state.value( fadeCount_ );
+    state.value( fadeOffset_ );
+    state.value( stopped_ );
+}
@@ -8,9 +8,11 @@
 
 #include "ase.h"
 
+class TStateStream;
+
 struct ATriangleWaveVCO
 {
-    ATriangleWaveVCO( double rampTime1, double rampTime2, double vcoControl );
+    ATriangleWaveVCO( AContext & context, double rampTime1, double rampTime2, double vcoControl );
     
     void play( double toTime = 0, double fadeTime = 0 );
     
@@ -24,6 +26,13 @@ struct ATriangleWaveVCO
         return stopped_;
     }
     
+    void updatePeriods();
+
+    void serialize( TStateStream & state );
+    
+    AContext & context_;
+    unsigned sampling_rate_;
+    double ramp_time_[2];
     double wf1_period_[2];
     int wf1_period_index_;
     double gain_;
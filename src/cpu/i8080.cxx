@@ -3,6 +3,8 @@
 
     Copyright (c) 1996-2003,2004 Alessandro Scotti
 */
+#include <emu/emu_state.h>
+
 #include "i8080.h"
 
 I8080::I8080( I8080Environment & env )
@@ -109,3 +111,13 @@ void I8080::interrupt( unsigned char opcode )
         t_cycles_ += cycles_;
     }
 }
+
+void I8080::serialize( TStateStream & state )
+{
+    state.value( B ); state.value( C ); state.value( D ); state.value( E );
+    state.value( H ); state.value( L ); state.value( A ); state.value( F );
+    state.value( PC );
+    state.value( SP );
+    state.value( iflags_ );
+    state.value( t_cycles_ );
+}
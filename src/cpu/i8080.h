@@ -6,6 +6,8 @@
 #ifndef I8080_H_
 #define I8080_H_
 
+class TStateStream;
+
 /**
     Environment for the I8080 CPU emulator.
 
@@ -247,6 +249,9 @@ public:
         t_cycles_ = value;
     }
 
+    /** Saves or loads the CPU registers and cycle counter. */
+    void serialize( TStateStream & state );
+
 protected:
     /* 
         Implementation of opcodes 0x00 to 0xFF.
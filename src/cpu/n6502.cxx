@@ -3,6 +3,8 @@
 
     Copyright (c) 2011 Alessandro Scotti
 */
+#include <emu/emu_state.h>
+
 #include "n6502.h"
 
 N6502::N6502( N6502Environment & env )
@@ -93,3 +95,14 @@ void N6502::interrupt( int type )
         t_cycles_ += cycles_;
     }
 }
+
+void N6502::serialize( TStateStream & state )
+{
+    state.value( A );
+    state.value( X );
+    state.value( Y );
+    state.value( F );
+    state.value( S );
+    state.value( PC );
+    state.value( t_cycles_ );
+}
@@ -6,6 +6,8 @@
 #ifndef N6502_H_
 #define N6502_H_
 
+class TStateStream;
+
 /**
     Environment for the N6502 CPU emulator.
 
@@ -225,6 +227,9 @@ public:
         t_cycles_ = value;
     }
 
+    /** Saves or loads the CPU registers and cycle counter. */
+    void serialize( TStateStream & state );
+
 protected:
     /* 
         Implementation of opcodes 0x00 to 0xFF.
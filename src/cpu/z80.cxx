@@ -3,6 +3,8 @@
 
     Copyright (c) 1996-2003,2004 Alessandro Scotti
 */
+#include <emu/emu_state.h>
+
 #include "z80.h"
 
 /* Constructor */
@@ -19,6 +21,7 @@ void Z80::reset()
     I = 0;          // Interrupt register cleared
     R = 0;          // Memory refresh register cleared
     iflags_ = 0;    // IFF1 and IFF2 cleared, IM0 enabled
+    ei_pending_ = false;
     cycles_ = 0;
     t_cycles_ = 0;
 
@@ -160,3 +163,19 @@ void Z80::nmi()
     
     t_cycles_ += cycles_;
 }
+
+void Z80::serialize( TStateStream & state )
+{
+    state.value( B ); state.value( C ); state.value( D ); state.value( E );
+    state.value( H ); state.value( L ); state.value( A ); state.value( F );
+    state.value( B1 ); state.value( C1 ); state.value( D1 ); state.value( E1 );
+    state.value( H1 ); state.value( L1 ); state.value( A1 ); state.value( F1 );
+    state.value( IX );
+    state.value( IY );
+    state.value( PC );
+    state.value( SP );
+    state.value( I );
+    state.value( R );
+    state.value( iflags_ );
+    state.value( t_cycles_ );
+}
@@ -6,6 +6,8 @@
 #ifndef Z80_H_
 #define Z80_H_
 
+class TStateStream;
+
 /**
     Environment for Z80 emulation.
 
@@ -229,6 +231,9 @@ public:
         t_cycles_ = value;
     }
 
+    /** Saves or loads the CPU registers and cycle counter. */
+    void serialize( TStateStream & state );
+
 private:
     // Implementation of opcodes 0x00 to 0xFF
     void opcode_00();   // NOP
@@ -1411,6 +1416,7 @@ private:
     unsigned do_opcode_xycb( unsigned xy );
 
     unsigned    iflags_;    // Interrupt mode (bits 0 and 1) and flags
+    bool        ei_pending_;// True while executing the instruction that follows EI
     unsigned    cycles_;    // Number of CPU cycles spent in the current instruction
     unsigned    t_cycles_;  // Number of CPU cycles elapsed since last reset (or call to setCycles)
 
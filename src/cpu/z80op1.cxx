@@ -1786,15 +1786,13 @@ void Z80::opcode_fa()    // JP   M,nn
 
 void Z80::opcode_fb()    // EI
 {
-    static bool ei_pending = false;
-
-    if( ! ei_pending ) {
-        ei_pending = true;
+    if( ! ei_pending_ ) {
+        ei_pending_ = true;
 
         // Execute another instruction before enabling interrupts
         step();
 
-        ei_pending = false;
+        ei_pending_ = false;
     }
 
     iflags_ |= IFF1 | IFF2;
@@ -15,6 +15,7 @@
 #include "emu_initproxy.h"
 #include "emu_info.h"
 #include "emu_input.h"
+#include "emu_input_log.h"
 #include "emu_input_manager.h"
 #include "emu_iostream.h"
 #include "emu_joystick.h"
@@ -24,9 +25,14 @@
 #include "emu_math.h"
 #include "emu_png.h"
 #include "emu_registry.h"
+#include "emu_resource_loader.h"
+#include "emu_rewind.h"
 #include "emu_sample.h"
+#include "emu_scheduler.h"
+#include "emu_state.h"
 #include "emu_string.h"
 #include "emu_tickle_machine.h"
+#include "emu_worker.h"
 #include "emu_zipfile.h"
 
 #endif // EMU_H_
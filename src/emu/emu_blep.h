@@ -0,0 +1,34 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#ifndef EMU_BLEP_H_
+#define EMU_BLEP_H_
+
+/*
+    Polynomial band-limited step (BLEP) residual, shared by the sound chips
+    and the analog sound emulation library.
+
+    A step of height h at fractional time t0 is rendered by outputting the
+    naive step and adding h * before( t-t0 ) to the last sample before the
+    step and h * after( t-t0 ) to the first one after it (t being the sample
+    time). This removes most of the aliasing that otherwise shows up as
+    jitter at high frequencies.
+*/
+class TBlep
+{
+public:
+    template <class T> static T before( T x ) { // -1 <= x < 0
+        return x*x/2 + x + (T) 0.5;
+    }
+
+    template <class T> static T after( T x ) { // 0 <= x < 1
+        return x - x*x/2 - (T) 0.5;
+    }
+
+private:
+    TBlep();
+};
+
+#endif // EMU_BLEP_H_
@@ -69,3 +69,34 @@ void decodeCharSet( unsigned char * buf, const TDecodeCharInfo & info, const uns
         offset_bits += delta_bits;
     }
 }
+
+void transposeBits8x8( unsigned char * dst, const unsigned char * source, int step )
+{
+    unsigned long long m = 0;
+    unsigned long long t;
+    
+    for( int y=0; y<8; y++ ) {
+        m |= (unsigned long long) source[y*step] << (8*y);
+    }
+    
+    // Swap 1x1, 2x2 and 4x4 blocks (see "Hacker's Delight", 7-3)
+    t = (m ^ (m >> 7)) & 0x00AA00AA00AA00AAULL;
+    m ^= t ^ (t << 7);
+    t = (m ^ (m >> 14)) & 0x0000CCCC0000CCCCULL;
+    m ^= t ^ (t << 14);
+    t = (m ^ (m >> 28)) & 0x00000000F0F0F0F0ULL;
+    m ^= t ^ (t << 28);
+    
+    for( int x=0; x<8; x++ ) {
+        dst[x] = (unsigned char) (m >> (8*x));
+    }
+}
+
+void buildBitExpansionTable( unsigned char table[256][8], unsigned char value, bool msb_first )
+{
+    for( int i=0; i<256; i++ ) {
+        for( int x=0; x<8; x++ ) {
+            table[i][x] = (i & BitMask[msb_first ? 7-x : x]) ? value : 0;
+        }
+    }
+}
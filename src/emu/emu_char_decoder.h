@@ -34,4 +34,11 @@ void decodeChar8x8( unsigned char * buf, const TDecodeCharInfo8x8 & info, const
 
 void decodeCharSet8x8( unsigned char * buf, const TDecodeCharInfo8x8 & info, const unsigned char * source, int total, int delta );
 
+// Transpose a 8x8 bit matrix: bit x of the source byte y (read at source + y*step) becomes bit y of dst[x]
+void transposeBits8x8( unsigned char * dst, const unsigned char * source, int step );
+
+// Fill a lookup table that expands a byte into 8 pixels, each set to value if the corresponding bit is set
+// (pixel 0 is taken from bit 7 if msb_first is true, from bit 0 otherwise)
+void buildBitExpansionTable( unsigned char table[256][8], unsigned char value, bool msb_first );
+
 #endif // EMU_CHAR_DECODER_H_
@@ -19,12 +19,14 @@ class TFrame
     unsigned flags_; // Flags are mainly used for debugging
     unsigned stamp_;
     void * userData_;
+    bool headless_;
     
 public:
     TFrame() {
         flags_ = 0;
         stamp_ = 0;
         userData_ = 0;
+        headless_ = false;
     }
 
     /** Destructor. */
@@ -54,6 +56,19 @@ public:
     void * getUserData() const {
         return userData_;
     }
+    
+    /**
+        Marks the frame as headless: its video is discarded, so the machine
+        should not spend time rendering it (but must still run the sound,
+        which is part of the machine state).
+    */
+    void setHeadless( bool headless ) {
+        headless_ = headless;
+    }
+    
+    bool isHeadless() const {
+        return headless_;
+    }
 
     virtual void setVideo( TBitmap * screen, bool flipped = false ) = 0;
 
@@ -0,0 +1,124 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#include <string.h>
+
+#include "emu_input_log.h"
+#include "emu_machine.h"
+
+static const char LogSignature[4] = { 'T', 'I', 'L', 1 };
+
+TInputRecorder::TInputRecorder( TOutputStream * os, const char * driver ) : os_(os)
+{
+    frame_ = 0;
+    last_frame_ = 0;
+
+    unsigned len = (unsigned) strlen( driver );
+
+    os_->write( LogSignature, sizeof(LogSignature) );
+    writeCount( len );
+    os_->write( driver, len );
+}
+
+bool TInputRecorder::handleInputEvent( TMachine * machine, unsigned device, unsigned param )
+{
+    record( device, param );
+
+    return machine->handleInputEvent( device, param, 0 );
+}
+
+void TInputRecorder::record( unsigned device, unsigned param )
+{
+    writeCount( frame_ - last_frame_ );
+    writeCount( device );
+    writeCount( param );
+
+    last_frame_ = frame_;
+}
+
+void TInputRecorder::writeCount( unsigned n )
+{
+    char buf[8];
+    unsigned len = 0;
+
+    while( n >= 0x80 ) {
+        buf[len++] = (char) (n | 0x80);
+        n >>= 7;
+    }
+
+    buf[len++] = (char) n;
+
+    os_->write( buf, len );
+}
+
+TInputPlayer::TInputPlayer( TInputStream * is ) : is_(is)
+{
+    char signature[sizeof(LogSignature)];
+    unsigned len;
+
+    valid_ = false;
+    driver_[0] = '\0';
+    frame_ = 0;
+    pending_ = false;
+    event_frame_ = 0;
+
+    if( (is_->read( signature, sizeof(signature) ) != sizeof(signature)) || (memcmp( signature, LogSignature, sizeof(signature) ) != 0) ) {
+        return;
+    }
+
+    if( ! readCount( len ) || (len >= MaxDriverName) || (is_->read( driver_, len ) != len) ) {
+        return;
+    }
+
+    driver_[len] = '\0';
+    valid_ = true;
+
+    readEvent();
+}
+
+void TInputPlayer::play( TMachine * machine )
+{
+    while( pending_ && (event_frame_ == frame_) ) {
+        machine->handleInputEvent( event_device_, event_param_, 0 );
+
+        readEvent();
+    }
+
+    frame_++;
+}
+
+bool TInputPlayer::readCount( unsigned & n )
+{
+    unsigned shift = 0;
+
+    n = 0;
+
+    while( shift < 32 ) {
+        unsigned char b;
+
+        if( is_->read( &b, 1 ) != 1 ) {
+            break;
+        }
+
+        n |= (unsigned) (b & 0x7F) << shift;
+
+        if( (b & 0x80) == 0 ) {
+            return true;
+        }
+
+        shift += 7;
+    }
+
+    return false;
+}
+
+void TInputPlayer::readEvent()
+{
+    unsigned delta;
+
+    pending_ = readCount( delta ) && readCount( event_device_ ) && readCount( event_param_ );
+
+    event_frame_ += delta;
+}
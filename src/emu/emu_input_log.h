@@ -0,0 +1,120 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#ifndef EMU_INPUT_LOG_H_
+#define EMU_INPUT_LOG_H_
+
+#include "emu_iostream.h"
+
+class TMachine;
+
+/**
+    Records the input events sent to a machine, so that a game session can
+    be played back exactly (e.g. to benchmark or test real gameplay).
+
+    Every event is stored with the number of the frame it was sent before,
+    as a sequence of variable length integers: the frames elapsed since the
+    previous event, the device and the parameter. Joystick positions are
+    recorded as the events that carry them.
+*/
+class TInputRecorder
+{
+public:
+    /**
+        Constructor, writes the log header.
+
+        @param os stream that receives the log (not owned by the recorder)
+        @param driver name of the driver the input is recorded for
+    */
+    TInputRecorder( TOutputStream * os, const char * driver );
+
+    /** Records an event, then sends it to the machine. */
+    bool handleInputEvent( TMachine * machine, unsigned device, unsigned param );
+
+    /** Records an event for the current frame. */
+    void record( unsigned device, unsigned param );
+
+    /** Moves to the next frame (call once per frame, after running the machine). */
+    void nextFrame() {
+        frame_++;
+    }
+
+    /** Returns the number of frames recorded so far. */
+    unsigned frame() const {
+        return frame_;
+    }
+
+private:
+    TInputRecorder( const TInputRecorder & );
+    TInputRecorder & operator = ( const TInputRecorder & );
+
+    void writeCount( unsigned n );
+
+    TOutputStream * os_;
+    unsigned frame_;
+    unsigned last_frame_;   // Frame of the last recorded event
+};
+
+/**
+    Plays back the input events recorded by TInputRecorder.
+*/
+class TInputPlayer
+{
+public:
+    enum {
+        MaxDriverName = 64
+    };
+
+    /**
+        Constructor, reads the log header.
+
+        @param is stream that contains the log (not owned by the player)
+    */
+    TInputPlayer( TInputStream * is );
+
+    /** Returns false if the stream does not contain an input log. */
+    bool isValid() const {
+        return valid_;
+    }
+
+    /** Returns the name of the driver the input was recorded for. */
+    const char * driver() const {
+        return driver_;
+    }
+
+    /**
+        Sends the events of the current frame to the machine and moves to the next
+        frame (call once per frame, before running the machine).
+    */
+    void play( TMachine * machine );
+
+    /** Returns true when all the events have been played. */
+    bool isFinished() const {
+        return ! pending_;
+    }
+
+    /** Returns the number of frames played so far. */
+    unsigned frame() const {
+        return frame_;
+    }
+
+private:
+    TInputPlayer( const TInputPlayer & );
+    TInputPlayer & operator = ( const TInputPlayer & );
+
+    bool readCount( unsigned & n );
+    void readEvent();
+
+    TInputStream * is_;
+    bool valid_;
+    char driver_[MaxDriverName];
+    unsigned frame_;
+    bool pending_;          // True if the next event has been read
+    unsigned event_frame_;  // Next event
+    unsigned event_device_;
+    unsigned event_param_;
+};
+
+#endif // EMU_INPUT_LOG_H_
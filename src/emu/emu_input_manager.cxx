@@ -4,6 +4,7 @@
     Copyright (c) 2003,2004 Alessandro Scotti
 */
 #include "emu_input_manager.h"
+#include "emu_input_log.h"
 
 struct TEmuInputManagerItem
 {
@@ -17,6 +18,7 @@ TEmuInputManager::TEmuInputManager()
     count_ = 0;
     capacity_ = 0;
     items_ = 0;
+    recorder_ = 0;
 }
 
 TEmuInputManager::~TEmuInputManager()
@@ -129,6 +131,9 @@ bool TEmuInputManager::handle( unsigned key, unsigned param, TMachine * machine
 
                     joystick->handleArrowKey( k, param );
                 }
+                else if( recorder_ != 0 ) {
+                    recorder_->handleInputEvent( machine, id, items_[i].data | param );
+                }
                 else {
                     machine->handleInputEvent( id, items_[i].data | param, 0 );
                 }
@@ -148,6 +153,6 @@ void TEmuInputManager::notifyJoysticks( TMachine * machine )
     for( int i=0; i<joysticks_.count(); i++ ) {
         TJoystick * joystick = (TJoystick *) joysticks_.item(i);
 
-        joystick->notify( machine );
+        joystick->notify( machine, recorder_ );
     }
 }
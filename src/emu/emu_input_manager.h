@@ -29,6 +29,11 @@ public:
 
     void notifyJoysticks( TMachine * machine );
 
+    /** Records all the events sent to the machine (null to stop recording). */
+    void setRecorder( TInputRecorder * recorder ) {
+        recorder_ = recorder;
+    }
+
     TJoystick * joystick( int index ) {
         return (TJoystick *) joysticks_.item(index);
     }
@@ -40,6 +45,7 @@ private:
     int capacity_;
     TEmuInputManagerItem * items_;
     TList joysticks_;
+    TInputRecorder * recorder_;
 };
 
 #endif // EMU_INPUT_MANAGER_H_
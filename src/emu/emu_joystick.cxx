@@ -4,6 +4,17 @@
     Copyright (c) 2003,2004 Alessandro Scotti
 */
 #include "emu_joystick.h"
+#include "emu_input_log.h"
+
+static void sendEvent( TMachine * machine, TInputRecorder * recorder, unsigned device, unsigned param )
+{
+    if( recorder != 0 ) {
+        recorder->handleInputEvent( machine, device, param );
+    }
+    else {
+        machine->handleInputEvent( device, param, 0 );
+    }
+}
 
 TJoystick::TJoystick( unsigned id ) : id_(id) 
 {
@@ -74,7 +85,7 @@ void TJoystick::handleArrowKey( int key, unsigned pressed )
     }
 }
 
-void TJoystick::notify( TMachine * machine ) 
+void TJoystick::notify( TMachine * machine, TInputRecorder * recorder ) 
 {
     if( machine != 0 ) {
         int x = x_;
@@ -101,7 +112,7 @@ void TJoystick::notify( TMachine * machine )
         if( (x != last_x_) || (y != last_y_) ) {
             last_x_ = x;
             last_y_ = y;
-            machine->handleInputEvent( id_, TInput::makeParamFromPos(x,y), 0 );
+            sendEvent( machine, recorder, id_, TInput::makeParamFromPos(x,y) );
         }
 
         // Notify buttons if changed
@@ -112,7 +123,7 @@ void TJoystick::notify( TMachine * machine )
                 if( (last_buttons_ & bit) != (buttons_ & bit) ) {
                     unsigned param = (buttons_ & bit) ? 1 : 0;
 
-                    machine->handleInputEvent( button2key_[i], param, 0 );
+                    sendEvent( machine, recorder, button2key_[i], param );
                 }
             }
 
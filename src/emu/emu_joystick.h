@@ -9,6 +9,8 @@
 #include "emu_input.h"
 #include "emu_machine.h"
 
+class TInputRecorder;
+
 class TJoystick
 {
 public:
@@ -33,7 +35,12 @@ public:
 
     void handleArrowKey( int key, unsigned pressed );
 
-    void notify( TMachine * machine );
+    /**
+        Sends the changes in position and buttons to the machine.
+
+        @param recorder if not null, records the events before they are sent
+    */
+    void notify( TMachine * machine, TInputRecorder * recorder = 0 );
 
     unsigned id() const {
         return id_;
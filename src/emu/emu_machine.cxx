@@ -31,6 +31,47 @@ void TMachine::registerDriver( const TMachineInfo & driver )
     drivers_.insert( 0, const_cast<TMachineInfo *>(&driver) );
 }
 
+// Tag at the beginning of all machine states, followed by the driver name
+static const char StateTag[4] = { 'T', 'K', 'S', '1' };
+
+bool TMachine::saveState( TOutputStream * os )
+{
+    const char * driver = getResourceName( 0 );
+    unsigned len = (driver != 0) ? strlen( driver ) : 0;
+    TStateStream state( os );
+
+    state.bytes( (void *) StateTag, sizeof(StateTag) );
+    state.value( len );
+    state.bytes( (void *) driver, len );
+
+    return serialize( state ) && state.ok();
+}
+
+bool TMachine::loadState( TInputStream * is )
+{
+    const char * driver = getResourceName( 0 );
+    unsigned len = (driver != 0) ? strlen( driver ) : 0;
+    TStateStream state( is );
+    char tag[sizeof(StateTag)];
+    char name[64];
+    unsigned name_len = 0;
+
+    state.bytes( tag, sizeof(tag) );
+    state.value( name_len );
+
+    if( ! state.ok() || (memcmp( tag, StateTag, sizeof(tag) ) != 0) || (name_len != len) || (len > sizeof(name)) ) {
+        return false;
+    }
+
+    state.bytes( name, len );
+
+    if( ! state.ok() || (memcmp( name, driver, len ) != 0) ) {
+        return false;
+    }
+
+    return serialize( state ) && state.ok();
+}
+
 TMachine * TMachine::createInstance( TMachineFactoryFunc factoryFunc )
 {
     TMachine * result = factoryFunc();
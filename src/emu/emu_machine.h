@@ -10,6 +10,7 @@
 #include "emu_info.h"
 #include "emu_list.h"
 #include "emu_sample.h"
+#include "emu_state.h"
 #include "emu_ui.h"
 
 class TMachine;
@@ -44,6 +45,26 @@ public:
 
     virtual void reset() = 0;
 
+    /**
+        Saves the machine state.
+
+        States are taken between frames and are meant to be kept in memory
+        (e.g. to rewind the game): they can only be loaded back by the same
+        process that saved them.
+
+        @return false if the driver does not support states or on error
+    */
+    bool saveState( TOutputStream * os );
+
+    /**
+        Loads a state saved by saveState().
+
+        @return false if the state does not belong to this driver or on error,
+        in which case the machine may have been partially modified and should
+        be reset
+    */
+    bool loadState( TInputStream * is );
+
 
     static TMachine * createInstance( TMachineFactoryFunc factoryFunc );
 
@@ -63,6 +84,15 @@ protected:
 
     virtual bool initialize( TMachineDriverInfo * info ) = 0;
 
+    /**
+        Saves or loads the machine state (see TStateStream).
+
+        @return false if the driver does not support states
+    */
+    virtual bool serialize( TStateStream & state ) {
+        return false;
+    }
+
 private:
     TMachine( const TMachine & );
     TMachine & operator = ( const TMachine & );
@@ -33,6 +33,11 @@ public:
         return (value >= lo) && (value <= hi);
     }
 
+    // Rounds to the nearest integer, halves away from zero
+    static int round( double x ) {
+        return (x >= 0) ? (int) (x + 0.5) : -(int) (0.5 - x);
+    }
+
 private:
     TMath();
 };
@@ -29,3 +29,40 @@ unsigned TMemoryInputStream::read( void * buf, unsigned len ) {
 
     return result;
 }
+
+TMemoryOutputStream::TMemoryOutputStream( unsigned capacity )
+{
+    data_ = capacity > 0 ? new unsigned char [capacity] : 0;
+    size_ = 0;
+    capacity_ = capacity;
+}
+
+TMemoryOutputStream::~TMemoryOutputStream()
+{
+    delete [] data_;
+}
+
+unsigned TMemoryOutputStream::write( const char * buf, unsigned len )
+{
+    if( size_ + len > capacity_ ) {
+        unsigned capacity = capacity_ > 0 ? capacity_ : 1024;
+
+        while( capacity < size_ + len ) {
+            capacity *= 2;
+        }
+
+        unsigned char * data = new unsigned char [capacity];
+
+        memcpy( data, data_, size_ );
+
+        delete [] data_;
+
+        data_ = data;
+        capacity_ = capacity;
+    }
+
+    memcpy( data_+size_, buf, len );
+    size_ += len;
+
+    return len;
+}
@@ -26,4 +26,42 @@ private:
     unsigned offset_;
 };
 
+/**
+    Output stream that writes into a memory buffer, which grows as needed.
+
+    The buffer is kept when the stream is cleared, so a stream that is used
+    over and over (e.g. to save a state at every frame) only allocates memory
+    at the beginning.
+*/
+class TMemoryOutputStream : public TOutputStream
+{
+public:
+    TMemoryOutputStream( unsigned capacity = 0 );
+
+    virtual ~TMemoryOutputStream();
+
+    virtual unsigned write( const char * buf, unsigned len );
+
+    /** Discards the data written so far, but keeps the buffer. */
+    void clear() {
+        size_ = 0;
+    }
+
+    const unsigned char * data() const {
+        return data_;
+    }
+
+    unsigned size() const {
+        return size_;
+    }
+
+private:
+    TMemoryOutputStream( const TMemoryOutputStream & );
+    TMemoryOutputStream & operator = ( const TMemoryOutputStream & );
+
+    unsigned char * data_;
+    unsigned size_;
+    unsigned capacity_;
+};
+
 #endif // EMU_MEMORY_IOSTREAM_H_
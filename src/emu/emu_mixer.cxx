@@ -3,8 +3,13 @@
 
     Copyright (c) 2003,2004 Alessandro Scotti
 */
+#include <math.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "emu_math.h"
 #include "emu_mixer.h"
 
@@ -24,7 +29,7 @@ void TMixerBuffer::expand( unsigned size )
 
         if( data_ != 0 ) {
             memcpy( data, data_, sizeof(int)*size_ );
-            memset( data + sizeof(int)*size_, 0, sizeof(int)*(size-size_) );
+            memset( data + size_, 0, sizeof(int)*(size-size_) );
             delete data_;
         }
         else {
@@ -40,6 +45,7 @@ TMixer::TMixer( unsigned channels )
 {
     num_channels_ = channels;
     buffers_ = new TMixerBuffer[ channels ];
+    num_buses_ = 0;
 }
 
 TMixer::~TMixer()
@@ -52,6 +58,14 @@ void TMixer::clear()
     for( unsigned i=0; i<num_channels_; i++ ) {
         buffers_[i].clear();
     }
+
+    // Keep the buses and their buffers, so they are not reallocated on the next frame
+    for( unsigned i=0; i<num_buses_; i++ ) {
+        if( bus_used_[i] ) {
+            bus_[i].clear();
+            bus_used_[i] = false;
+        }
+    }
 }
 
 int TMixer::maxVoicesPerChannel()
@@ -62,7 +76,203 @@ int TMixer::maxVoicesPerChannel()
         result = TMath::max( result, buffers_[i].voices() );
     }
 
-    return result + buffers_[0].voices();
+    result += buffers_[0].voices();
+
+    for( unsigned i=0; i<num_buses_; i++ ) {
+        if( bus_used_[i] ) {
+            result += bus_[i].voices();
+        }
+    }
+
+    return result;
+}
+
+void TMixer::setGain( unsigned channel, float gain )
+{
+    if( channel < num_channels_ ) {
+        buffers_[channel].setGain( gain );
+    }
+}
+
+void TMixer::setPan( unsigned channel, float pan )
+{
+    if( channel < num_channels_ ) {
+        buffers_[channel].setPan( pan );
+    }
+}
+
+/*
+    Converts a block of mixed samples to 16-bit, rounding to nearest and saturating.
+    Both paths round with the current FPU mode (halves to even by default), so the
+    output does not depend on where the vector loop stops.
+*/
+static void saturateBlock( int16_t * dest, const float * src, unsigned len )
+{
+    unsigned i = 0;
+
+#if defined(__SSE2__)
+    for( ; i+8<=len; i+=8 ) {
+        __m128i lo = _mm_cvtps_epi32( _mm_loadu_ps( src+i ) );
+        __m128i hi = _mm_cvtps_epi32( _mm_loadu_ps( src+i+4 ) );
+
+        _mm_storeu_si128( (__m128i *) (dest+i), _mm_packs_epi32( lo, hi ) );
+    }
+#endif
+
+    for( ; i<len; i++ ) {
+        float v = src[i];
+
+        if( v >= 32767.0f ) {
+            dest[i] = 32767;
+        }
+        else if( v <= -32768.0f ) {
+            dest[i] = -32768;
+        }
+        else {
+            dest[i] = (int16_t) lrintf( v );
+        }
+    }
+}
+
+/*
+    Collects the channels and buses that have data to mix.
+*/
+unsigned TMixer::getSources( TMixerBuffer ** sources )
+{
+    unsigned count = 0;
+
+    for( unsigned c=0; c<num_channels_; c++ ) {
+        if( (buffers_[c].data() != 0) && (buffers_[c].gain() != 0) ) {
+            sources[count++] = &buffers_[c];
+        }
+    }
+
+    for( unsigned b=0; b<num_buses_; b++ ) {
+        if( bus_used_[b] && (bus_[b].data() != 0) && (bus_[b].gain() != 0) && (count < MaxSources) ) {
+            sources[count++] = &bus_[b];
+        }
+    }
+
+    return count;
+}
+
+void TMixer::render( int16_t * dest, unsigned len )
+{
+    enum { BlockSize = 256 };
+
+    float block[BlockSize];
+    TMixerBuffer * sources[MaxSources];
+    unsigned count = getSources( sources );
+    int voices = maxVoicesPerChannel();
+
+    // Note: the per-voice scale is kept integer, as it has always been
+    float scale = (voices > 0) ? (float) (128 / voices) : 0.0f;
+
+    for( unsigned pos=0; pos<len; pos+=BlockSize ) {
+        unsigned n = (len - pos < BlockSize) ? len - pos : BlockSize;
+
+        memset( block, 0, sizeof(block) );
+
+        for( unsigned s=0; s<count; s++ ) {
+            TMixerBuffer * buffer = sources[s];
+
+            if( buffer->size() <= pos ) {
+                continue;
+            }
+
+            const int * src = buffer->data() + pos;
+            unsigned m = (buffer->size() - pos < n) ? buffer->size() - pos : n;
+            float gain = buffer->gain() * scale;
+
+            for( unsigned i=0; i<m; i++ ) {
+                block[i] += (float) src[i] * gain;
+            }
+        }
+
+        saturateBlock( dest + pos, block, n );
+    }
+}
+
+void TMixer::renderStereo( int16_t * dest, unsigned len )
+{
+    enum { BlockSize = 128 };
+
+    float block[BlockSize*2];
+    TMixerBuffer * sources[MaxSources];
+    float gain_left[MaxSources];
+    float gain_right[MaxSources];
+    unsigned count = getSources( sources );
+    int voices = maxVoicesPerChannel();
+    float scale = (voices > 0) ? (float) (128 / voices) : 0.0f;
+
+    // Balance law: the far side is attenuated, the near side stays at full level
+    for( unsigned s=0; s<count; s++ ) {
+        float gain = sources[s]->gain() * scale;
+        float pan = sources[s]->pan();
+
+        pan = (pan < -1.0f) ? -1.0f : ((pan > 1.0f) ? 1.0f : pan);
+
+        gain_left[s] = (pan > 0) ? gain * (1 - pan) : gain;
+        gain_right[s] = (pan < 0) ? gain * (1 + pan) : gain;
+    }
+
+    for( unsigned pos=0; pos<len; pos+=BlockSize ) {
+        unsigned n = (len - pos < BlockSize) ? len - pos : BlockSize;
+
+        memset( block, 0, sizeof(block) );
+
+        // Accumulate both sides of all sources into the interleaved block
+        for( unsigned s=0; s<count; s++ ) {
+            TMixerBuffer * buffer = sources[s];
+
+            if( buffer->size() <= pos ) {
+                continue;
+            }
+
+            const int * src = buffer->data() + pos;
+            unsigned m = (buffer->size() - pos < n) ? buffer->size() - pos : n;
+            float gl = gain_left[s];
+            float gr = gain_right[s];
+
+            for( unsigned i=0; i<m; i++ ) {
+                float x = (float) src[i];
+
+                block[2*i+0] += x * gl;
+                block[2*i+1] += x * gr;
+            }
+        }
+
+        saturateBlock( dest + 2*pos, block, 2*n );
+    }
+}
+
+TMixerBuffer * TMixer::getBus( const char * name, unsigned length, unsigned voices, float gain, float pan )
+{
+    unsigned index = 0;
+
+    while( (index < num_buses_) && (strcmp( bus_name_[index], name ) != 0) ) {
+        index++;
+    }
+
+    if( index >= num_buses_ ) {
+        if( num_buses_ >= MaxBuses ) {
+            // Out of buses, fall back to the shared mono buffer
+            return getBuffer( chMono, length, voices );
+        }
+
+        bus_name_[num_buses_++] = name;
+    }
+
+    TMixerBuffer * result = &bus_[index];
+
+    result->expand( length );
+    result->addVoices( voices );
+    result->setGain( gain );
+    result->setPan( pan );
+
+    bus_used_[index] = true;
+
+    return result;
 }
 
 TMixerBuffer * TMixer::getBuffer( unsigned channel, unsigned length, unsigned voices )
@@ -86,5 +296,5 @@ TMixerBuffer * TMixerMono::getBuffer( unsigned channel, unsigned length, unsigne
 
 TMixerBuffer * TMixerStereo::getBuffer( unsigned channel, unsigned length, unsigned voices )
 {
-    return TMixer::getBuffer( (channel >= 2) ? 0 : channel, length, voices );
+    return TMixer::getBuffer( (channel > chStereoRight) ? chMono : channel, length, voices );
 }
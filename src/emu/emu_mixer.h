@@ -6,6 +6,8 @@
 #ifndef EMU_MIXER_H_
 #define EMU_MIXER_H_
 
+#include <stdint.h>
+
 enum TMixerChannel 
 {
     chMono = 0,
@@ -16,7 +18,7 @@ enum TMixerChannel
 class TMixerBuffer
 {
 public:
-    TMixerBuffer() : data_(0), size_(0), num_voices_(0) {
+    TMixerBuffer() : data_(0), size_(0), num_voices_(0), gain_(1.0f), pan_(0.0f) {
     }
 
     /** Destructor. */
@@ -46,12 +48,31 @@ public:
         num_voices_ += voices;
     }
 
+    float gain() const {
+        return gain_;
+    }
+
+    void setGain( float gain ) {
+        gain_ = gain;
+    }
+
+    float pan() const {
+        return pan_;
+    }
+
+    /** Sets the stereo position, from -1 (left) to +1 (right). */
+    void setPan( float pan ) {
+        pan_ = pan;
+    }
+
     void expand( unsigned size );
 
 private:
     int * data_;
     unsigned size_;
     unsigned num_voices_;
+    float gain_;
+    float pan_;
 };
 
 class TMixer
@@ -70,8 +91,63 @@ public:
         return getBuffer( channel, 0, 0 )->data();
     }
 
+    /**
+        Returns the buffer of a named bus.
+
+        Buses are sources that are mixed separately from the channels, each with
+        its own gain and stereo position. A bus is created the first time it is
+        requested and then kept (with its buffer) when the mixer is cleared, so
+        a recycled mixer doesn't need to reallocate it. Gain and pan are those
+        passed in the last call. If there are too many buses, the mono channel
+        buffer is returned.
+
+        @param name bus name, must be a static string
+        @param length minimum buffer length in samples
+        @param voices number of voices the caller will add to the buffer
+        @param gain bus gain
+        @param pan stereo position, from -1 (left) to +1 (right)
+    */
+    TMixerBuffer * getBus( const char * name, unsigned length, unsigned voices, float gain = 1.0f, float pan = 0.0f );
+
+    /** Returns the total number of voices in all channels and buses. */
     virtual int maxVoicesPerChannel();
 
+    /**
+        Sets the gain of the specified channel (1.0 by default).
+
+        The gain is kept when the mixer is cleared.
+    */
+    void setGain( unsigned channel, float gain );
+
+    /**
+        Sets the stereo position of the specified channel (0 by default).
+    */
+    void setPan( unsigned channel, float pan );
+
+    /**
+        Mixes down all channels into signed 16-bit samples.
+
+        Each sample is scaled by the channel gain and by 128/voices (where voices
+        is the value returned by maxVoicesPerChannel()), then saturated to the
+        16-bit range. Channel data shorter than the requested length is
+        considered silent.
+
+        @param dest destination buffer, must hold len samples
+        @param len number of samples to render
+    */
+    void render( int16_t * dest, unsigned len );
+
+    /**
+        Mixes down all channels and buses into interleaved stereo 16-bit samples.
+
+        Same as render() but each source is panned according to its stereo
+        position: a centered source is played at full level on both sides.
+
+        @param dest destination buffer, must hold 2*len samples
+        @param len number of sample frames to render
+    */
+    void renderStereo( int16_t * dest, unsigned len );
+
     static void mix( int * dest, const int * source, unsigned len ) {
         while( len-- > 0 ) {
             *dest++ += *source++;
@@ -84,8 +160,19 @@ protected:
     }
 
 private:
+    enum {
+        MaxBuses = 16,
+        MaxSources = 32
+    };
+
+    unsigned getSources( TMixerBuffer ** sources );
+
     unsigned num_channels_;
     TMixerBuffer * buffers_;
+    const char * bus_name_[MaxBuses];
+    TMixerBuffer bus_[MaxBuses];
+    bool bus_used_[MaxBuses];
+    unsigned num_buses_;
 };
 
 class TMixerMono : public TMixer
@@ -101,6 +188,8 @@ class TMixerStereo : public TMixer
 {
 public:
     TMixerStereo() : TMixer(3) {
+        setPan( chStereoLeft, -1.0f );
+        setPan( chStereoRight, +1.0f );
     }
 
     virtual TMixerBuffer * getBuffer( unsigned channel, unsigned length, unsigned voices );
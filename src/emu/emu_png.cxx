@@ -1,6 +1,6 @@
 /*
     Tickle class library
-    PNG image decoder
+    PNG image decoder and encoder
 
     Copyright (c) 2004 Alessandro Scotti
 */
@@ -516,3 +516,78 @@ void TPngReader::expandCurrentScanline( unsigned x, unsigned y, unsigned dx )
         }
     }
 }
+
+static void putUint32( unsigned char * buf, unsigned value )
+{
+    buf[0] = (unsigned char) (value >> 24);
+    buf[1] = (unsigned char) (value >> 16);
+    buf[2] = (unsigned char) (value >>  8);
+    buf[3] = (unsigned char) (value);
+}
+
+static bool writeChunk( TOutputStream * os, unsigned type, const unsigned char * data, unsigned size )
+{
+    unsigned char header[8];
+    TCRC32 crc32;
+
+    putUint32( header+0, size );
+    putUint32( header+4, type );
+
+    crc32.update( header+4, 4 );
+    crc32.update( data, size );
+
+    bool ok = os->write( (const char *) header, sizeof(header) ) == sizeof(header);
+
+    ok = ok && (os->write( (const char *) data, size ) == size);
+
+    putUint32( header, crc32.value() );
+
+    return ok && (os->write( (const char *) header, 4 ) == 4);
+}
+
+bool writeBitmapToPNG( TOutputStream * os, TBitmap * bitmap )
+{
+    unsigned width = (unsigned) bitmap->width();
+    unsigned height = (unsigned) bitmap->height();
+    unsigned bytes_line = 1 + width*3;  // Filter type + RGB pixels
+
+    // Image header: 8 bits per channel, RGB, not interlaced
+    unsigned char ihdr[13];
+
+    putUint32( ihdr+0, width );
+    putUint32( ihdr+4, height );
+    ihdr[8] = 8;
+    ihdr[9] = COLOR_TYPE_RGB;
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = LACE_NONE;
+
+    // Image data, every scanline is stored without filtering
+    unsigned raw_size = bytes_line * height;
+    unsigned char * raw = new unsigned char [ raw_size ];
+    unsigned char * p = raw;
+
+    for( unsigned y=0; y<height; y++ ) {
+        *p++ = FILTER_NONE;
+
+        for( unsigned x=0; x<width; x++ ) {
+            TPalette::decodeColor( bitmap->pixel( x, y ), p+0, p+1, p+2 );
+            p += 3;
+        }
+    }
+
+    uLongf data_size = compressBound( raw_size );
+    unsigned char * data = new unsigned char [ data_size ];
+
+    bool ok = compress( data, &data_size, raw, raw_size ) == Z_OK;
+
+    ok = ok && (os->write( (const char *) PngSignature, sizeof(PngSignature) ) == sizeof(PngSignature));
+    ok = ok && writeChunk( os, CHUNK_IHDR, ihdr, sizeof(ihdr) );
+    ok = ok && writeChunk( os, CHUNK_IDAT, data, (unsigned) data_size );
+    ok = ok && writeChunk( os, CHUNK_IEND, 0, 0 );
+
+    delete [] data;
+    delete [] raw;
+
+    return ok;
+}
@@ -17,4 +17,11 @@
 */
 TBitmap * createBitmapFromPNG( TInputStream * );
 
+/**
+    Writes a bitmap to the specified output stream as a 24-bit RGB PNG file.
+
+    @return false on error
+*/
+bool writeBitmapToPNG( TOutputStream *, TBitmap * );
+
 #endif // EMU_PNG_H_
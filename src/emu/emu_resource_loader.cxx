@@ -0,0 +1,151 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2003,2004 Alessandro Scotti
+*/
+#include <stdio.h>
+#include <string.h>
+
+#include "emu_crc32.h"
+#include "emu_file_iostream.h"
+#include "emu_resource_loader.h"
+#include "emu_string.h"
+#include "emu_zipfile.h"
+
+#ifdef WIN32
+const wchar_t PATH_SEPARATOR = '\\';
+#else
+const wchar_t PATH_SEPARATOR = '/';
+#endif
+
+// Load a file from an input stream into a newly allocated buffer
+// (which must be deleted by the caller)
+static unsigned char * loadFileFromStream( TInputStream * is, unsigned size, TCRC32 * crc )
+{
+    unsigned char * result = new unsigned char [size];
+    
+    if( is->read( result, size ) == size ) {
+        crc->reset();
+        crc->update( result, size );
+    }
+    else {
+        delete [] result;
+        result = 0;
+    }
+    
+    return result;
+}
+
+static unsigned getFileSize( const char * name )
+{
+    unsigned result = 0;
+    
+    FILE * f = fopen( name, "rb" );
+    
+    if( f != 0 ) {
+        fseek( f, 0L, SEEK_END );
+        result = (unsigned) ftell( f );
+        fclose( f );
+    }
+    
+    return result;
+}
+
+// Load a single file required by the driver
+static unsigned char * loadFile( TMachine * machine, const TResourceFileInfo * info, const char * home_dir, const char * base, unsigned * bufsize )
+{
+    unsigned char * result = 0;
+    
+    TString home( home_dir );
+
+    if( home.wstr()[home.length()-1] != PATH_SEPARATOR ) {
+        home.append(PATH_SEPARATOR);
+    }
+    
+    if( base != 0 ) {
+        home += base;
+        home.append(PATH_SEPARATOR);
+    }
+
+    TString file = home + info->name;
+    TCRC32 crc;
+    TInputStream * is = TFileInputStream::open( file.cstr() );
+    
+    if( is != 0 ) {
+        unsigned size = info->size;
+        
+        if( size == 0 ) {
+            size = getFileSize( file.cstr() );
+        }
+        
+        result = loadFileFromStream( is, size, &crc );
+        
+        *bufsize = size;
+        
+        delete is;
+    }
+    else {
+        for( int i=0; i<machine->getResourceCount(); i++ ) {
+            file = home + machine->getResourceName(i) + ".zip";
+            
+            TZipFile * zf = TZipFile::open( file.cstr() );
+            
+            if( zf != 0 ) {
+                const TZipEntry * ze = zf->entry( info->name, true );
+                
+                if( ze != 0 ) {
+                    is = ze->open();
+                    
+                    if( is != 0 ) {
+                        *bufsize = info->size ? info->size : ze->size();
+                        result = loadFileFromStream( is, *bufsize, &crc );
+                    }
+                    
+                    delete is;
+                }
+                
+                delete zf;
+            }
+            
+            if( result != 0 )
+                break;
+        }
+    }
+    
+    if( result != 0 ) {
+        // Delete buffer if CRC check fails
+        if( (info->crc != 0) && (crc.value() != info->crc) ) {
+            delete [] result;
+            result = 0;
+        }
+    }
+    
+    return result;
+}
+
+bool loadMachineResources( TMachine * machine, const char * home, TList & failedList )
+{
+    bool result = true;
+    const TMachineDriverInfo * info = machine->getDriverInfo();
+    
+    for( int i=0; i<info->resourceFileCount(); i++ ) {
+        const TResourceFileInfo * file = info->resourceFile( i );
+        unsigned size = 0;
+        unsigned char * buf = loadFile( machine, file, home, "roms", &size );
+        
+        if( (buf == 0) && (strstr(file->name,".wav") != 0) ) {
+            buf = loadFile( machine, file, home, "samples", &size );
+        }
+        
+        if( buf != 0 ) {
+            machine->setResourceFile( file->id, buf, size );
+            delete [] buf;
+        }
+        else {
+            failedList.add( (void *)file->name );
+            result = false;
+        }
+    }
+    
+    return result;
+}
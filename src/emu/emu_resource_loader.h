@@ -0,0 +1,27 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2003,2004 Alessandro Scotti
+*/
+#ifndef EMU_RESOURCE_LOADER_H_
+#define EMU_RESOURCE_LOADER_H_
+
+#include "emu_list.h"
+#include "emu_machine.h"
+
+/**
+    Loads the files required by a machine.
+
+    Files are looked for in the "roms" folder (also "samples" for sounds) of
+    the home directory, either as they are or in the ZIP archives named after
+    the machine resources. Files with a bad CRC are not loaded.
+
+    @param machine machine that receives the files
+    @param home directory that contains the "roms" and "samples" folders
+    @param failedList receives the names of the files that could not be loaded
+
+    @return false if one or more files could not be loaded
+*/
+bool loadMachineResources( TMachine * machine, const char * home, TList & failedList );
+
+#endif // EMU_RESOURCE_LOADER_H_
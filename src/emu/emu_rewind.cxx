@@ -0,0 +1,310 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#include "emu_rewind.h"
+#include "emu_machine.h"
+
+enum {
+    MinUnchangedRun = 4,    // Unchanged bytes needed to end a run of changed bytes
+    ChunkSize = 256
+};
+
+// Returns the byte at the specified offset, states are considered padded with zeroes
+static inline unsigned char byteAt( const unsigned char * state, unsigned size, unsigned offset )
+{
+    return (offset < size) ? state[offset] : 0;
+}
+
+static void writeCount( TMemoryOutputStream & os, unsigned n )
+{
+    char buf[8];
+    unsigned len = 0;
+
+    while( n >= 0x80 ) {
+        buf[len++] = (char) (n | 0x80);
+        n >>= 7;
+    }
+
+    buf[len++] = (char) n;
+
+    os.write( buf, len );
+}
+
+static bool readCount( const unsigned char * & p, const unsigned char * end, unsigned & n )
+{
+    unsigned shift = 0;
+
+    n = 0;
+
+    while( (p < end) && (shift < 32) ) {
+        unsigned char b = *p++;
+
+        n |= (unsigned) (b & 0x7F) << shift;
+
+        if( (b & 0x80) == 0 ) {
+            return true;
+        }
+
+        shift += 7;
+    }
+
+    return false;
+}
+
+TRewindBuffer::TRewindBuffer( unsigned maxBytes, unsigned maxFrames )
+{
+    current_ = &states_[0];
+    spare_ = &states_[1];
+    ring_size_ = maxBytes;
+    ring_ = (ring_size_ > 0) ? new unsigned char [ring_size_] : 0;
+    max_entries_ = (maxFrames > 1) ? maxFrames - 1 : 0; // The most recent frame is not in the ring
+    entries_ = (max_entries_ > 0) ? new TEntry [max_entries_] : 0;
+
+    clear();
+}
+
+TRewindBuffer::~TRewindBuffer()
+{
+    delete [] ring_;
+    delete [] entries_;
+}
+
+void TRewindBuffer::clear()
+{
+    current_->clear();
+    first_entry_ = 0;
+    num_entries_ = 0;
+    used_ = 0;
+    last_frame_bytes_ = 0;
+}
+
+bool TRewindBuffer::push( TMachine * machine )
+{
+    spare_->clear();
+
+    if( ! machine->saveState( spare_ ) ) {
+        return false;
+    }
+
+    if( (current_->size() > 0) && (max_entries_ > 0) ) {
+        // Store the previous state as a difference from the new one
+        encoded_.clear();
+
+        encode( current_->data(), current_->size(), spare_->data(), spare_->size() );
+
+        unsigned len = encoded_.size();
+
+        last_frame_bytes_ = len;
+
+        while( (num_entries_ > 0) && ((used_ + len > ring_size_) || (num_entries_ == max_entries_)) ) {
+            dropOldest();
+        }
+
+        if( len <= ring_size_ ) {
+            unsigned offset = 0;
+
+            if( num_entries_ > 0 ) {
+                const TEntry & last = entries_[ (first_entry_ + num_entries_ - 1) % max_entries_ ];
+
+                offset = (last.offset + last.length) % ring_size_;
+            }
+
+            copyToRing( offset, encoded_.data(), len );
+
+            TEntry & entry = entries_[ (first_entry_ + num_entries_) % max_entries_ ];
+
+            entry.offset = offset;
+            entry.length = len;
+            entry.size = current_->size();
+
+            num_entries_++;
+            used_ += len;
+        }
+    }
+
+    TMemoryOutputStream * state = current_;
+
+    current_ = spare_;
+    spare_ = state;
+
+    return true;
+}
+
+bool TRewindBuffer::pop( TMachine * machine )
+{
+    if( current_->size() == 0 ) {
+        return false;
+    }
+
+    TMemoryInputStream is( current_->data(), current_->size() );
+
+    bool result = machine->loadState( &is );
+
+    if( num_entries_ > 0 ) {
+        // Rebuild the previous state from the difference
+        const TEntry & entry = entries_[ (first_entry_ + num_entries_ - 1) % max_entries_ ];
+
+        encoded_.clear();
+        copyFromRing( entry.offset, entry.length );
+
+        spare_->clear();
+
+        decode( encoded_.data(), entry.length, entry.size, current_->data(), current_->size() );
+
+        num_entries_--;
+        used_ -= entry.length;
+
+        TMemoryOutputStream * state = current_;
+
+        current_ = spare_;
+        spare_ = state;
+    }
+    else {
+        current_->clear();
+    }
+
+    return result;
+}
+
+void TRewindBuffer::dropOldest()
+{
+    used_ -= entries_[first_entry_].length;
+    first_entry_ = (first_entry_ + 1) % max_entries_;
+    num_entries_--;
+}
+
+void TRewindBuffer::copyToRing( unsigned offset, const unsigned char * src, unsigned len )
+{
+    unsigned n = ring_size_ - offset;
+
+    if( n > len ) {
+        n = len;
+    }
+
+    memcpy( ring_+offset, src, n );
+    memcpy( ring_, src+n, len-n );
+}
+
+void TRewindBuffer::copyFromRing( unsigned offset, unsigned len )
+{
+    unsigned n = ring_size_ - offset;
+
+    if( n > len ) {
+        n = len;
+    }
+
+    encoded_.write( (const char *) ring_+offset, n );
+    encoded_.write( (const char *) ring_, len-n );
+}
+
+// The difference is a sequence of runs: the count of unchanged bytes, followed by
+// the count of changed bytes and their XOR with the next state
+void TRewindBuffer::encode( const unsigned char * state, unsigned size, const unsigned char * next, unsigned next_size )
+{
+    unsigned i = 0;
+
+    while( i < size ) {
+        // Skip the unchanged bytes, 8 at a time where possible
+        unsigned start = i;
+
+        while( (i+8 <= size) && (i+8 <= next_size) && (memcmp( state+i, next+i, 8 ) == 0) ) {
+            i += 8;
+        }
+
+        while( (i < size) && (state[i] == byteAt( next, next_size, i )) ) {
+            i++;
+        }
+
+        writeCount( encoded_, i - start );
+
+        // Find the end of the changed bytes
+        start = i;
+
+        unsigned end = i;
+
+        while( (i < size) && (i - end < MinUnchangedRun) ) {
+            if( state[i] != byteAt( next, next_size, i ) ) {
+                end = i+1;
+            }
+
+            i++;
+        }
+
+        i = end;
+
+        writeCount( encoded_, end - start );
+
+        while( start < end ) {
+            char buf[ChunkSize];
+            unsigned n = (end - start < ChunkSize) ? end - start : ChunkSize;
+
+            for( unsigned k=0; k<n; k++ ) {
+                buf[k] = (char) (state[start+k] ^ byteAt( next, next_size, start+k ));
+            }
+
+            encoded_.write( buf, n );
+
+            start += n;
+        }
+    }
+}
+
+void TRewindBuffer::decode( const unsigned char * data, unsigned length, unsigned size, const unsigned char * next, unsigned next_size )
+{
+    const unsigned char * p = data;
+    const unsigned char * end = data + length;
+    unsigned i = 0;
+
+    while( i < size ) {
+        unsigned same;
+        unsigned changed;
+
+        if( ! readCount( p, end, same ) || ! readCount( p, end, changed ) || (same + changed > size - i) || (changed > (unsigned) (end - p)) ) {
+            break; // Corrupted data, should not happen
+        }
+
+        // Copy the unchanged bytes
+        unsigned n = (i < next_size) ? next_size - i : 0;
+
+        if( n > same ) {
+            n = same;
+        }
+
+        spare_->write( (const char *) next+i, n );
+
+        i += n;
+        same -= n;
+
+        while( same > 0 ) {
+            char buf[ChunkSize];
+
+            n = (same < ChunkSize) ? same : ChunkSize;
+
+            memset( buf, 0, n );
+
+            spare_->write( buf, n );
+
+            i += n;
+            same -= n;
+        }
+
+        // Restore the changed bytes
+        while( changed > 0 ) {
+            char buf[ChunkSize];
+
+            n = (changed < ChunkSize) ? changed : ChunkSize;
+
+            for( unsigned k=0; k<n; k++ ) {
+                buf[k] = (char) (p[k] ^ byteAt( next, next_size, i+k ));
+            }
+
+            spare_->write( buf, n );
+
+            p += n;
+            i += n;
+            changed -= n;
+        }
+    }
+}
@@ -0,0 +1,106 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#ifndef EMU_REWIND_H_
+#define EMU_REWIND_H_
+
+#include "emu_memory_iostream.h"
+
+class TMachine;
+
+/**
+    Keeps the machine states of the last frames, so that the game can be
+    rewound one frame at a time.
+
+    Only the most recent state is kept as it is. Each older state is stored
+    as the difference (XOR) from the state that follows it, compressed with
+    a run-length encoding. Most of the machine state doesn't change from
+    one frame to the next, so the differences take a few hundred bytes each.
+    The oldest frames are discarded when the buffer is full.
+*/
+class TRewindBuffer
+{
+public:
+    /**
+        Constructor.
+
+        @param maxBytes maximum memory used for the frame differences
+        @param maxFrames maximum number of frames that can be rewound
+    */
+    TRewindBuffer( unsigned maxBytes, unsigned maxFrames );
+
+    /** Destructor. */
+    ~TRewindBuffer();
+
+    /**
+        Saves the machine state as the most recent frame (call once per frame).
+
+        @return false if the machine state could not be saved
+    */
+    bool push( TMachine * machine );
+
+    /**
+        Loads the most recent frame into the machine and removes it, so that
+        the next call goes back one more frame.
+
+        @return false if the buffer is empty or the state could not be loaded
+    */
+    bool pop( TMachine * machine );
+
+    /** Removes all frames. */
+    void clear();
+
+    /** Returns the number of frames in the buffer. */
+    unsigned count() const {
+        return (current_->size() > 0) ? num_entries_ + 1 : 0;
+    }
+
+    /** Returns the memory used by the frames, including the uncompressed most recent state. */
+    unsigned bytesUsed() const {
+        return used_ + current_->size();
+    }
+
+    /** Returns the size of the last compressed difference. */
+    unsigned lastFrameBytes() const {
+        return last_frame_bytes_;
+    }
+
+    /** Returns the average size of the compressed differences in the buffer. */
+    unsigned averageFrameBytes() const {
+        return (num_entries_ > 0) ? used_ / num_entries_ : 0;
+    }
+
+private:
+    TRewindBuffer( const TRewindBuffer & );
+    TRewindBuffer & operator = ( const TRewindBuffer & );
+
+    struct TEntry {
+        unsigned offset;    // Offset of the data in the ring buffer
+        unsigned length;    // Length of the compressed data
+        unsigned size;      // Size of the decompressed state
+    };
+
+    void encode( const unsigned char * state, unsigned size, const unsigned char * next, unsigned next_size );
+    void decode( const unsigned char * data, unsigned length, unsigned size, const unsigned char * next, unsigned next_size );
+
+    void dropOldest();
+    void copyToRing( unsigned offset, const unsigned char * src, unsigned len );
+    void copyFromRing( unsigned offset, unsigned len );
+
+    TMemoryOutputStream states_[2];
+    TMemoryOutputStream * current_;     // Most recent state
+    TMemoryOutputStream * spare_;       // Scratch state
+    TMemoryOutputStream encoded_;       // Scratch compressed difference
+    unsigned char * ring_;
+    unsigned ring_size_;
+    TEntry * entries_;                  // Circular list of differences, oldest first
+    unsigned max_entries_;
+    unsigned first_entry_;
+    unsigned num_entries_;
+    unsigned used_;                     // Bytes used in the ring buffer
+    unsigned last_frame_bytes_;
+};
+
+#endif // EMU_REWIND_H_
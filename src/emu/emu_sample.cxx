@@ -3,15 +3,98 @@
 
     Copyright (c) 2003-2021 Alessandro Scotti
 */
+#include <math.h>
+
 #include "emu_sample.h"
 
+enum {
+    SincHalfWidth = 8,      // Filter half width, in samples (at the cutoff frequency)
+    SincResolution = 256    // Filter table entries per sample
+};
+
 TSample::TSample( int * data, unsigned size, unsigned sampling_rate ) : size_(size), sampling_rate_(sampling_rate), data_(data)
 {
+    converted_ = 0;
 }
 
 TSample::~TSample()
 {
-    delete data_;
+    delete converted_;
+    delete [] data_;
+}
+
+const TSample * TSample::convertTo( unsigned samplingRate )
+{
+    if( (samplingRate == sampling_rate_) || (samplingRate == 0) || (sampling_rate_ == 0) ) {
+        return this;
+    }
+
+    if( (converted_ != 0) && (converted_->sampling_rate_ == samplingRate) ) {
+        return converted_;
+    }
+
+    delete converted_;
+    converted_ = 0;
+
+    // Ratio of source samples per output sample, and filter cutoff relative
+    // to the source Nyquist frequency (lowered when decimating)
+    double ratio = (double) sampling_rate_ / samplingRate;
+    double cutoff = ratio > 1 ? 1 / ratio : 1;
+
+    // Tabulate the right half of the Blackman-windowed sinc
+    const double Pi = 3.14159265358979323846;
+    const int TableSize = SincHalfWidth * SincResolution;
+
+    double * table = new double [TableSize + 2];
+
+    for( int i=0; i<=TableSize; i++ ) {
+        double u = (double) i / SincResolution;
+        double w = 0.42 + 0.5 * cos( Pi * u / SincHalfWidth ) + 0.08 * cos( 2 * Pi * u / SincHalfWidth );
+
+        table[i] = (i == 0) ? 1 : w * sin( Pi * u ) / (Pi * u);
+    }
+
+    table[TableSize+1] = 0;
+
+    // Convert
+    unsigned size = (unsigned) (((unsigned long long) size_ * samplingRate + sampling_rate_ - 1) / sampling_rate_);
+    int * data = new int [size > 0 ? size : 1];
+    int width = (int) ceil( SincHalfWidth / cutoff );
+    int last = (int) size_ - 1;
+
+    for( unsigned j=0; j<size; j++ ) {
+        double x = j * ratio;
+        int first = (int) floor( x ) - width + 1;
+        double sum = 0;
+        double weight = 0;
+
+        for( int k=first; k<first+2*width; k++ ) {
+            double u = fabs( x - k ) * cutoff * SincResolution;
+            int index = (int) u;
+
+            if( index >= TableSize ) {
+                continue;
+            }
+
+            double f = u - index;
+            double h = table[index] + f * (table[index+1] - table[index]);
+
+            // Samples past the ends repeat the edge values, so that looping
+            // and the 8-bit unsigned offset are preserved
+            sum += h * data_[ k < 0 ? 0 : (k > last ? last : k) ];
+            weight += h;
+        }
+
+        int s = (int) floor( sum / weight + 0.5 );
+
+        data[j] = s < 0 ? 0 : (s > 255 ? 255 : s);
+    }
+
+    delete [] table;
+
+    converted_ = new TSample( data, size, samplingRate );
+
+    return converted_;
 }
 
 static bool isFourCC( const unsigned char * s, const char * cc )
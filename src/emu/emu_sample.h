@@ -26,6 +26,15 @@ public:
         return data_;
     }
 
+    /**
+        Returns this sample converted to the specified sampling rate.
+
+        The conversion uses a windowed-sinc filter and is performed only once,
+        the result is cached and owned by this sample. If the rate is already
+        correct the sample itself is returned.
+    */
+    const TSample * convertTo( unsigned samplingRate );
+
     static TSample * createFromWave( TInputStream * is );
 
 private:
@@ -34,6 +43,7 @@ private:
     unsigned size_;
     unsigned sampling_rate_;
     int * data_;
+    TSample * converted_; // Last converted copy
 };
 
 #endif // EMU_SAMPLE_H_
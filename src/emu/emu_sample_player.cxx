@@ -49,18 +49,16 @@ bool TSamplePlayer::mix( int * buf, unsigned len, unsigned samplingRate )
     bool result = false;
 
     if( (sample_ != 0) && (status_ & statusPlaying) ) {
-        unsigned step = (sample_->samplingRate() << 10) / samplingRate;
-        unsigned size = sample_->size() << 10;
-        const int * data = sample_->data();
+        // Play the sample converted to the output rate, one span up to the
+        // end of the sample at a time
+        const TSample * sample = sample_->convertTo( samplingRate );
+        unsigned size = sample->size();
+        const int * data = sample->data();
 
         while( len > 0 ) {
-            *buf++ += data[ offset_ >> 10 ];
-
-            offset_ += step;
-
             if( offset_ >= size ) {
-                if( status_ & statusLooping ) {
-                    offset_ -= size;
+                if( (status_ & statusLooping) && (size > 0) ) {
+                    offset_ = 0;
                 }
                 else {
                     stop();
@@ -68,7 +66,25 @@ bool TSamplePlayer::mix( int * buf, unsigned len, unsigned samplingRate )
                 }
             }
 
-            len--;
+            unsigned n = size - offset_;
+
+            if( n > len ) {
+                n = len;
+            }
+
+            const int * src = data + offset_;
+
+            for( unsigned i=0; i<n; i++ ) {
+                buf[i] += src[i];
+            }
+
+            buf += n;
+            len -= n;
+            offset_ += n;
+        }
+
+        if( (offset_ >= size) && ! (status_ & statusLooping) ) {
+            stop();
         }
 
         result = true;
@@ -89,3 +105,10 @@ bool TSamplePlayer::mix( TMixer * mixer, unsigned channel, unsigned len, unsigne
 
     return result;
 }
+
+void TSamplePlayer::serialize( TStateStream & state )
+{
+    state.value( status_ );
+    state.value( offset_ );
+    state.bytes( &sample_, sizeof(sample_) );
+}
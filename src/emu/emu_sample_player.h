@@ -8,6 +8,7 @@
 
 #include "emu_mixer.h"
 #include "emu_sample.h"
+#include "emu_state.h"
 
 enum {
     pmLooping = 1
@@ -39,9 +40,11 @@ public:
         return sample_;
     }
 
+    void serialize( TStateStream & state );
+
 private:
     unsigned status_;
-    unsigned offset_;
+    unsigned offset_; // Position in the sample converted to the output rate
     TSample * sample_;
 };
 
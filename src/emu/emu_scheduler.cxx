@@ -0,0 +1,197 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#include "emu_scheduler.h"
+#include "emu_state.h"
+
+TScheduler::TScheduler()
+{
+    num_cpus_ = 0;
+    events_ = new TEvent [InitialEventCapacity];
+    num_events_ = 0;
+    event_capacity_ = InitialEventCapacity;
+    now_ = 0;
+    quantum_ = 0;
+    target_ = 0;
+    current_cpu_ = -1;
+    current_cycles_ = 0;
+}
+
+TScheduler::~TScheduler()
+{
+    delete [] events_;
+}
+
+// Makes room for the specified number of events
+void TScheduler::reserveEvents( int count )
+{
+    if( count > event_capacity_ ) {
+        while( event_capacity_ < count ) {
+            event_capacity_ *= 2;
+        }
+
+        TEvent * events = new TEvent [event_capacity_];
+
+        for( int i=0; i<num_events_; i++ ) {
+            events[i] = events_[i];
+        }
+
+        delete [] events_;
+
+        events_ = events;
+    }
+}
+
+int TScheduler::addCpu( TScheduledCpu * cpu, unsigned clockDivider )
+{
+    if( num_cpus_ >= MaxCpus ) {
+        return -1;
+    }
+
+    TCpuInfo & info = cpus_[num_cpus_];
+
+    info.cpu = cpu;
+    info.divider = clockDivider > 0 ? clockDivider : 1;
+    info.time = now_;
+    info.enabled = true;
+
+    return num_cpus_++;
+}
+
+void TScheduler::setCpuEnabled( int index, bool enabled )
+{
+    if( (index >= 0) && (index < num_cpus_) ) {
+        cpus_[index].enabled = enabled;
+    }
+}
+
+unsigned long long TScheduler::getTime() const
+{
+    if( current_cpu_ >= 0 ) {
+        const TCpuInfo & info = cpus_[current_cpu_];
+
+        return info.time + (unsigned long long) (info.cpu->getCycles() - current_cycles_) * info.divider;
+    }
+
+    return now_;
+}
+
+void TScheduler::post( unsigned long long time, TSchedulerCallback callback, void * context, unsigned param )
+{
+    reserveEvents( num_events_ + 1 );
+
+    // Insert after all events with the same or an earlier time
+    int index = num_events_;
+
+    while( (index > 0) && (events_[index-1].time > time) ) {
+        events_[index] = events_[index-1];
+        index--;
+    }
+
+    events_[index].time = time;
+    events_[index].callback = callback;
+    events_[index].context = context;
+    events_[index].param = param;
+
+    num_events_++;
+
+    // If posted by a running CPU, end the slice of the CPUs that follow at the event
+    if( (current_cpu_ >= 0) && (time < target_) ) {
+        target_ = time > now_ ? time : now_;
+    }
+}
+
+void TScheduler::cancel( TSchedulerCallback callback, void * context )
+{
+    int count = 0;
+
+    for( int i=0; i<num_events_; i++ ) {
+        if( (events_[i].callback != callback) || (events_[i].context != context) ) {
+            events_[count++] = events_[i];
+        }
+    }
+
+    num_events_ = count;
+}
+
+void TScheduler::runFor( unsigned long long ticks )
+{
+    unsigned long long end = now_ + ticks;
+
+    while( now_ < end ) {
+        // Find the end of this slice
+        target_ = end;
+
+        if( (num_events_ > 0) && (events_[0].time < target_) ) {
+            target_ = events_[0].time > now_ ? events_[0].time : now_;
+        }
+
+        if( (quantum_ > 0) && (now_ + quantum_ < target_) ) {
+            target_ = now_ + quantum_;
+        }
+
+        // Bring all CPUs to the end of the slice (target may shrink meanwhile)
+        for( int i=0; i<num_cpus_; i++ ) {
+            TCpuInfo & info = cpus_[i];
+
+            if( info.time >= target_ ) {
+                continue;
+            }
+
+            if( ! info.enabled ) {
+                info.time = target_;
+                continue;
+            }
+
+            unsigned cycles = (unsigned) ((target_ - info.time + info.divider - 1) / info.divider);
+
+            current_cpu_ = i;
+            current_cycles_ = info.cpu->getCycles();
+
+            unsigned extra = info.cpu->run( cycles );
+
+            current_cpu_ = -1;
+
+            info.time += (unsigned long long) (cycles + extra) * info.divider;
+        }
+
+        now_ = target_;
+
+        // Invoke the events that are due (callbacks may post new events)
+        while( (num_events_ > 0) && (events_[0].time <= now_) ) {
+            TEvent event = events_[0];
+
+            num_events_--;
+
+            for( int i=0; i<num_events_; i++ ) {
+                events_[i] = events_[i+1];
+            }
+
+            event.callback( event.context, event.param );
+        }
+    }
+}
+
+void TScheduler::serialize( TStateStream & state )
+{
+    state.value( now_ );
+
+    for( int i=0; i<num_cpus_; i++ ) {
+        state.value( cpus_[i].time );
+        state.value( cpus_[i].enabled );
+    }
+
+    state.value( num_events_ );
+
+    if( num_events_ < 0 ) {
+        num_events_ = 0;
+        state.fail();
+        return;
+    }
+
+    reserveEvents( num_events_ );
+
+    state.bytes( events_, num_events_ * sizeof(TEvent) );
+}
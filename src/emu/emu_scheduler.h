@@ -0,0 +1,163 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#ifndef EMU_SCHEDULER_H_
+#define EMU_SCHEDULER_H_
+
+class TStateStream;
+
+/**
+    Interface of a processor that can be run by the scheduler.
+*/
+class TScheduledCpu
+{
+public:
+    /** Destructor. */
+    virtual ~TScheduledCpu() {
+    }
+
+    /**
+        Runs the CPU for the specified number of cycles.
+
+        @return the number of extra cycles executed by the last instruction
+    */
+    virtual unsigned run( unsigned cycles ) = 0;
+
+    /** Returns the value of the CPU cycle counter. */
+    virtual unsigned getCycles() const = 0;
+};
+
+typedef void (* TSchedulerCallback)( void * context, unsigned param );
+
+/**
+    Runs several CPUs on a shared timeline.
+
+    Time is measured in ticks of a 64-bit master clock, each CPU runs at the
+    master clock divided by an integer factor. The scheduler runs all CPUs up
+    to the next pending event (or for at most a quantum of time, if set),
+    then invokes the callbacks of the events that have come due. CPUs that
+    don't interact therefore run for long uninterrupted slices, and they are
+    only stopped around the events that synchronize them.
+
+    Events can be posted at any time, also by the CPUs while they are running
+    (e.g. when writing to a latch). In this case the slice of the CPUs that
+    follow in the run order is cut short at the event time. A CPU may post
+    any number of events during its slice, the queue grows as needed.
+*/
+class TScheduler
+{
+public:
+    enum {
+        MaxCpus = 4,
+        InitialEventCapacity = 32
+    };
+
+    TScheduler();
+
+    /** Destructor. */
+    ~TScheduler();
+
+    /**
+        Adds a CPU to the scheduler. CPUs run in the order they are added.
+
+        @param cpu CPU to run
+        @param clockDivider number of master clock ticks per CPU cycle
+
+        @return the CPU index, or -1 if there are too many CPUs
+    */
+    int addCpu( TScheduledCpu * cpu, unsigned clockDivider = 1 );
+
+    /**
+        Enables or disables a CPU. A disabled CPU does not run (e.g. because it's
+        being held in reset), but its time keeps up with the other CPUs.
+    */
+    void setCpuEnabled( int index, bool enabled );
+
+    /**
+        Sets the maximum length of a time slice, 0 (the default) for no limit.
+
+        Boards where the CPUs share memory may need a quantum to keep them
+        reasonably close to each other.
+    */
+    void setQuantum( unsigned long long ticks ) {
+        quantum_ = ticks;
+    }
+
+    /**
+        Returns the current time.
+
+        If called while a CPU is running, this is the local time of that CPU,
+        otherwise it is the time reached by all CPUs.
+    */
+    unsigned long long getTime() const;
+
+    /**
+        Posts an event. Events with the same time are invoked in the order they are posted.
+
+        @param time absolute time of the event (if in the past, the event is invoked at the end of the current slice)
+        @param callback function to invoke
+        @param context first parameter passed to the callback
+        @param param second parameter passed to the callback
+    */
+    void post( unsigned long long time, TSchedulerCallback callback, void * context, unsigned param = 0 );
+
+    /**
+        Posts an event at the specified delay from the current time (see getTime()).
+    */
+    void postAfter( unsigned long long delay, TSchedulerCallback callback, void * context, unsigned param = 0 ) {
+        post( getTime() + delay, callback, context, param );
+    }
+
+    /**
+        Removes all pending events with the specified callback and context.
+    */
+    void cancel( TSchedulerCallback callback, void * context );
+
+    /**
+        Runs the CPUs and invokes the events for the specified time.
+    */
+    void runFor( unsigned long long ticks );
+
+    /**
+        Saves or loads the time of the CPUs and the pending events.
+
+        Events are saved as they are, so the callbacks and contexts must still
+        be valid when the state is loaded.
+    */
+    void serialize( TStateStream & state );
+
+private:
+    TScheduler( const TScheduler & );
+    TScheduler & operator = ( const TScheduler & );
+
+    struct TCpuInfo {
+        TScheduledCpu * cpu;
+        unsigned divider;
+        unsigned long long time;
+        bool enabled;
+    };
+
+    struct TEvent {
+        unsigned long long time;
+        TSchedulerCallback callback;
+        void * context;
+        unsigned param;
+    };
+
+    void reserveEvents( int count );
+
+    TCpuInfo cpus_[MaxCpus];
+    int num_cpus_;
+    TEvent * events_; // Sorted by time
+    int num_events_;
+    int event_capacity_;
+    unsigned long long now_;
+    unsigned long long quantum_;
+    unsigned long long target_; // End of the current slice
+    int current_cpu_; // CPU running now, -1 if none
+    unsigned current_cycles_; // Cycle counter of the current CPU at the start of its slice
+};
+
+#endif // EMU_SCHEDULER_H_
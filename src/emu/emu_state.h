@@ -0,0 +1,91 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#ifndef EMU_STATE_H_
+#define EMU_STATE_H_
+
+#include "emu_iostream.h"
+
+/**
+    Saves or loads the state of a machine.
+
+    Each class with a state implements a serialize() method that passes all
+    of its members to the stream: the same method saves the state or loads it
+    back, depending on how the stream has been created. Values are stored as
+    they are in memory, without any conversion.
+
+    The class is entirely inline, so that the CPU, sound and ASE libraries can
+    use it without having to link the emulation library.
+*/
+class TStateStream
+{
+public:
+    /** Creates a stream that saves a state to the specified output stream. */
+    TStateStream( TOutputStream * os ) : is_(0), os_(os), ok_(true) {
+    }
+
+    /** Creates a stream that loads a state from the specified input stream. */
+    TStateStream( TInputStream * is ) : is_(is), os_(0), ok_(true) {
+    }
+
+    /** Returns true if the state is being loaded. */
+    bool isLoading() const {
+        return is_ != 0;
+    }
+
+    /** Returns false if the state could not be entirely read or written. */
+    bool ok() const {
+        return ok_;
+    }
+
+    /** Marks the state as invalid (e.g. because a loaded value is out of range). */
+    void fail() {
+        ok_ = false;
+    }
+
+    /** Saves or loads a block of memory. */
+    void bytes( void * data, unsigned len ) {
+        unsigned done = is_ != 0 ? is_->read( data, len ) : os_->write( (const char *) data, len );
+
+        if( done != len ) {
+            ok_ = false;
+        }
+    }
+
+    void value( bool & v ) {
+        bytes( &v, sizeof(v) );
+    }
+
+    void value( unsigned char & v ) {
+        bytes( &v, sizeof(v) );
+    }
+
+    void value( int & v ) {
+        bytes( &v, sizeof(v) );
+    }
+
+    void value( unsigned & v ) {
+        bytes( &v, sizeof(v) );
+    }
+
+    void value( unsigned long long & v ) {
+        bytes( &v, sizeof(v) );
+    }
+
+    void value( float & v ) {
+        bytes( &v, sizeof(v) );
+    }
+
+    void value( double & v ) {
+        bytes( &v, sizeof(v) );
+    }
+
+private:
+    TInputStream * is_;
+    TOutputStream * os_;
+    bool ok_;
+};
+
+#endif // EMU_STATE_H_
@@ -371,3 +371,20 @@ void TTickleMachine::run( TFrame * frame, unsigned samplesPerFrame, unsigned sam
         frame->setVideo( splash_ );
     }
 }
+
+bool TTickleMachine::serialize( TStateStream & state )
+{
+    state.value( last_device_ );
+    state.value( last_device_param_ );
+
+    // Pressed buttons and DIP switches are host inputs, only the test mode is machine state
+    unsigned test_mode = status_ & stTestMode;
+
+    state.value( test_mode );
+
+    if( state.isLoading() ) {
+        status_ = (status_ & ~stTestMode) | (test_mode & stTestMode);
+    }
+
+    return true;
+}
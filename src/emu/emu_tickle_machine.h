@@ -32,6 +32,8 @@ protected:
 
     virtual bool initialize( TMachineDriverInfo * info );
 
+    virtual bool serialize( TStateStream & state );
+
     static TMachine * createInstance() {
         return new TTickleMachine();
     }
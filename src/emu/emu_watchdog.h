@@ -6,6 +6,8 @@
 #ifndef EMU_WATCHDOG_H_
 #define EMU_WATCHDOG_H_
 
+#include "emu_state.h"
+
 class TWatchDog
 {
 public:
@@ -39,6 +41,10 @@ public:
         time_ = 0;
     }
 
+    void serialize( TStateStream & state ) {
+        state.value( time_ );
+    }
+
 private:
     int time_;
     int timeout_;
@@ -0,0 +1,13 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#include "emu_worker.h"
+
+TWorkerFactory TWorker::factory_ = 0;
+
+TWorker * TWorker::create()
+{
+    return factory_ != 0 ? factory_() : 0;
+}
@@ -0,0 +1,60 @@
+/*
+    Tickle class library
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#ifndef EMU_WORKER_H_
+#define EMU_WORKER_H_
+
+typedef void (* TWorkerFunction)( void * context );
+
+class TWorker;
+
+typedef TWorker * (* TWorkerFactory)();
+
+/**
+    Runs jobs on a separate thread.
+
+    The library has no threading code of its own: a front-end that can run
+    threads registers a factory with setFactory(), and components that can
+    make use of a worker (e.g. sound boards) ask for one with create(). If no
+    factory has been registered they just do all the work on the caller thread.
+*/
+class TWorker
+{
+public:
+    /** Destructor, waits for the current job to finish. */
+    virtual ~TWorker() {
+    }
+
+    /**
+        Starts a job on the worker thread.
+
+        The previous job, if any, must have been waited for with wait().
+    */
+    virtual void start( TWorkerFunction function, void * context ) = 0;
+
+    /**
+        Waits for the current job to finish, returns immediately if there is none.
+    */
+    virtual void wait() = 0;
+
+    /**
+        Creates a worker with the registered factory.
+
+        @return the new worker, or 0 if workers are not available
+    */
+    static TWorker * create();
+
+    /**
+        Sets the factory used by create(), 0 to disable workers.
+    */
+    static void setFactory( TWorkerFactory factory ) {
+        factory_ = factory;
+    }
+
+private:
+    static TWorkerFactory factory_;
+};
+
+#endif // EMU_WORKER_H_
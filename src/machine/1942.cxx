@@ -121,6 +121,7 @@ M1942::M1942( M1942MainBoard * board ) :
     sprite_data_( 16, 16*512 )  // 512 16x16 sprites
 {
     main_board_ = board;
+    main_board_->sound_board_ = &sound_board_;
 
     refresh_roms_ = true;
 
@@ -144,6 +145,7 @@ M1942::M1942( M1942MainBoard * board ) :
 
 M1942SoundBoard::M1942SoundBoard() : Z80_AY3_SoundBoard( 2, SoundCpuClock / 2, 0x4000, 0x0800, 0x4000 )
 {
+    sound_command_ = 0;
 }
 
 void M1942SoundBoard::run()
@@ -167,17 +169,22 @@ void M1942SoundBoard::onWriteByte( unsigned addr, unsigned char value )
             soundChip(0)->writeAddress(value);
             break;
         case 0x8001:
-            soundChip(0)->writeData(value);
+            soundChip(0)->writeData(value, getFrameCycle());
             break;
         case 0xC000:
             soundChip(1)->writeAddress(value);
             break;
         case 0xC001:
-            soundChip(1)->writeData(value);
+            soundChip(1)->writeData(value, getFrameCycle());
             break;
     }
 }
 
+void M1942SoundBoard::onCommand( unsigned char value )
+{
+    sound_command_ = value;
+}
+
 void M1942SoundBoard::onAfterSamplingStep( unsigned step )
 {
     // There are 12 sampling steps by default and we need 4 interrupts per frame
@@ -186,6 +193,13 @@ void M1942SoundBoard::onAfterSamplingStep( unsigned step )
     }
 }
 
+void M1942SoundBoard::serialize( TStateStream & state )
+{
+    Z80_AY3_SoundBoard::serialize( state );
+
+    state.value( sound_command_ );
+}
+
 unsigned char M1942SoundBoard::readPort( unsigned addr )
 {
     return 0;
@@ -213,10 +227,9 @@ M1942MainBoard::M1942MainBoard()
     dsw_a_ = 0xFF;
     dsw_b_ = 0xFF;
 
-    sound_command_ = 0;
-    sound_reset_ = false;
     palette_bank_ = 0;
     scroll_ = 0;
+    sound_board_ = 0;
 
     // Reset the machine
     reset();
@@ -227,10 +240,32 @@ void M1942MainBoard::reset()
     cpu_->reset();
 }
 
+void M1942MainBoard::serialize( TStateStream & state )
+{
+    unsigned bank = curr_rom_bank_ - rom_;
+
+    cpu_->serialize( state );
+
+    state.bytes( ram_, sizeof(ram_) );
+    state.bytes( video_ram_, sizeof(video_ram_) );
+    state.bytes( sprite_ram_, sizeof(sprite_ram_) );
+    state.value( bank );
+    state.value( palette_bank_ );
+    state.value( scroll_ );
+
+    if( bank > 3*0x4000 ) {
+        bank = 0;
+        state.fail();
+    }
+
+    curr_rom_bank_ = rom_ + bank;
+}
+
 void M1942MainBoard::run()
 {
-    sound_reset_ = false;
-    
+    // Count cycles from the start of the frame, that's the time seen by the sound board
+    cpu_->setCycles( 0 );
+
     // Run the main CPU
     cpu_->run( CpuCyclesPerFrame - CpuCyclesAfterInterrupt );
     cpu_->interrupt( 0xD7 ); // RST 10h
@@ -288,7 +323,7 @@ void M1942MainBoard::writeByte( unsigned addr, unsigned char b )
     }
     else switch( addr ) {
         case 0xC800:
-            sound_command_ = b;
+            sound_board_->writeCommand( cpu_->getCycles(), b );
             break;
         case 0xC802: 
             scroll_ = (scroll_ & 0xFF00) | b;
@@ -298,7 +333,7 @@ void M1942MainBoard::writeByte( unsigned addr, unsigned char b )
             break;
         case 0xC804:
             // Bit 0 is for the coin counter
-            if( b & 0x10 ) sound_reset_ = true;
+            if( b & 0x10 ) sound_board_->triggerReset( cpu_->getCycles() );
             break;
         case 0xC805:
             palette_bank_ = b & 3;
@@ -323,17 +358,26 @@ void M1942::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRate
         refresh_roms_ = false;
     }
 
-    // Run the main CPU
+    // Run the main CPU, the sound CPU only catches up when the main CPU talks to it
+    sound_board_.beginFrame( SoundCpuCyclesPerFrame, CpuCyclesPerFrame );
+
     main_board_->run();
-    
-    // Run the sound CPU
-    if( main_board_->sound_reset_ ) sound_board_.reset();
-    sound_board_.sound_command_ = main_board_->sound_command_;
-    sound_board_.run();
-    sound_board_.playSound( SoundCpuCyclesPerFrame, frame->getMixer(), samplesPerFrame, samplingRate );
+
+    // Run the sound CPU to the end of the frame
+    sound_board_.endFrame( frame->getMixer(), samplesPerFrame, samplingRate );
     
     // Render the video
-    frame->setVideo( renderVideo() );
+    if( ! frame->isHeadless() ) {
+        frame->setVideo( renderVideo() );
+    }
+}
+
+bool M1942::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+    sound_board_.serialize( state );
+
+    return true;
 }
 
 TBitmapIndexed * M1942::renderVideo()
@@ -22,6 +22,8 @@ struct M1942SoundBoard : public Z80_AY3_SoundBoard
     unsigned char onReadByte( unsigned addr );
     void onWriteByte( unsigned addr, unsigned char value );
     void onAfterSamplingStep( unsigned step );
+    void onCommand( unsigned char value );
+    void serialize( TStateStream & state );
     
     // Member variables
     unsigned timer_clock_;
@@ -40,6 +42,8 @@ struct M1942MainBoard : public Z80Environment
 
     void run();
 
+    void serialize( TStateStream & state );
+
     // Implementation of the Z80Environment interface
     unsigned char readByte( unsigned addr );
     void writeByte( unsigned, unsigned char );
@@ -55,11 +59,10 @@ struct M1942MainBoard : public Z80Environment
     unsigned char   port2_;                 // IN2
     unsigned char   dsw_a_;                 // DSW A
     unsigned char   dsw_b_;                 // DSW B
-    unsigned char   sound_command_;
-    bool            sound_reset_;
     unsigned        palette_bank_;
     int             scroll_;
     Z80 * cpu_;
+    M1942SoundBoard * sound_board_;
 };
 
 class M1942 : public TStandardMachine
@@ -84,6 +87,8 @@ protected:
 
     virtual bool initialize( TMachineDriverInfo * info );
 
+    virtual bool serialize( TStateStream & state );
+
     void onVideoROMsChanged();
     TBitmapIndexed * renderVideo();
 
@@ -166,3 +166,14 @@ void FantasyBoard::writeByte( unsigned addr, unsigned char b )
         NibblerBoard::writeByte( addr, b );
     }
 }
+
+void FantasyBoard::serialize( TStateStream & state )
+{
+    NibblerBoard::serialize( state );
+    
+    hd38880_.serialize( state );
+    
+    for( int i=0; i<12; i++ ) {
+        speech_samples_[i].serialize( state );
+    }
+}
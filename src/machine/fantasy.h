@@ -11,6 +11,8 @@
 struct FantasyBoard : public NibblerBoard
 {
     void writeByte( unsigned, unsigned char ); // To add the speech port
+    
+    virtual void serialize( TStateStream & state );
 
     Hd38880_SimWithSamples hd38880_;
     TSamplePlayer speech_samples_[12];
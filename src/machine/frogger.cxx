@@ -11,7 +11,6 @@ enum {
     FlipScreenY         = 0x02,
     InterruptEnabled    = 0x08,
     SoundInterrupt      = 0x10,
-    HaveSoundInterrupt  = 0x20,
     CoinMeter1          = 0x40,
     CoinMeter2          = 0x80,
 };
@@ -120,6 +119,7 @@ Frogger::Frogger( FroggerMainBoard * board ) :
     sprite_data_( 16, 16*64 )   // 64 16x16 sprites
 {
     main_board_ = board;
+    main_board_->sound_board_ = &sound_board_;
 
     refresh_roms_ = false;
 
@@ -187,7 +187,7 @@ void FroggerSoundBoard::writePort( unsigned addr, unsigned char value )
 {
     switch( addr & 0xFF ) {
     case 0x40: // AY-3-8910/2 write port
-        soundChip(0)->writeData( value );
+        soundChip(0)->writeData( value, getFrameCycle() );
         break;
     case 0x80: // AY-3-8910/2 control port
         soundChip(0)->writeAddress( value );
@@ -195,6 +195,13 @@ void FroggerSoundBoard::writePort( unsigned addr, unsigned char value )
     }
 }
 
+void FroggerSoundBoard::serialize( TStateStream & state )
+{
+    Z80_AY3_SoundBoard::serialize( state );
+
+    state.value( timer_clock_ );
+}
+
 FroggerMainBoard::FroggerMainBoard()
 {
     // Initialize the CPU and the RAM
@@ -210,7 +217,7 @@ FroggerMainBoard::FroggerMainBoard()
     coin_counter_1_ = 0;
     coin_counter_2_ = 0;
 
-    sound_command_ = 0;
+    sound_board_ = 0;
 
     // Reset the machine
     reset();
@@ -225,7 +232,8 @@ void FroggerMainBoard::reset()
 
 void FroggerMainBoard::run()
 {
-    setOutputFlipFlop( HaveSoundInterrupt, 0 );
+    // Count cycles from the start of the frame, that's the time seen by the sound board
+    cpu_->setCycles( 0 );
 
     cpu_->run( CpuCyclesPerFrame - CpuCyclesAfterInterrupt );
 
@@ -239,6 +247,18 @@ void FroggerMainBoard::run()
 
 }
 
+void FroggerMainBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+
+    state.bytes( ram_, sizeof(ram_) );
+    state.bytes( video_ram_, sizeof(video_ram_) );
+    state.bytes( special_ram_, sizeof(special_ram_) );
+    state.value( output_devices_ );
+    state.value( coin_counter_1_ );
+    state.value( coin_counter_2_ );
+}
+
 void FroggerMainBoard::setOutputFlipFlop( unsigned char bit, unsigned char value )
 {
     if( value ) {
@@ -334,13 +354,13 @@ void FroggerMainBoard::writeByte( unsigned addr, unsigned char b )
             case 0xD000:
             case 0xD001:
                 // 8255 chip #1 port A/AY-3-8910 port A (sound command)
-                sound_command_ = b;
+                sound_board_->writeCommand( cpu_->getCycles(), b );
                 break;
             case 0xD002:
             case 0xD003:
                 // 8255 chip #1 port A/AY-3-8910 port B (interrupt trigger on audio CPU)
                 if( (output_devices_ & SoundInterrupt) && (b == 0) ) {
-                    setOutputFlipFlop( HaveSoundInterrupt, 1 );
+                    sound_board_->triggerInterrupt( cpu_->getCycles(), 0x00 );
                 }
                 setOutputFlipFlop( SoundInterrupt, b & 0x08 );
                 break;
@@ -363,22 +383,26 @@ void Frogger::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRa
         refresh_roms_ = false;
     }
 
-    // Run the main CPU
+    // Run the main CPU, the sound CPU only catches up when the main CPU talks to it
+    sound_board_.beginFrame( SoundCpuCyclesPerFrame, CpuCyclesPerFrame );
+
     main_board_->run();
 
-    // Run the sound CPU
-    sound_board_.soundChip(0)->setRegister( AY_3_8910::PortA, main_board_->sound_command_ );
-    
-    if( main_board_->output_devices_ & HaveSoundInterrupt ) {
-        sound_board_.interrupt( 0x00 );
-    }
+    // Run the sound CPU to the end of the frame
+    sound_board_.endFrame( frame->getMixer(), samplesPerFrame, samplingRate );
 
-    sound_board_.run();
+    // Render the video
+    if( ! frame->isHeadless() ) {
+        frame->setVideo( renderVideo() );
+    }
+}
 
-    sound_board_.playSound( SoundCpuCyclesPerFrame, frame->getMixer(), samplesPerFrame, samplingRate );
+bool Frogger::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+    sound_board_.serialize( state );
 
-    // Render the video
-    frame->setVideo( renderVideo() );
+    return true;
 }
 
 void Frogger::decodeChar( const unsigned char * src, TBitBlock * bb, int ox, int oy, int planes, unsigned plane_size )
@@ -442,15 +466,14 @@ TBitmapIndexed * Frogger::renderVideo()
         for( int x=0; x<32; x++ ) {
             unsigned offset = 32*(31-x) + y;
 
-            int cx = ((x*8 + scroll) & 0xFF) - 16;
-            int cy = y*8;
-
-            if( cx >= -7 && cx < 224 ) {
-                if( mode & opFlipX ) cx = 216 - cx;
-                if( mode & opFlipY ) cy = 247 - cy;
-                screen()->bits()->copy( cx, cy, char_data_, 0, video[offset]*8, 8, 8, mode, blitter->color(color*4) );
-            }
+            tilemap_.setTile( x, y, video[offset], char_data_ );
         }
+
+        int cy = y*8;
+
+        if( mode & opFlipY ) cy = 247 - cy;
+
+        tilemap_.drawRow( screen()->bits(), y, scroll, cy, mode, color*4 );
     }
 
     // ...and finally the sprites
@@ -498,4 +521,6 @@ void Frogger::onVideoROMsChanged()
     for( i=0; i<64; i++ ) {
         decodeSprite( video_rom_ + 32*i, &sprite_data_, 0, 16*i );
     }
+
+    tilemap_.invalidate();
 }
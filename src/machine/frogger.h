@@ -9,6 +9,7 @@
 #include <emu/emu_standard_machine.h>
 #include <cpu/z80.h>
 
+#include "galaxian_tilemap.h"
 #include "z80_ay3_soundboard.h"
 
 struct FroggerSoundBoard : public Z80_AY3_SoundBoard
@@ -19,6 +20,7 @@ struct FroggerSoundBoard : public Z80_AY3_SoundBoard
     virtual void run();
     unsigned char readPort( unsigned addr );
     void writePort( unsigned addr, unsigned char value );
+    void serialize( TStateStream & state );
 
     // Member variables
     unsigned timer_clock_;
@@ -43,6 +45,8 @@ struct FroggerMainBoard : public Z80Environment
     // Utilities
     void setOutputFlipFlop( unsigned char bit, unsigned char value );
 
+    void serialize( TStateStream & state );
+
     // Member variables
     unsigned char   rom_[0x4000] ;          // ROM (16K)
     unsigned char   ram_[0x800];            // RAM (2K)
@@ -52,10 +56,10 @@ struct FroggerMainBoard : public Z80Environment
     unsigned char   port1_;                 // IN1
     unsigned char   port2_;                 // IN2
     unsigned char   output_devices_;        // Output flip-flops set by the game program
-    unsigned char   sound_command_;
     unsigned        coin_counter_1_;        // Coin meter 1
     unsigned        coin_counter_2_;        // Coin meter 2
     Z80 * cpu_;
+    FroggerSoundBoard * sound_board_;
 };
 
 class Frogger : public TStandardMachine
@@ -80,6 +84,8 @@ protected:
 
     virtual bool initialize( TMachineDriverInfo * info );
 
+    virtual bool serialize( TStateStream & state );
+
     void decodeChar( const unsigned char * src, TBitBlock * bb, int ox, int oy, int planes = 2, unsigned plane_size = 0x800 );
     void decodeSprite( const unsigned char * src, TBitBlock * bb, int ox, int oy );
     void onVideoROMsChanged();
@@ -98,6 +104,7 @@ protected:
     unsigned char palette_prom_[32];
     TBitBlock     char_data_;           // Character data for 256 8x8 characters
     TBitBlock     sprite_data_;         // Sprite data for 64 16x16 sprites
+    GalaxianTilemap tilemap_;           // Pre-rendered character rows
 };
 
 #endif // FROGGER_H_
@@ -14,6 +14,8 @@ enum {
     CpuClock                = 18432000 / 6,
     SoundClock              = CpuClock / 32,
     CpuCyclesPerFrame       = CpuClock / VideoFrequency,
+    CpuCyclesPerStep        = CpuCyclesPerFrame / 100, // The CPUs share memory, so keep them close to each other
+    Namco06xxCyclesBeforeNMI = 600
 };
 
 enum {
@@ -144,6 +146,17 @@ GalagaMainBoard::GalagaMainBoard() :
     cpu_2_ = aux_board_->cpu_;
     cpu_3_ = sound_board_->cpu_;
     
+    // All CPUs run on the same clock
+    scheduled_cpu_[0].setCpu( cpu_ );
+    scheduled_cpu_[1].setCpu( cpu_2_ );
+    scheduled_cpu_[2].setCpu( cpu_3_ );
+    
+    for( int i=0; i<3; i++ ) {
+        scheduler_.addCpu( &scheduled_cpu_[i] );
+    }
+    
+    scheduler_.setQuantum( CpuCyclesPerStep );
+    
     reset();
 
     cheat_ = 0;
@@ -155,9 +168,9 @@ GalagaMainBoard::GalagaMainBoard() :
     port_1_ = 0xFF;
 
     // The 54xx chip is not emulated yet, so explosion is simulated with a circuit derived by the Galaxian sound board
-    a_noise_ = new AWhiteNoise( 48000 ); // 24000/48000 are both passable
+    a_noise_ = new AWhiteNoise( ase_context_, 48000 ); // 24000/48000 are both passable
     a_noise_->setOutput( 3.4, 0.3 );
-    a_hit_latch_ = new ALatch; // Hit (explosion)
+    a_hit_latch_ = new ALatch( ase_context_ ); // Hit (explosion)
     a_hit_diode_ = new AClipperLo( *a_hit_latch_, 0.7 );
     a_hit_ = new ACapacitorWithSwitch( *a_hit_diode_, *a_noise_, Kilo(1), Kilo(100), Micro(2.2) );
     // There are three active bandpass filters on the board, only one is used here
@@ -203,7 +216,34 @@ void GalagaMainBoard::reset()
     namco51xx.reset();
     
     namco06xx_control_ = 0;
-    namco06xx_nmi_counter_ = 0;
+    
+    scheduler_.cancel( onNamco06xxNmi, this );
+    scheduler_.setCpuEnabled( 1, false );
+    scheduler_.setCpuEnabled( 2, false );
+}
+
+void GalagaMainBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+    cpu_2_->serialize( state );
+    cpu_3_->serialize( state );
+
+    state.bytes( video_ram_, sizeof(video_ram_) );
+    state.bytes( ram1_, sizeof(ram1_) );
+    state.bytes( ram2_, sizeof(ram2_) );
+    state.bytes( ram3_, sizeof(ram3_) );
+    state.value( cpu1_int_enabled_ );
+    state.value( cpu2_int_enabled_ );
+    state.value( cpu3_int_enabled_ );
+    state.value( halt_cpu23_ );
+    state.value( namco06xx_control_ );
+    state.value( frame_count_ );
+
+    namco05xx.serialize( state );
+    namco51xx.serialize( state );
+    sound_chip_.serialize( state );
+    scheduler_.serialize( state );
+    ase_context_.serialize( state );
 }
 
 unsigned char GalagaMainBoard::readByte( unsigned addr ) 
@@ -252,7 +292,7 @@ void GalagaMainBoard::writeByte( unsigned addr, unsigned char b )
     addr &= 0xFFFF;
     
     if( addr >= 0x6800 && addr < 0x6820 ) {
-        sound_chip_.setRegister( addr-0x6800, b );
+        sound_chip_.setRegister( addr-0x6800, b, cpu_3_->getCycles() );
     }
     else if( addr >= 0x8000 && addr < 0x8800 ) {
         video_ram_[addr - 0x8000] = b;
@@ -294,13 +334,18 @@ void GalagaMainBoard::writeByte( unsigned addr, unsigned char b )
                 cpu_2_->reset();
                 cpu_3_->reset();
             }
+            
+            scheduler_.setCpuEnabled( 1, ! halt_cpu23_ );
+            scheduler_.setCpuEnabled( 2, ! halt_cpu23_ );
             break;
         case 0x6830:
             // Watchdog reset
             break;
         case 0x7100:
             if( ((namco06xx_control_ & 0x0F) == 0) && ((b & 0x0F) != 0) ) {
-                namco06xx_nmi_counter_ = 0;
+                // Restart the NMI timer
+                scheduler_.cancel( onNamco06xxNmi, this );
+                scheduler_.postAfter( Namco06xxCyclesBeforeNMI, onNamco06xxNmi, this );
             }
             namco06xx_control_ = b;
             break;
@@ -417,52 +462,56 @@ bool Galaga::setResourceFile( int id, const unsigned char * buf, unsigned len )
     return 0 == resourceHandler()->handle( id, buf, len );
 }
 
-void GalagaMainBoard::run()
+void GalagaMainBoard::onCpu2Interrupt( void * board, unsigned )
+{
+    GalagaMainBoard * self = (GalagaMainBoard *) board;
+    
+    if( ! self->halt_cpu23_ && self->cpu2_int_enabled_ ) {
+        self->cpu_2_->interrupt(0xFF);
+    }
+}
+
+void GalagaMainBoard::onCpu3Nmi( void * board, unsigned )
 {
-    const int StepsPerFrame = 100;
-    const int CpuCyclesPerStep = CpuCyclesPerFrame / StepsPerFrame;
-    const int Cpu3_NMI1 = 8; // Too close to VBLANK and some sounds won't work, too far and it will freeze
-    const int Cpu3_NMI2 = Cpu3_NMI1 + (StepsPerFrame / 2);
-    const int VBLANK = 1;
-    const int Namco06xxCyclesBeforeNMI = 600;
+    GalagaMainBoard * self = (GalagaMainBoard *) board;
+    
+    if( ! self->halt_cpu23_ && self->cpu3_int_enabled_ ) {
+        self->cpu_3_->nmi();
+    }
+}
 
-    unsigned cycles_1 = 0;
-    unsigned cycles_2 = 0;
-    unsigned cycles_3 = 0;
+void GalagaMainBoard::onNamco06xxNmi( void * board, unsigned )
+{
+    GalagaMainBoard * self = (GalagaMainBoard *) board;
     
+    // The timer runs as long as the chip is active
+    if( self->namco06xx_control_ & 0x0F ) {
+        self->cpu_->nmi();
+        self->scheduler_.postAfter( Namco06xxCyclesBeforeNMI, onNamco06xxNmi, self );
+    }
+}
+
+void GalagaMainBoard::run()
+{
+    const unsigned Cpu3_NMI1 = 8; // Steps before the end of frame: too close to VBLANK and some sounds won't work, too far and it will freeze
+    const unsigned Cpu3_NMI2 = Cpu3_NMI1 + 50;
+    const unsigned Cpu2_VBLANK = 1;
+
     frame_count_++;
+
+    // Sound registers are written by the sound CPU, so use its clock for the log
+    sound_chip_.beginFrame( cpu_3_->getCycles(), CpuCyclesPerFrame );
     
-    for( int step=StepsPerFrame; step>0; step-- ) {
-        cycles_1 = cpu_->run( CpuCyclesPerStep - cycles_1 );
-        
-        if( ! halt_cpu23_ ) {
-            if( cpu2_int_enabled_ && step == VBLANK ) {
-                cpu_2_->interrupt(0xFF);
-            }
-            
-            cycles_2 = cpu_2_->run( CpuCyclesPerStep - cycles_2 );
-            
-            if( cpu3_int_enabled_ ) {
-                if( step == Cpu3_NMI1 || step == Cpu3_NMI2 ) {
-                    cpu_3_->nmi();
-                }
-            }
-            
-            cycles_3 = cpu_3_->run( CpuCyclesPerStep - cycles_3 );
-            
-        }
-        
-        if( cpu1_int_enabled_ && step == VBLANK ) {
-            cpu_->interrupt(0xFF);
-        }
-        
-        if( namco06xx_control_ & 0x0F ) {
-            namco06xx_nmi_counter_ += CpuCyclesPerStep;
-            if( namco06xx_nmi_counter_ >= Namco06xxCyclesBeforeNMI ) {
-                namco06xx_nmi_counter_ -= Namco06xxCyclesBeforeNMI;
-                cpu_->nmi();
-            }
-        }
+    unsigned long long start = scheduler_.getTime();
+    
+    scheduler_.post( start + CpuCyclesPerFrame - Cpu3_NMI2*CpuCyclesPerStep, onCpu3Nmi, this );
+    scheduler_.post( start + CpuCyclesPerFrame - Cpu3_NMI1*CpuCyclesPerStep, onCpu3Nmi, this );
+    scheduler_.post( start + CpuCyclesPerFrame - Cpu2_VBLANK*CpuCyclesPerStep, onCpu2Interrupt, this );
+    
+    scheduler_.runFor( CpuCyclesPerFrame );
+    
+    if( cpu1_int_enabled_ ) {
+        cpu_->interrupt(0xFF);
     }
 }
 
@@ -476,21 +525,27 @@ void Galaga::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRat
     main_board_->run();
 
     // Sound
-    TMixerBuffer * mixer_buffer = frame->getMixer()->getBuffer( chMono, samplesPerFrame, 3 );
+    TMixerBuffer * mixer_buffer = frame->getMixer()->getBus( "wsg", samplesPerFrame, 3 );
     
     main_board_->sound_chip_.setSamplingRate( samplingRate );
     main_board_->sound_chip_.playSound( mixer_buffer->data(), samplesPerFrame );
     
     // Explosion
-    mixer_buffer = frame->getMixer()->getBuffer( chMono, samplesPerFrame, 1 );
+    mixer_buffer = frame->getMixer()->getBus( "explosion", samplesPerFrame, 1 );
     
+    main_board_->ase_context_.setSamplingRate( samplingRate );
     main_board_->a_hit_filter_->resetStream();
     main_board_->a_hit_filter_->updateTo( samplesPerFrame );
     main_board_->a_hit_filter_->mixStream( mixer_buffer->data(), 51, 0, 255 ); // Noise must be clipped
     main_board_->a_hit_latch_->setValue( 0.3 );
     
+    // Scroll the starfield (also when the frame is not rendered)
+    main_board_->namco05xx.update();
+    
     // Render the video
-    frame->setVideo( renderVideo() );
+    if( ! frame->isHeadless() ) {
+        frame->setVideo( renderVideo() );
+    }
 }
 
 void Galaga::reset()
@@ -498,6 +553,13 @@ void Galaga::reset()
     main_board_->reset();
 }
 
+bool Galaga::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+
+    return true;
+}
+
 static const TDecodeCharInfo8x8 charLayout =
 {
     2,
@@ -564,7 +626,6 @@ TBitmapIndexed * Galaga::renderVideo()
     screen()->bits()->fill( palette_lookup_char_prom_[0] );
     
     // Draw the starfield...
-    main_board_->namco05xx.update();
     main_board_->namco05xx.render( screen() );
     
     // ...then add the sprites...
@@ -19,6 +19,7 @@
 
 #include "namco05.h"
 #include "namco51.h"
+#include "scheduled_z80.h"
 
 struct GalagaMainBoard;
 
@@ -63,11 +64,18 @@ struct GalagaMainBoard : public Z80Environment
     void run();
     
     void reset();
+
+    void serialize( TStateStream & state );
     
     // Implementation of the Z80Environment interface
     unsigned char readByte( unsigned addr );
     void writeByte( unsigned, unsigned char );
     
+    // Scheduler events
+    static void onCpu2Interrupt( void * board, unsigned param );
+    static void onCpu3Nmi( void * board, unsigned param );
+    static void onNamco06xxNmi( void * board, unsigned param );
+    
     // Member variables
     unsigned char   rom_[16*1024];           // ROM
     unsigned char   video_ram_[2*1024];
@@ -87,15 +95,17 @@ struct GalagaMainBoard : public Z80Environment
     unsigned char   port_0_;
     unsigned char   port_1_;
     unsigned char   namco06xx_control_;
-    unsigned        namco06xx_nmi_counter_;
     Namco05xx       namco05xx;
     Namco51xx       namco51xx;
     NamcoWsg3       sound_chip_;
     unsigned        frame_count_;
     unsigned char   cheat_;
     Z80 * cpu_;
+    TScheduler      scheduler_;
+    TScheduledZ80   scheduled_cpu_[3];
     
     // Explosion
+    AContext ase_context_;
     AWhiteNoise * a_noise_;
     ALatch * a_hit_latch_;
     AClipperLo * a_hit_diode_;
@@ -122,6 +132,8 @@ protected:
     Galaga();
     
     virtual bool initialize( TMachineDriverInfo * info );
+
+    virtual bool serialize( TStateStream & state );
     
     void onVideoROMsChanged();
     TBitmapIndexed * renderVideo();
@@ -271,6 +271,7 @@ void GalaxianMainBoard::run( TFrame * frame, unsigned samplesPerFrame, unsigned
     current_frame_size_ = samplesPerFrame;
 
     // Reset the sound system
+    soundboard_.setSamplingRate( samplingRate );
     soundboard_.startFrame();
 
     // Run the CPU
@@ -292,6 +293,20 @@ void GalaxianMainBoard::run( TFrame * frame, unsigned samplesPerFrame, unsigned
     soundboard_.endFrame( samplesPerFrame );
 }
 
+void GalaxianMainBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+
+    state.bytes( ram_, sizeof(ram_) );
+    state.bytes( video_ram_, sizeof(video_ram_) );
+    state.bytes( special_ram_, sizeof(special_ram_) );
+    state.value( output_devices_ );
+    state.value( coin_counter_ );
+    state.bytes( bank_select_, sizeof(bank_select_) );
+
+    soundboard_.serialize( state );
+}
+
 void GalaxianMainBoard::setOutputFlipFlop( unsigned char bit, unsigned char value )
 {
     if( value ) {
@@ -438,12 +453,14 @@ void Galaxian::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingR
     }
 
     // Render the video
-    frame->setVideo( renderVideo() );
+    if( ! frame->isHeadless() ) {
+        frame->setVideo( renderVideo() );
+    }
 
     // Render the sounds
     int voices = 5;
 
-    TMixerBuffer * mixer_buffer = frame->getMixer()->getBuffer( chMono, samplesPerFrame, voices );
+    TMixerBuffer * mixer_buffer = frame->getMixer()->getBus( "ase", samplesPerFrame, voices );
     int * dataBuffer = mixer_buffer->data();
 
     // TODO: there is an important caveat here!!! The sampling rate of the ASE
@@ -453,6 +470,17 @@ void Galaxian::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingR
     main_board_->soundboard_.playFrame( dataBuffer, samplesPerFrame );
 }
 
+bool Galaxian::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+
+    state.value( starfield_blink_state_ );
+    state.value( starfield_blink_timer_ );
+    state.value( starfield_scroll_pos_ );
+
+    return true;
+}
+
 void Galaxian::decodeChar( const unsigned char * src, TBitBlock * bb, int ox, int oy )
 {
     int planes = 2;
@@ -505,6 +533,8 @@ void Galaxian::onVideoROMsChanged()
     for( i=0; i<64*gfx_banks_; i++ ) {
         decodeSprite( video_rom_ + 32*i, &sprite_data_, 0, 16*i );
     }
+
+    tilemap_.invalidate();
 }
 
 void Galaxian::drawStarfield()
@@ -564,18 +594,14 @@ TBitmapIndexed * Galaxian::renderVideo()
         for( int x=0; x<32; x++ ) {
             unsigned offset = 32*(31-x) + y;
 
-            int cx = ((x*8 + scroll) & 0xFF) - 16;
-            int cy = y*8;
+            tilemap_.setTile( x, y, translateCharCode( video[offset] ), char_data_ );
+        }
 
-            if( cx >= -7 && cx < 224 ) {
-                if( mode & opFlipX ) cx = 216 - cx;
-                if( mode & opFlipY ) cy = 248 - cy;
+        int cy = y*8;
 
-                unsigned code = translateCharCode( video[offset] );
+        if( mode & opFlipY ) cy = 248 - cy;
 
-                screen()->bits()->copy( cx, cy, char_data_, 0, code*8, 8, 8, mode, blitter->color(color*4) );
-            }
-        }
+        tilemap_.drawRow( screen()->bits(), y, scroll, cy, mode, color*4 );
     }
 
     // ...then the bullets...
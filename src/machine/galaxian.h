@@ -10,6 +10,7 @@
 #include <cpu/z80.h>
 
 #include "galaxian_soundboard.h"
+#include "galaxian_tilemap.h"
 
 struct GalaxianMainBoard : public Z80Environment
 {
@@ -34,6 +35,8 @@ struct GalaxianMainBoard : public Z80Environment
 
     unsigned now();
 
+    void serialize( TStateStream & state );
+
     // Member variables
     unsigned char   rom_[16*1024];          // ROM
     unsigned char   ram_[ 2*1024];          // RAM
@@ -94,6 +97,8 @@ protected:
 
     virtual bool initialize( TMachineDriverInfo * info );
 
+    virtual bool serialize( TStateStream & state );
+
     void decodeChar( const unsigned char * src, TBitBlock * bb, int ox, int oy );
     void decodeSprite( const unsigned char * src, TBitBlock * bb, int ox, int oy );
     void onVideoROMsChanged();
@@ -124,6 +129,7 @@ protected:
     unsigned char palette_prom_[32];
     TBitBlock     char_data_;           // Character data for 256 8x8 characters
     TBitBlock     sprite_data_;         // Sprite data for 64 16x16 sprites
+    GalaxianTilemap tilemap_;           // Pre-rendered character rows
     // Not strictly part of original hardware, but very common modifications
     int           low_sprite_offset_;
     int           gfx_banks_;           // Allow an extra bank for sprites and characters
@@ -5,26 +5,47 @@
 
     Copyright (c) 2004 Alessandro Scotti
 */
+#include <emu/emu_state.h>
+
 #include "galaxian_soundboard.h"
 
 AGalaxianFireControl::AGalaxianFireControl( AChannel * ch_fire, AChannel * ch_noise ) 
+    : AChannel( ch_fire->context() )
 {
     a_fire_ = ch_fire;
     a_noise_ = ch_noise;
 
+    c28_ = 0;
+    c29_ = 0;
+
+    setCoefficients();
+}
+
+void AGalaxianFireControl::onSamplingRateChanged()
+{
+    setCoefficients();
+}
+
+void AGalaxianFireControl::setCoefficients()
+{
     AFloat R46 = Kilo( 10 );
     AFloat R47 = Kilo( 2.2 );
     AFloat R48 = Kilo( 2.2 );
     AFloat C28 = Micro( 47 );
     AFloat C29 = Micro( 0.01 );
 
-    c28_ = 0;
-    c29_ = 0;
+    a_[0] = 1 - context().getRCFactor( R47, C28 ); // Fire to C28 thru R47
+    a_[1] = 1 - context().getRCFactor( R48, C29 ); // C28 to C29 thru R48
+    a_[2] = 1 - context().getRCFactor( R46, C29 ); // Noise to C29 thru R46
+    a_[3] = 1 - context().getRCFactor( R48, C28 ); // C29 to C28 thru R48
+}
 
-    a_[0] = 1 - ASE::getRCFactor( R47, C28 ); // Fire to C28 thru R47
-    a_[1] = 1 - ASE::getRCFactor( R48, C29 ); // C28 to C29 thru R48
-    a_[2] = 1 - ASE::getRCFactor( R46, C29 ); // Noise to C29 thru R46
-    a_[3] = 1 - ASE::getRCFactor( R48, C28 ); // C29 to C28 thru R48
+void AGalaxianFireControl::serialize( TStateStream & state )
+{
+    AChannel::serialize( state );
+
+    state.value( c28_ );
+    state.value( c29_ );
 }
 
 void AGalaxianFireControl::updateBuffer( AFloat * buf, unsigned len, unsigned ofs )
@@ -61,18 +82,18 @@ void AGalaxianFireControl::updateBuffer( AFloat * buf, unsigned len, unsigned of
 GalaxianSoundBoard::GalaxianSoundBoard()
 {
     // Initialize the analog sound emulation
-    a_noise_ = new AWhiteNoise( 8000 );
+    a_noise_ = new AWhiteNoise( ase_context_, 8000 );
     a_noise_->setOutput( 3.4, 0.3 ); // 7474
-    a_hit_latch_ = new ALatch; // Hit
+    a_hit_latch_ = new ALatch( ase_context_ ); // Hit
     a_hit_diode_ = new AClipperLo( *a_hit_latch_, 0.7 ); // D1 (4148 diode)
     a_hit_ = new ACapacitorWithSwitch( *a_hit_diode_, *a_noise_, Kilo(1), Kilo(172), Micro(2.2) ); // R35+R36, C21
     a_hit_filter_ = new AActiveBandPassFilter( *a_hit_, Kilo(150), Kilo(22), Kilo(470), Micro(0.01), Micro(0.01) ); // R35, R36, R37, C22, C23, LM324
     a_hit_filter_->setGain( 2e+02 );
 
-    a_fire_latch_ = new ALatch; // Fire
+    a_fire_latch_ = new ALatch( ase_context_ ); // Fire
     a_fire_latch_inverter_ = new AInverter( *a_fire_latch_, 3.4, 0.3 ); // 7400 (actually a NAND gate)
     a_fire_control_ = new AGalaxianFireControl( a_fire_latch_inverter_, a_noise_ ); // R46, R47, R48, C28, C29
-    a_fire_timer_ = new ATimer555Astable( Kilo(10), Kilo(22), Micro(0.01) ); // R44, R45, C27
+    a_fire_timer_ = new ATimer555Astable( ase_context_, Kilo(10), Kilo(22), Micro(0.01) ); // R44, R45, C27
     a_fire_timer_->setControl( a_fire_control_, 1.0 );
     a_fire_diode_ = new AClipperLo( *a_fire_latch_, 0.7 ); // D2 (4148 diode)
     a_fire_ = new ACapacitorWithSwitch( *a_fire_diode_, *a_fire_timer_, Kilo(1), Kilo(100), Micro(1) ); // R41, C25
@@ -81,8 +102,8 @@ GalaxianSoundBoard::GalaxianSoundBoard()
     // change the signal shape much, only the amplitude. Since amplitude is handled later
     // anyway, emulation here is only concerned with preventing the discharge of capacitors.
 
-    a_fs_control_current_ = new ALatch(); // Current out of Q2
-    a_fs_control_ = new ATimer555LinearRamp( Micro(1) ); // C15
+    a_fs_control_current_ = new ALatch( ase_context_ ); // Current out of Q2
+    a_fs_control_ = new ATimer555LinearRamp( ase_context_, Micro(1) ); // C15
     a_fs_control_->setCurrent( a_fs_control_current_ );
     a_fs_control_amp_ = new AOpAmp_NonInv1( *a_fs_control_, Kilo(47), Kilo(47), Kilo(33), 5.0 ); // R31, R32, R33, LM324
     a_fs_control_res_[0] = 0.3;
@@ -90,9 +111,9 @@ GalaxianSoundBoard::GalaxianSoundBoard()
     a_fs_control_res_[2] = 0.3;
     a_fs_control_res_[3] = 0.3;
 
-    a_fs_[0] = new ATimer555Astable( Kilo(100), Kilo(470), Micro(0.01) ); // R22, R23, C17
-    a_fs_[1] = new ATimer555Astable( Kilo(100), Kilo(330), Micro(0.01) ); // R25, R26, C18
-    a_fs_[2] = new ATimer555Astable( Kilo(100), Kilo(220), Micro(0.01) ); // R28, R29, C19
+    a_fs_[0] = new ATimer555Astable( ase_context_, Kilo(100), Kilo(470), Micro(0.01) ); // R22, R23, C17
+    a_fs_[1] = new ATimer555Astable( ase_context_, Kilo(100), Kilo(330), Micro(0.01) ); // R25, R26, C18
+    a_fs_[2] = new ATimer555Astable( ase_context_, Kilo(100), Kilo(220), Micro(0.01) ); // R28, R29, C19
     
     for( int i=0; i<3; i++ ) {
         a_fs_[i]->setControl( a_fs_control_amp_, 1.0 );
@@ -191,7 +212,7 @@ void GalaxianSoundBoard::playFrame( int * buffer, unsigned bufsize )
     if( tone_pitch_ != 0xFF ) {
         unsigned period = (256 - tone_pitch_) << 6;
 
-        unsigned step = (ToneGeneratorClock << 10) / ASE::samplingRate;
+        unsigned step = (ToneGeneratorClock << 10) / ase_context_.samplingRate();
 
         unsigned volume = tone_volume_;
         unsigned offset = tone_offset_;
@@ -222,6 +243,18 @@ void GalaxianSoundBoard::playFrame( int * buffer, unsigned bufsize )
     a_hit_filter_->mixStream( buffer, 51, 0, 255 ); // Noise must be clipped
 }
 
+void GalaxianSoundBoard::serialize( TStateStream & state )
+{
+    ase_context_.serialize( state );
+
+    state.bytes( a_fs_control_res_, sizeof(a_fs_control_res_) );
+    state.value( tone_pitch_ );
+    state.value( tone_volume_ );
+    state.value( tone_offset_ );
+    state.value( tone_output_ );
+    state.value( tone_counter_ );
+}
+
 void GalaxianSoundBoard::writeToLatch9L( unsigned currentTimeInSamples, unsigned offset, unsigned char value )
 {
     value &= 1;
@@ -28,7 +28,22 @@ public:
 
     void updateBuffer( AFloat * buf, unsigned len, unsigned ofs );
 
+    virtual void serialize( TStateStream & state );
+
+    virtual unsigned inputCount() {
+        return 2;
+    }
+
+    virtual AChannel * input( unsigned index ) {
+        return (index == 0) ? a_fire_ : a_noise_;
+    }
+
+protected:
+    virtual void onSamplingRateChanged();
+
 private:
+    void setCoefficients();
+
     AChannel * a_fire_;
     AChannel * a_noise_;
     double a_[4];
@@ -42,12 +57,18 @@ struct GalaxianSoundBoard
 
     ~GalaxianSoundBoard();
 
+    void setSamplingRate( unsigned samplingRate ) {
+        ase_context_.setSamplingRate( samplingRate );
+    }
+
     void startFrame();
 
     void endFrame( unsigned offset );
 
     void playFrame( int * buffer, unsigned bufsize );
 
+    void serialize( TStateStream & state );
+
     void writeToLatch9L( unsigned currentTimeInSamples, unsigned offset, unsigned char value );
 
     void writeToLatch9M( unsigned currentTimeInSamples, unsigned offset, unsigned char value );
@@ -59,6 +80,7 @@ struct GalaxianSoundBoard
     unsigned    frame_size_;
 
     // Sound emulation
+    AContext                ase_context_;
     AWhiteNoise *           a_noise_;       // White noise generator
 
     ALatch *                a_hit_latch_;   // Hit input latch
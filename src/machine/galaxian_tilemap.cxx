@@ -0,0 +1,56 @@
+/*
+    Galaxian arcade machine emulator
+
+    Tilemap emulation
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#include <emu/emu_math.h>
+
+#include "galaxian_tilemap.h"
+
+GalaxianTilemap::GalaxianTilemap() :
+    strips_( 256, 32*8 )
+{
+    strips_.clear();
+    invalidate();
+}
+
+void GalaxianTilemap::invalidate()
+{
+    memset( codes_, 0xFF, sizeof(codes_) );
+}
+
+void GalaxianTilemap::drawRow( TBitBlock * screen, int y, unsigned scroll, int cy, unsigned mode, unsigned char color )
+{
+    TBltAddSrcZeroTrans         blitter_f( color );
+    TBltAddSrcZeroTransReverse  blitter_r( color );
+
+    // Find the strip pixel that goes into the first screen column, then copy
+    // the strip in two pieces to account for the wrap around
+    int w = screen->width();
+    int sx = (16 - scroll) & 0xFF;
+    int w1 = TMath::min( w, 256 - sx );
+    int w2 = w - w1;
+
+    for( int i=0; i<8; i++ ) {
+        int dy = (mode & opFlipY) ? cy + 7 - i : cy + i;
+
+        if( dy < 0 || dy >= screen->height() ) {
+            continue;
+        }
+
+        unsigned char * src = strips_.scanline_data( y*8 + i );
+        unsigned char * dst = screen->scanline_data( dy );
+
+        if( mode & opFlipX ) {
+            // Screen is mirrored, reverse blitters read the source backwards
+            blitter_r.blit( dst + w - w1, src + sx + w1, w1 );
+            blitter_r.blit( dst, src + w2, w2 );
+        }
+        else {
+            blitter_f.blit( dst, src + sx, w1 );
+            blitter_f.blit( dst + w1, src, w2 );
+        }
+    }
+}
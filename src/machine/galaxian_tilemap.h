@@ -0,0 +1,46 @@
+/*
+    Galaxian arcade machine emulator
+
+    Tilemap emulation
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#ifndef GALAXIAN_TILEMAP_H_
+#define GALAXIAN_TILEMAP_H_
+
+#include <emu/emu_bitblock.h>
+
+/**
+    Pre-rendered tilemap for the Galaxian hardware and its derivatives.
+
+    The hardware scrolls each row of 32 characters (a column on the original
+    rotated monitor) independently. Each row is kept in a 256x8 strip that is
+    updated only for the characters that have changed, and copied into the
+    screen at its scroll offset.
+*/
+class GalaxianTilemap
+{
+public:
+    GalaxianTilemap();
+
+    /** Forces all the strips to be redrawn, e.g. after the character set has changed. */
+    void invalidate();
+
+    /** Sets the character at the specified position, redrawing it only if changed. */
+    void setTile( int x, int y, unsigned code, TBitBlock & char_data ) {
+        if( codes_[y][x] != code ) {
+            codes_[y][x] = code;
+            strips_.copy( x*8, y*8, char_data, 0, code*8, 8, 8, 0, &copy_blitter_ );
+        }
+    }
+
+    /** Draws a row into the screen with transparency, using the same conventions as the tile renderer (cy is already flipped). */
+    void drawRow( TBitBlock * screen, int y, unsigned scroll, int cy, unsigned mode, unsigned char color );
+
+private:
+    TBitBlock   strips_;            // Raw character pixels (no color) for all the 32 rows
+    unsigned    codes_[32][32];     // Character codes currently drawn into the strips
+    TBltCopy    copy_blitter_;
+};
+
+#endif // GALAXIAN_TILEMAP_H_
@@ -69,6 +69,9 @@ bool SpaceInvaders::setResourceFile( int id, const unsigned char * buf, unsigned
     }
     else {
         result = 0 == resourceHandler()->handle( id, buf, len );
+        
+        // Color PROMs may have changed
+        repaintScreen();
     }
 
     return result;
@@ -133,10 +136,10 @@ SpaceInvaders::SpaceInvaders( SpaceInvadersBoard * board ) :
     walk_rcfilter_1_( 100.0, 0.0000047 ),   // R=100 ohm, C=4.7 uF
     walk_rcfilter_2_( 100.0, 0.000010 ),    // R=100 ohm, C=10 uF
     extend_play_timer_( 100000.0, 47000.0, 0.000001 ), // RA=100 Kohm, RB=47 Kohm, C=1 uF
-    ufo_hit_( 78, 85, 5.5 ),    // Data obtained by simulation in LTSpice
-    target_hit_( 4, 188, 4.0 ), // Data obtained by simulation in LTSpice (a value of 3 for the first parameter may be more accurate)
-    shot_( 8400 * 2 ),
-    flash_( 8400 / 2 ),
+    ufo_hit_( ase_context_, 78, 85, 5.5 ),    // Data obtained by simulation in LTSpice
+    target_hit_( ase_context_, 4, 188, 4.0 ), // Data obtained by simulation in LTSpice (a value of 3 for the first parameter may be more accurate)
+    shot_( ase_context_, 8400 * 2 ),
+    flash_( ase_context_, 8400 / 2 ),
     flash_rc1_( flash_, 560, Micro(0.1) ),
     flash_rc2_( flash_rc1_, Kilo(6.8), Micro(0.1) )
 {
@@ -202,6 +205,8 @@ SpaceInvaders::SpaceInvaders( SpaceInvadersBoard * board ) :
     shot_active_ = 0;
     
     flash_active_ = 0;
+    flash_graph_.addOutput( &flash_rc2_ );
+    flash_graph_.compile();
 
     // Initialize board
     main_board_ = board != 0 ? board : new SpaceInvadersBoard();
@@ -239,11 +244,8 @@ void SpaceInvaders::setActivePalette( unsigned char index )
 
 void SpaceInvaders::repaintScreen()
 {
-    // The following code force a refresh of the video RAM, which in
-    // turn updates our screen bitmap
-    for( unsigned addr=0x2400; addr<0x4000; addr++ ) {
-        main_board_->writeByte( addr, main_board_->ram_[addr] );
-    }
+    // Force a refresh of the whole video RAM at the next screen update
+    main_board_->invalidateScreen();
 }
 
 void SpaceInvaders::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRate )
@@ -257,6 +259,8 @@ void SpaceInvaders::run( TFrame * frame, unsigned samplesPerFrame, unsigned samp
     if( main_board_->port3o_ & 0x20 ) {
         if( settings_ & 0x10 ) {
             // Analog sound emulation
+            ase_context_.setSamplingRate( samplingRate );
+
             if( (main_board_->port5o_ & 0x10) && ((old_port5o & 0x10) == 0) ) {
                 ufo_hit_.play();
             }
@@ -306,7 +310,11 @@ void SpaceInvaders::run( TFrame * frame, unsigned samplesPerFrame, unsigned samp
         setActivePalette( settings_ & 0x07 ); // User settings
     }
 
-    frame->setVideo( screen() );
+    if( ! frame->isHeadless() ) {
+        main_board_->updateScreen();
+
+        frame->setVideo( screen() );
+    }
 }
 
 // Render the game sound by circuit emulation
@@ -418,7 +426,7 @@ void SpaceInvaders::renderAnalogSounds( TFrame * frame, unsigned samplesPerFrame
         if( flash_active_ == 0 ) frame->stopForceFeedbackEffect( 0 );
         
         flash_rc2_.resetStream();
-        flash_rc2_.updateTo( samplesPerFrame );
+        flash_graph_.updateTo( samplesPerFrame );
         flash_rc2_.mixStream( mixer_buffer->data(), 150, 0, 200 );
         voices++;
     }
@@ -451,6 +459,32 @@ void SpaceInvaders::reset()
     main_board_->reset();
 }
 
+bool SpaceInvaders::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+
+    for( int i=0; i<10; i++ ) {
+        samples_[i].serialize( state );
+    }
+
+    walk_timer_.serialize( state );
+    walk_rcfilter_1_.serialize( state );
+    walk_rcfilter_2_.serialize( state );
+    extend_play_timer_.serialize( state );
+    extend_play_tone_.serialize( state );
+    state.value( extend_play_vibrato_offset_ );
+
+    ase_context_.serialize( state );
+    ufo_hit_.serialize( state );
+    target_hit_.serialize( state );
+    state.value( shot_active_ );
+    state.value( flash_active_ );
+
+    ufo_sound_.serialize( state );
+
+    return true;
+}
+
 SpaceInvadersBoard::SpaceInvadersBoard()
 {
     vram_ = 0;
@@ -467,6 +501,8 @@ SpaceInvadersBoard::SpaceInvadersBoard()
     port4lo_ = 0;
     port4hi_ = 0;
     port5o_ = 0;
+    
+    invalidateScreen();
 
     reset();
 }
@@ -495,6 +531,22 @@ void SpaceInvadersBoard::reset()
     cpu_->reset();
 }
 
+void SpaceInvadersBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+
+    state.bytes( ram_+0x2000, 0x2000 ); // Skip the ROM
+    state.value( port2o_ );
+    state.value( port3o_ );
+    state.value( port4lo_ );
+    state.value( port4hi_ );
+    state.value( port5o_ );
+
+    if( state.isLoading() ) {
+        invalidateScreen();
+    }
+}
+
 unsigned char SpaceInvadersBoard::readByte( unsigned addr )
 {
     addr &= 0xFFFF;
@@ -507,26 +559,62 @@ void SpaceInvadersBoard::writeByte( unsigned addr, unsigned char b )
     addr &= 0xFFFF;
 
     if( (addr >= 0x2000) && addr < 0x4000 ) {
+        // Writes to video memory are only recorded here, the screen bitmap
+        // is updated once per frame by updateScreen()
+        if( addr >= 0x2400 && ram_[addr] != b ) {
+            block_dirty_[ getVideoBlock(addr) ] = 1;
+            screen_dirty_ = true;
+        }
+        
         ram_[addr] = b;
+    }
+}
 
-        if( addr >= 0x2400 ) {
-            // This is a write to video memory. Since the video screen is rotated, 
-            // consecutive bits correspond to vertically consecutive pixels.
-            // This is accounted for in the following code, and an extra buffer
-            // is used to store the video memory in a more useable form.
-		    addr -= 0x2400;
-
-            unsigned x = addr / 32;
-            unsigned y = addr % 32;
-            unsigned char * vram = vram_ + ((255-y*8)*224) + x;
-            unsigned char color = color_prom_[ 0x80 + y + ((x / 8) << 5)] & 0x07;
+// Table to expand a byte of video memory into 8 pixels (bit 0 is the leftmost pixel)
+struct VideoExpansionTable
+{
+    VideoExpansionTable() {
+        buildBitExpansionTable( pixels, 0xFF, false );
+    }
+    
+    unsigned char pixels[256][8];
+};
+
+static VideoExpansionTable VideoTable;
+
+void SpaceInvadersBoard::updateScreen()
+{
+    if( ! screen_dirty_ ) {
+        return;
+    }
+    
+    // Since the video screen is rotated, consecutive bits in a byte correspond
+    // to vertically consecutive pixels. Each block of 8x8 pixels is made of 8 bytes
+    // for adjacent columns: the block is transposed so that each byte becomes 
+    // a row of 8 pixels, which is then expanded and masked with the block color
+    for( unsigned block=0; block<VideoBlockCount; block++ ) {
+        if( block_dirty_[block] ) {
+            unsigned x = (block >> 5) * 8;
+            unsigned y = block & 0x1F;
+            unsigned char color = getBlockColor( block );
+            unsigned char rows[8];
+            
+            transposeBits8x8( rows, ram_ + 0x2400 + x*32 + y, 32 );
+            
             for( int i=0; i<8; i++ ) {
-                *vram = b & 1 ? color : 0;
-			    vram -= ScreenWidth;
-                b >>= 1;
+                const unsigned char * src = VideoTable.pixels[ rows[i] ];
+                unsigned char * dst = vram_ + (255-y*8-i)*ScreenWidth + x;
+                
+                for( int j=0; j<8; j++ ) {
+                    dst[j] = src[j] & color;
+                }
             }
+            
+            block_dirty_[block] = 0;
         }
     }
+    
+    screen_dirty_ = false;
 }
 
 unsigned char SpaceInvadersBoard::readPort( unsigned port )
@@ -753,7 +841,15 @@ unsigned char RollingCrashBoard::readByte( unsigned addr )
 void RollingCrashBoard::writeByte( unsigned addr, unsigned char b )
 {
     if( addr >= 0xA000 && addr <= 0xBFFF ) {
-        color_ram_[ remapColorRamAddr(addr-0xA000) ] = b;
+        unsigned offset = remapColorRamAddr(addr-0xA000);
+        
+        // Color RAM has the same layout as the video RAM blocks
+        if( offset >= 0x80 && color_ram_[offset] != b ) {
+            block_dirty_[ offset-0x80 ] = 1;
+            screen_dirty_ = true;
+        }
+        
+        color_ram_[offset] = b;
     }
     else if( addr >= 0xE400 && addr <= 0xFFFF ) { 
         extra_ram_[ addr-0xE400 ] = b;
@@ -763,6 +859,17 @@ void RollingCrashBoard::writeByte( unsigned addr, unsigned char b )
     }
 }
 
+void RollingCrashBoard::serialize( TStateStream & state )
+{
+    SpaceInvadersBoard::serialize( state );
+
+    state.bytes( color_ram_, sizeof(color_ram_) );
+    state.bytes( extra_ram_, sizeof(extra_ram_) );
+    state.value( port0o_ );
+    state.value( port0o_written_ );
+    state.value( port1o_written_ );
+}
+
 unsigned char RollingCrashBoard::readPort( unsigned port )
 {
     if( port == 0 ) {
@@ -804,25 +911,14 @@ void RollingCrashBoard::run()
     if( port0o_written_ ) {
         port3o_ = (port3o_ & ~0x07) | (port0o_ & 0x06) | ((port0o_ >> 4) & 1);
     }
+}
 
+unsigned char RollingCrashBoard::getBlockColor( unsigned block )
+{
     // The flyer for Rolling Crash shows that red and green are swapped
-    static unsigned MapGBR[8] = {0,4,2,6,1,3,5,7};
+    static unsigned char MapGBR[8] = {0,4,2,6,1,3,5,7};
     
-    // Draw the entire screen
-    for( unsigned addr=0x0000; addr<0x1C00; addr++ ) {
-        unsigned x = addr / 32;
-        unsigned y = addr % 32;
-        unsigned offset = remapColorRamAddr(addr+0x400);
-        unsigned char color = color_ram_[offset] & 0x07;
-        color = MapGBR[color];
-        unsigned char * vram = vram_ + ((255-y*8)*224) + x;
-        unsigned char b = ram_[addr+0x2400];
-        for( int i=0; i<8; i++ ) {
-            *vram = b & 1 ? color : 0;
-            vram -= ScreenWidth;
-            b >>= 1;
-        }
-    }
+    return MapGBR[ color_ram_[ 0x80 + block ] & 0x07 ];
 }
 
 bool RollingCrash::initialize( TMachineDriverInfo * info )
@@ -18,6 +18,7 @@
 
 #include <ase/ase_triangle_wave_vco1.h>
 #include <ase/ase_noise.h>
+#include <ase/ase_graph.h>
 #include <ase/ase_lowpass_filter.h>
 
 class T555Astable
@@ -67,6 +68,12 @@ public:
         }
     }
 
+    void serialize( TStateStream & state ) {
+        state.value( ra_ );
+        state.value( active_ );
+        wfg_.serialize( state );
+    }
+
     void setBuffer( int * data, unsigned len, unsigned samplingRate ) {
         if( active_ ) {
             wfg_.setBuffer( data, len, samplingRate );
@@ -89,10 +96,32 @@ struct SpaceInvadersBoard : public I8080Environment
 
     virtual void run();
     virtual void reset();
+    virtual void serialize( TStateStream & state );
     
     void setVram( unsigned char * vram ) {
         vram_ = vram;
     }
+    
+    // Video RAM is tracked in blocks of 8x8 pixels (8 bytes that are 32 bytes apart)
+    enum {
+        VideoBlockCount = 28*32
+    };
+    
+    static unsigned getVideoBlock( unsigned addr ) {
+        addr -= 0x2400;
+        return ((addr >> 8) << 5) | (addr & 0x1F);
+    }
+    
+    void invalidateScreen() {
+        memset( block_dirty_, 1, sizeof(block_dirty_) );
+        screen_dirty_ = true;
+    }
+    
+    void updateScreen();
+    
+    virtual unsigned char getBlockColor( unsigned block ) {
+        return color_prom_[ 0x80 + block ] & 0x07;
+    }
 
     // Implementation of the I8080Environment interface
     unsigned char readByte( unsigned addr );
@@ -111,6 +140,8 @@ struct SpaceInvadersBoard : public I8080Environment
     unsigned char   port4hi_;   // Port 4 out (hi)
     unsigned char   port5o_;    // Port 5 out
     unsigned char * vram_;
+    unsigned char   block_dirty_[VideoBlockCount];  // Video blocks written since last screen update
+    bool            screen_dirty_;                  // True if any entry in block_dirty_ is set
     unsigned char   color_prom_[2*1024];
     I8080 *         cpu_;
 };
@@ -145,6 +176,8 @@ protected:
 
     void setActivePalette( unsigned char palette );
 
+    virtual bool serialize( TStateStream & state );
+
     void renderAnalogSounds( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRate );
 
     void repaintScreen();
@@ -170,6 +203,7 @@ protected:
     TSquareWaveGenerator    extend_play_tone_;
     unsigned                extend_play_vibrato_offset_;
     
+    AContext                ase_context_;
     ATriangleWaveVCO        ufo_hit_;
     ATriangleWaveVCO        target_hit_;
     AWhiteNoise             shot_;
@@ -177,6 +211,7 @@ protected:
     AWhiteNoise             flash_;
     ALowPassRCFilter        flash_rc1_;
     ALowPassRCFilter        flash_rc2_;
+    AGraph                  flash_graph_;
     int                     flash_active_;
 
     SN76477                 ufo_sound_;
@@ -252,12 +287,15 @@ struct RollingCrashBoard : public SpaceInvadersBoard
     RollingCrashBoard();
 
     virtual void run();
+    virtual void serialize( TStateStream & state );
 
     unsigned char readByte( unsigned addr );
     void writeByte( unsigned, unsigned char );
     unsigned char readPort( unsigned port );
     void writePort( unsigned, unsigned char );
     
+    unsigned char getBlockColor( unsigned block );
+    
     // There is only 1K of color RAM but it is mapped on 13 address lines, of which 3 are ignored
     inline unsigned remapColorRamAddr( unsigned addr ) {
         return (addr & 0x1F) | ((addr & 0x1F00) >> 3);
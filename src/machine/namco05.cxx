@@ -292,6 +292,13 @@ void Namco05xx::writeRegister( unsigned index, unsigned char value )
     state_ |= (value & 1) << index;
 }
 
+void Namco05xx::serialize( TStateStream & state )
+{
+    state.value( state_ );
+    state.value( scroll_x_ );
+    state.value( scroll_y_ );
+}
+
 void Namco05xx::update()
 {
     static const int SpeedDelta[8] = { -3, -2, -1, 0, 3, 2, 1, 0 };
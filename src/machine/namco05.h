@@ -7,6 +7,7 @@
 #define NAMCO_05XX_
 
 #include <emu/emu_bitmap.h>
+#include <emu/emu_state.h>
 
 struct Namco05xx {
     unsigned char state_;
@@ -20,6 +21,8 @@ struct Namco05xx {
     void writeRegister( unsigned index, unsigned char value );
     
     void update();
+
+    void serialize( TStateStream & state );
     
     void render( TBitmapIndexed * screen );
 };
@@ -153,3 +153,14 @@ void Namco51xx::write( unsigned char b )
         }
     }
 }
+
+void Namco51xx::serialize( TStateStream & state )
+{
+    state.value( credits_ );
+    state.bytes( coins_, sizeof(coins_) );
+    state.bytes( creds_per_coin_, sizeof(creds_per_coin_) );
+    state.bytes( coins_per_cred_, sizeof(coins_per_cred_) );
+    state.value( data_count_ );
+    state.value( mode_ );
+    state.value( o_port0_ );
+}
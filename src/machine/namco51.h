@@ -6,6 +6,8 @@
 #ifndef NAMCO_51XX_
 #define NAMCO_51XX_
 
+#include <emu/emu_state.h>
+
 struct Namco5xCustom
 {
     virtual unsigned char read() = 0;
@@ -20,6 +22,8 @@ struct Namco51xx : public Namco5xCustom
     
     unsigned char read();
     void write( unsigned char b );
+
+    void serialize( TStateStream & state );
     
     int credits_;
     int coins_[2];
@@ -106,9 +106,11 @@ bool Nibbler::setResourceFile( int id, const unsigned char * buf, unsigned len )
 
 Nibbler::Nibbler( NibblerBoard * board ) :
     main_board_( board ),
-    fore_char_data( 8, 8*256 )
+    fore_char_data( 8, 8*256 ),
+    back_layer_( 256, 256 )
 {
     refresh_roms_ = false;
+    back_char_bank_ = 0;
     back_color_ = (unsigned) -1;
     char_data_[0] = new TBitBlock( 8, 8*256 );
     char_data_[1] = new TBitBlock( 8, 8*256 );
@@ -138,6 +140,13 @@ void Nibbler::reset()
     main_board_->reset();
 }
 
+bool Nibbler::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+
+    return true;
+}
+
 void Nibbler::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRate )
 {
     // Update if ROM changed since last frame
@@ -149,7 +158,9 @@ void Nibbler::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRa
     // Run the game for one frame
     main_board_->run();
 
-    frame->setVideo( renderVideo(), false );
+    if( ! frame->isHeadless() ) {
+        frame->setVideo( renderVideo(), false );
+    }
 
     // Play the music
     TMixerBuffer * mixer_buffer = frame->getMixer()->getBuffer( chMono, samplesPerFrame, 0 );
@@ -157,8 +168,9 @@ void Nibbler::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRa
     main_board_->sound_board_.play( mixer_buffer, samplesPerFrame, samplingRate );
     
     // Explosion
+    main_board_->ase_context_.setSamplingRate( samplingRate );
     main_board_->a_rc_filter_3_->resetStream();
-    main_board_->a_rc_filter_3_->updateTo( samplesPerFrame );
+    main_board_->a_graph_.updateTo( samplesPerFrame );
     main_board_->a_rc_filter_3_->mixStream( mixer_buffer->data(), HitStreamGain, 0, HitVolume ); // Noise must be clipped
     
     mixer_buffer->addVoices( 0 );
@@ -178,6 +190,8 @@ void Nibbler::onVideoROMsChanged()
     // Decode character set
     Vanguard::decodeCharSet( main_board_->ram_ + 0xC000, (unsigned char *) char_data_[1]->data(), 0x1000 );
     Vanguard::decodeCharSet( main_board_->ram_ + 0xC800, (unsigned char *) char_data_[0]->data(), 0x1000 );
+    
+    main_board_->invalidateTiles();
 }
 
 TBitmapIndexed * Nibbler::renderVideo()
@@ -186,9 +200,24 @@ TBitmapIndexed * Nibbler::renderVideo()
         palette()->setColor( i, palette_rgb_[ main_board_->back_color_ * 4 + 0x20 ] );
     }
     
-    Vanguard::decodeCharSet( main_board_->ram_ + 0x1000, (unsigned char *) fore_char_data.data(), 0x800 );
+    // Decode only the characters that have been modified by the CPU
+    if( main_board_->char_ram_dirty_ ) {
+        Vanguard::decodeDirtyChars( main_board_->ram_ + 0x1000, (unsigned char *) fore_char_data.data(), 0x800, main_board_->char_dirty_ );
+        main_board_->char_ram_dirty_ = false;
+    }
     
-    return Vanguard::renderVideo( screen(), main_board_->ram_, *char_data_[main_board_->char_bank_], fore_char_data, main_board_->back_color_, main_board_->scroll_x_, main_board_->scroll_y_ );
+    // Redraw only the background tiles that have been modified by the CPU (or all of them on a bank switch)
+    if( back_char_bank_ != main_board_->char_bank_ ) {
+        back_char_bank_ = main_board_->char_bank_;
+        main_board_->invalidateTiles();
+    }
+    
+    if( main_board_->tile_ram_dirty_ ) {
+        Vanguard::updateBackground( back_layer_, main_board_->ram_, *char_data_[back_char_bank_], main_board_->tile_dirty_ );
+        main_board_->tile_ram_dirty_ = false;
+    }
+    
+    return Vanguard::renderVideo( screen(), main_board_->ram_, back_layer_, fore_char_data, main_board_->scroll_x_, main_board_->scroll_y_ );
 }
 
 NibblerBoard::NibblerBoard() :
@@ -209,12 +238,18 @@ NibblerBoard::NibblerBoard() :
     scroll_y_ = 0;
     frame_counter_ = 0;
     
+    // Force a full decode of the character RAM on the first frame
+    memset( char_dirty_, 1, sizeof(char_dirty_) );
+    char_ram_dirty_ = true;
+    
+    invalidateTiles();
+    
     // In the Nibbler sound board a SN76477 is used to generate the noise signal. The noise frequency
     // is controlled by a 470K resistor connected to pin 4, which corresponds to approx 3082 Hz (see MAME driver for SN76477)
-    a_noise_ = new AWhiteNoise( SN76477::getNoiseFreqFromRes(Kilo(470)) ); // R50 connected to pin 4 of 76477
+    a_noise_ = new AWhiteNoise( ase_context_, SN76477::getNoiseFreqFromRes(Kilo(470)) ); // R50 connected to pin 4 of 76477
     a_noise_->setOutput( 3.4, 0.2 );
     a_noise_rc_filter_ = new ALowPassRCFilter( *a_noise_, Kilo(6.8), Micro(0.033) ); // R37, C25
-    a_hit_latch_ = new ALatch; // Hit (explosion)
+    a_hit_latch_ = new ALatch( ase_context_ ); // Hit (explosion)
     a_hit_diode_ = new AClipperLo( *a_hit_latch_, 0.7 ); // D3
     a_hit_ = new ACapacitorWithSwitch( *a_hit_diode_, *a_noise_rc_filter_, Kilo(1), Kilo(43), Micro(1) ); // R15, R52+R53, C24
     a_hit_filter_ = new AActiveBandPassFilter( *a_hit_, Kilo(10), Kilo(33), Kilo(470), Micro(0.01), Micro(0.01) ); // R52, R53, R48, C42, C41, LM324
@@ -222,6 +257,8 @@ NibblerBoard::NibblerBoard() :
     a_rc_filter_1_ = new ALowPassRCFilter( *a_hit_filter_, Kilo(22), Micro(0.01) ); // R57, C45
     a_rc_filter_2_ = new ALowPassRCFilter( *a_rc_filter_1_, Kilo(22), Micro(2.2) ); // R58, C46
     a_rc_filter_3_ = new ALowPassRCFilter( *a_rc_filter_2_, Kilo(22), Micro(0.001) ); // R59, C51
+    a_graph_.addOutput( a_rc_filter_3_ );
+    a_graph_.compile();
 }
 
 NibblerBoard::~NibblerBoard()
@@ -264,6 +301,29 @@ void NibblerBoard::run()
     }
 }
 
+void NibblerBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+    
+    state.bytes( ram_, 0x2000 ); // Skip the video and program ROMs
+    state.value( back_color_ );
+    state.value( char_bank_ );
+    state.value( frame_counter_ );
+    state.value( scroll_x_ );
+    state.value( scroll_y_ );
+    
+    sound_board_.serialize( state );
+    ase_context_.serialize( state );
+    
+    if( state.isLoading() ) {
+        // Redecode the character RAM and redraw the background
+        memset( char_dirty_, 1, sizeof(char_dirty_) );
+        char_ram_dirty_ = true;
+        
+        invalidateTiles();
+    }
+}
+
 unsigned char NibblerBoard::readByte( unsigned addr ) 
 {
     addr &= 0xFFFF;
@@ -296,6 +356,18 @@ void NibblerBoard::writeByte( unsigned addr, unsigned char b )
     addr &= 0xFFFF;
     
     if( addr < 0x2000 ) {
+        // 0x1000-0x1FFF: Character RAM
+        if( addr >= 0x1000 && ram_[addr] != b ) {
+            char_dirty_[ (addr >> 3) & 0xFF ] = 1;
+            char_ram_dirty_ = true;
+        }
+        
+        // Background tiles must be redrawn if their code or color changes
+        if( addr >= 0x0800 && addr < 0x1000 && ram_[addr] != b ) {
+            tile_dirty_[ addr & 0x3FF ] = 1;
+            tile_ram_dirty_ = true;
+        }
+        
         ram_[addr] = b;
     }
     
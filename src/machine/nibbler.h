@@ -14,6 +14,7 @@
 #include <ase/ase_latch.h>
 #include <ase/ase_noise.h>
 #include <ase/ase_capacitor_with_switch.h>
+#include <ase/ase_graph.h>
 #include <ase/ase_lowpass_filter.h>
 
 struct NibblerBoard : public N6502Environment
@@ -26,11 +27,19 @@ struct NibblerBoard : public N6502Environment
 
     virtual void run();
 
+    virtual void serialize( TStateStream & state );
+
     // Implementation of the N6502Environment interface
     unsigned char readByte( unsigned addr );
     void writeByte( unsigned, unsigned char );
     
     static void buildWaveform( int * waveform, int mask );
+    
+    // Force a redraw of all the background tiles
+    void invalidateTiles() {
+        memset( tile_dirty_, 1, sizeof(tile_dirty_) );
+        tile_ram_dirty_ = true;
+    }
 
     unsigned char   ram_[60*1024];
     unsigned char   dsw0_;
@@ -43,11 +52,16 @@ struct NibblerBoard : public N6502Environment
     unsigned        frame_counter_; // How many times run() has been called since last reset() 
     int             scroll_x_;
     int             scroll_y_;
+    unsigned char   char_dirty_[256];   // Characters modified in the character RAM since last decoded
+    bool            char_ram_dirty_;    // True if any entry in char_dirty_ is set
+    unsigned char   tile_dirty_[0x400]; // Background tiles modified in the video or color RAM since last drawn
+    bool            tile_ram_dirty_;    // True if any entry in tile_dirty_ is set
     N6502 *         cpu_;
     unsigned char   sound_rom_[0x1800];
     VanguardSoundBoard sound_board_;
     
     // Explosion
+    AContext ase_context_;
     AWhiteNoise * a_noise_;
     ALowPassRCFilter * a_noise_rc_filter_;
     ALatch * a_hit_latch_;
@@ -57,6 +71,7 @@ struct NibblerBoard : public N6502Environment
     ALowPassRCFilter * a_rc_filter_1_;
     ALowPassRCFilter * a_rc_filter_2_;
     ALowPassRCFilter * a_rc_filter_3_;
+    AGraph a_graph_;
 };
 
 /**
@@ -83,6 +98,8 @@ public:
 protected:
     virtual bool initialize( TMachineDriverInfo * info );
 
+    virtual bool serialize( TStateStream & state );
+
     Nibbler( NibblerBoard * );
 
     void onVideoROMsChanged();
@@ -99,6 +116,8 @@ protected:
     unsigned        palette_rgb_[64];   // Decoded palette PROM
     TBitBlock *     char_data_[2];  // Character data for 2 banks of 256 8x8 characters
     TBitBlock       fore_char_data; // Foreground character data (dynamically updated)
+    TBitBlock       back_layer_;    // Whole 256x256 background, scrolled into the screen
+    unsigned        back_char_bank_;// Character bank used to draw back_layer_
 };
 
 #endif // NIBBLER_H_
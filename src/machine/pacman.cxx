@@ -220,6 +220,14 @@ void Puckman::reset()
     frame_counter_ = 0;
 }
 
+bool Puckman::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+
+    state.value( frame_counter_ );
+
+    return true;
+}
 
 void Puckman::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRate )
 {
@@ -238,13 +246,13 @@ void Puckman::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRa
     // Render the video every other frame
     frame_counter_++;
 
-    if( frame_counter_ & 1 ) {
+    if( (frame_counter_ & 1) && ! frame->isHeadless() ) {
         frame->setVideo( renderVideo(), flip_monitor_ );
     }
 
     // Play the sound if enabled
     if( main_board_->output_devices_ & SoundEnabled ) {
-        TMixerBuffer * mixer_buffer = frame->getMixer()->getBuffer( chMono, samplesPerFrame, 3 );
+        TMixerBuffer * mixer_buffer = frame->getMixer()->getBus( "wsg", samplesPerFrame, 3 );
         int * data_buffer = mixer_buffer->data();
 
         // Let the chip play the sound
@@ -425,6 +433,8 @@ void PacmanBoard::reset()
 
 void PacmanBoard::run()
 {
+    sound_chip_.beginFrame( cpu_->getCycles(), CpuCyclesPerFrame );
+
     cpu_->run( CpuCyclesPerFrame );
 
     // If interrupts are enabled, force a CPU interrupt with the vector
@@ -434,6 +444,20 @@ void PacmanBoard::run()
     }
 }
 
+void PacmanBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+
+    state.bytes( ram_+0x4000, 0x1000 ); // Skip the ROM
+    state.bytes( sprite_coords_, sizeof(sprite_coords_) );
+    state.value( output_devices_ );
+    state.value( interrupt_vector_ );
+    state.value( coin_counter_ );
+
+    sound_chip_.serialize( state );
+    watchdog_.serialize( state );
+}
+
 unsigned char PacmanBoard::readByte( unsigned addr ) 
 {
     addr &= 0xFFFF;
@@ -501,7 +525,7 @@ void PacmanBoard::writeByte( unsigned addr, unsigned char b )
     }
     else if( addr >= 0x5040 && addr < 0x5060 ) {
         // Sound registers
-        sound_chip_.setRegister( addr-0x5040, b );
+        sound_chip_.setRegister( addr-0x5040, b, cpu_->getCycles() );
     }
     else if( addr >= 0x5060 && addr < 0x5070 ) {
         // Sprite coordinates
@@ -669,6 +693,13 @@ void MsPacmanBoard::writeByte( unsigned addr, unsigned char b )
     PacmanBoard::writeByte( addr, b );
 }
 
+void MsPacmanBoard::serialize( TStateStream & state )
+{
+    PacmanBoard::serialize( state );
+
+    state.value( aux_board_enabled_ );
+}
+
 void MsPacmanBoard::onROMsChanged( unsigned char * encrypted_rom )
 {
     unsigned i;
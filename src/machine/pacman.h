@@ -20,6 +20,8 @@ struct PacmanBoard : public Z80Environment
 
     virtual void run();
 
+    virtual void serialize( TStateStream & state );
+
     // Implementation of the Z80Environment interface
     unsigned char readByte( unsigned addr );
     void writeByte( unsigned, unsigned char );
@@ -68,6 +70,8 @@ public:
 protected:
     virtual bool initialize( TMachineDriverInfo * info );
 
+    virtual bool serialize( TStateStream & state );
+
     Puckman( PacmanBoard * );
 
     void decodeCharByte( unsigned char b, unsigned char * charbuf, int charx, int chary, int charwidth );
@@ -137,6 +141,8 @@ struct MsPacmanBoard : public PacmanBoard
 
     void onROMsChanged( unsigned char * encrypted_rom );
 
+    virtual void serialize( TStateStream & state );
+
     unsigned char rom_aux_[26*1024];        // 10K new ROM plus 16K to backup old ROM (because it gets patched)
     unsigned char aux_board_enabled_;       // Whether the aux board has been enabled or not
 };
@@ -211,6 +211,15 @@ void Pengo::reset()
     frame_counter_ = 0;
 }
 
+bool Pengo::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+
+    state.value( frame_counter_ );
+
+    return true;
+}
+
 void Pengo::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRate )
 {
     // Update if ROM changed since last frame
@@ -228,13 +237,13 @@ void Pengo::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRate
     // Render the video every other frame
     frame_counter_++;
 
-    if( frame_counter_ & 1 ) {
+    if( (frame_counter_ & 1) && ! frame->isHeadless() ) {
         frame->setVideo( renderVideo(), flip_monitor_ );
     }
 
     // Play the sound if enabled
     if( main_board_->output_devices_ & SoundEnabled ) {
-        TMixerBuffer * mixer_buffer = frame->getMixer()->getBuffer( chMono, samplesPerFrame, 3 );
+        TMixerBuffer * mixer_buffer = frame->getMixer()->getBus( "wsg", samplesPerFrame, 3 );
         int * data_buffer = mixer_buffer->data();
 
         // Let the chip play the sound
@@ -429,6 +438,8 @@ void PengoBoard::run()
     }
     
     // Run
+    sound_chip_.beginFrame( cpu_->getCycles(), CpuCyclesPerFrame );
+
     cpu_->run( CpuCyclesPerFrame );
 
     // If interrupts are enabled, force a CPU interrupt
@@ -437,6 +448,23 @@ void PengoBoard::run()
     }
 }
 
+void PengoBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+
+    state.bytes( ram_+0x8000, 0x1000 ); // Skip the ROM
+    state.bytes( sprite_coords_, sizeof(sprite_coords_) );
+    state.value( output_devices_ );
+    state.value( coin_counter1_ );
+    state.value( coin_counter2_ );
+    state.value( char_bank_ );
+    state.value( palette_bank_ );
+    state.value( color_bank_ );
+
+    sound_chip_.serialize( state );
+    watchdog_.serialize( state );
+}
+
 unsigned char PengoBoard::readByte( unsigned addr ) 
 {
     addr &= 0xFFFF;
@@ -484,7 +512,7 @@ void PengoBoard::writeByte( unsigned addr, unsigned char b )
     }
     else if( addr >= 0x9000 && addr < 0x9020 ) {
         // Sound registers
-        sound_chip_.setRegister( addr-0x9000, b );
+        sound_chip_.setRegister( addr-0x9000, b, cpu_->getCycles() );
     }
     else if( addr > 0x9020 && addr < 0x9030 ) {
         // Sprite coordinates
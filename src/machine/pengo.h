@@ -20,6 +20,8 @@ struct PengoBoard : public Z80Environment
 
     virtual void run();
 
+    void serialize( TStateStream & state );
+
     // Implementation of the Z80Environment interface
     unsigned char readByte( unsigned addr );
     void writeByte( unsigned, unsigned char );
@@ -73,6 +75,8 @@ public:
 protected:
     virtual bool initialize( TMachineDriverInfo * info );
 
+    virtual bool serialize( TStateStream & state );
+
     Pengo( PengoBoard * );
 
     void decodeCharByte( unsigned char b, unsigned char * charbuf, int charx, int chary, int charwidth );
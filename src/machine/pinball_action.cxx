@@ -9,7 +9,6 @@
 enum {
     FlipScreen          = 0x01,
     InterruptEnabled    = 0x08,
-    HaveSoundInterrupt  = 0x20,
 };
 
 // Hardware info
@@ -23,7 +22,9 @@ enum {
     CpuClock                = 4000000,
     SoundCpuClock           = 3072000,
     CpuCyclesPerFrame       = CpuClock / VideoFrequency,
-    SoundCpuCyclesPerFrame  = SoundCpuClock / VideoFrequency
+    SoundCpuCyclesPerFrame  = SoundCpuClock / VideoFrequency,
+    MasterClock             = 384000000, // Multiple of both CPU clocks
+    MasterTicksPerFrame     = MasterClock / VideoFrequency
 };
 
 enum { 
@@ -57,6 +58,13 @@ PinballAction::PinballAction() :
 
     refresh_roms_ = false;
 
+    // Setup the CPU scheduler: the CPUs only interact thru the sound command latch
+    scheduled_cpu_[0].setCpu( main_board_.cpu_ );
+    scheduled_cpu_[1].setCpu( sound_board_.cpu_ );
+    scheduler_.addCpu( &scheduled_cpu_[0], MasterClock / CpuClock );
+    scheduler_.addCpu( &scheduled_cpu_[1], MasterClock / SoundCpuClock );
+    main_board_.scheduler_ = &scheduler_;
+
     eventHandler()->add( idCoinSlot1,       ptNormal, &main_board_.port2_, 0x02 );
     eventHandler()->add( idCoinSlot2,       ptNormal, &main_board_.port2_, 0x01 );
     eventHandler()->add( idKeyStartPlayer1, ptNormal, &main_board_.port2_, 0x04 );
@@ -178,38 +186,22 @@ void PinballAction::run( TFrame * frame, unsigned samplesPerFrame, unsigned samp
 
     int shake = main_board_.shake_;
 
-    // Run the CPUs for one frame
-    TMixerBuffer * mixer_buffer = frame->getMixer()->getBuffer( chMono, samplesPerFrame, 9 );
-    int * data_buffer = mixer_buffer->data();
-    unsigned steps = 4; // Must be an even number
-    unsigned step_size = samplesPerFrame / steps;
-
-    // Make sure we process all samples by setting the proper size for the first step
-    unsigned len = samplesPerFrame - (steps-1)*step_size; 
-
-    for( unsigned i=0; i<steps; i++ ) {
-        main_board_.setOutputFlipFlop( HaveSoundInterrupt, 0 );
-
-        main_board_.cpu_->run( CpuCyclesPerFrame / steps );
-
-        if( main_board_.output_devices_ & HaveSoundInterrupt ) {
-            sound_board_.triggerInterrupt( 0x00 );
-        }
+    // Log sound chip writes for the whole frame
+    for( unsigned j=0; j<3; j++ ) {
+        sound_board_.sound_chip_[j].beginFrame( sound_board_.cpu_->getCycles(), SoundCpuCyclesPerFrame );
+    }
 
-        sound_board_.cpu_->run( SoundCpuCyclesPerFrame / steps );
+    // Run the CPUs for one frame, with a sound timer interrupt halfway
+    // (the other one is at the end of the frame)
+    scheduler_.post( scheduler_.getTime() + MasterTicksPerFrame / 2, PinballActionSoundBoard::onTimer, &sound_board_ );
+    scheduler_.runFor( MasterTicksPerFrame );
 
-        sound_board_.sound_chip_[0].playSound( data_buffer, len, samplingRate );
-        sound_board_.sound_chip_[1].playSound( data_buffer, len, samplingRate );
-        sound_board_.sound_chip_[2].playSound( data_buffer, len, samplingRate );
+    // Play the sound chips, applying the register writes where they happened
+    TMixerBuffer * mixer_buffer = frame->getMixer()->getBus( "psg", samplesPerFrame, 9 );
 
-        data_buffer += len;
-
-        if( i == (steps / 2) ) {
-            sound_board_.triggerInterrupt( 0x02 );
-        }
-
-        len = step_size;
-    }
+    sound_board_.sound_chip_[0].playSound( mixer_buffer->data(), samplesPerFrame, samplingRate );
+    sound_board_.sound_chip_[1].playSound( mixer_buffer->data(), samplesPerFrame, samplingRate );
+    sound_board_.sound_chip_[2].playSound( mixer_buffer->data(), samplesPerFrame, samplingRate );
 
     // Trigger vertical blank interrupts
     if( main_board_.output_devices_ & InterruptEnabled ) {
@@ -219,7 +211,9 @@ void PinballAction::run( TFrame * frame, unsigned samplesPerFrame, unsigned samp
     sound_board_.triggerInterrupt( 0x02 );
 
     // Render the video
-    frame->setVideo( renderVideo() );
+    if( ! frame->isHeadless() ) {
+        frame->setVideo( renderVideo() );
+    }
 
     // Apply force feedback effects
     if( (shake == 0) && (main_board_.shake_ != 0) ) {
@@ -227,6 +221,15 @@ void PinballAction::run( TFrame * frame, unsigned samplesPerFrame, unsigned samp
     }
 }
 
+bool PinballAction::serialize( TStateStream & state )
+{
+    main_board_.serialize( state );
+    sound_board_.serialize( state );
+    scheduler_.serialize( state );
+
+    return true;
+}
+
 void PinballAction::decodeChar( const unsigned char * src, TBitBlock * bb, int ox, int oy, int planes, unsigned plane_size )
 {
     for( int y=0; y<8; y++ ) {
@@ -312,6 +315,7 @@ PinballActionMainBoard::PinballActionMainBoard( PinballActionSoundBoard * sound_
     dip_switches_1_ = 0x00;
     shake_ = 0;
     sound_board_ = sound_board;
+    scheduler_ = 0;
 
     // Reset the machine
     reset();
@@ -324,6 +328,15 @@ void PinballActionMainBoard::reset()
     output_devices_ = 0;
 }
 
+void PinballActionMainBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+
+    state.bytes( ram_, sizeof(ram_) );
+    state.value( output_devices_ );
+    state.value( shake_ );
+}
+
 void PinballActionMainBoard::setOutputFlipFlop( unsigned char bit, unsigned char value )
 {
     if( value ) {
@@ -404,9 +417,8 @@ void PinballActionMainBoard::writeByte( unsigned addr, unsigned char b )
             shake_ = b - 3;
         }
         else if( addr == 0xE800 ) {
-            // Command for sound CPU
-            sound_board_->command_ = b;
-            setOutputFlipFlop( HaveSoundInterrupt, 1 );
+            // Command for sound CPU, delivered when the sound CPU has caught up with this one
+            scheduler_->post( scheduler_->getTime(), PinballActionSoundBoard::onCommand, sound_board_, b );
         }
     }
 }
@@ -432,9 +444,29 @@ void PinballActionSoundBoard::reset()
     cpu_->reset();
 }
 
+void PinballActionSoundBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+
+    state.bytes( ram_, sizeof(ram_) );
+    state.value( command_ );
+    state.value( interrupt_pending_ );
+
+    for( int i=0; i<3; i++ ) {
+        sound_chip_[i].serialize( state );
+    }
+}
+
 void PinballActionSoundBoard::triggerInterrupt( unsigned vector )
 {
     if( ! cpu_->interrupt( vector ) ) {
+        // Like the interrupt line, a burst of requests is taken only once
+        for( unsigned pending = interrupt_pending_; pending != 0; pending >>= 8 ) {
+            if( (pending & 0xFF) == vector+1 ) {
+                return;
+            }
+        }
+
         interrupt_pending_ = (interrupt_pending_ << 8) | (vector+1);
     }
 }
@@ -447,6 +479,19 @@ void PinballActionSoundBoard::onInterruptsEnabled()
     }
 }
 
+void PinballActionSoundBoard::onCommand( void * board, unsigned command )
+{
+    PinballActionSoundBoard * self = (PinballActionSoundBoard *) board;
+
+    self->command_ = (unsigned char) command;
+    self->triggerInterrupt( 0x00 );
+}
+
+void PinballActionSoundBoard::onTimer( void * board, unsigned )
+{
+    ((PinballActionSoundBoard *) board)->triggerInterrupt( 0x02 );
+}
+
 void PinballActionSoundBoard::run( int interrupt )
 {
     if( interrupt ) {
@@ -489,7 +534,7 @@ void PinballActionSoundBoard::writePort( unsigned addr, unsigned char value )
     case 0x11: 
     case 0x21: 
     case 0x31:
-        sound_chip_[(addr >> 4)-1].writeData( value );
+        sound_chip_[(addr >> 4)-1].writeData( value, cpu_->getCycles() );
         break;
     }
 }
@@ -10,6 +10,8 @@
 #include <cpu/z80.h>
 #include <sound/ay-3-8910.h>
 
+#include "scheduled_z80.h"
+
 struct PinballActionSoundBoard : public Z80Environment
 {
     PinballActionSoundBoard();
@@ -18,6 +20,7 @@ struct PinballActionSoundBoard : public Z80Environment
 
     void run( int interrupt );
     void reset();
+    void serialize( TStateStream & state );
 
     // Implementation of the Z80Environment interface
     unsigned char readByte( unsigned addr );
@@ -27,6 +30,10 @@ struct PinballActionSoundBoard : public Z80Environment
     
     void triggerInterrupt( unsigned vector );
 
+    // Scheduler events
+    static void onCommand( void * board, unsigned command );
+    static void onTimer( void * board, unsigned param );
+
     // Member variables
     unsigned char rom_[8*1024]; // ROM (8K)
     unsigned char ram_[2*1024]; // RAM (2K)
@@ -46,6 +53,8 @@ struct PinballActionMainBoard : public Z80Environment
 
     void reset();
 
+    void serialize( TStateStream & state );
+
     // Implementation of the Z80Environment interface
     unsigned char readByte( unsigned addr );
     void writeByte( unsigned, unsigned char );
@@ -65,6 +74,7 @@ struct PinballActionMainBoard : public Z80Environment
     int             shake_;
     Z80 * cpu_;
     PinballActionSoundBoard * sound_board_;
+    TScheduler * scheduler_;
 };
 
 /**
@@ -94,6 +104,8 @@ public:
 protected:
     PinballAction();
 
+    virtual bool serialize( TStateStream & state );
+
     void decodeChar( const unsigned char * src, TBitBlock * bb, int ox, int oy, int planes = 3, unsigned plane_size = 0x2000 );
     void decodeSprite( const unsigned char * src, TBitBlock * bb, int ox, int oy );
     void onVideoROMsChanged();
@@ -103,6 +115,8 @@ private:
     bool refresh_roms_; // True if ROM changed since last frame
     PinballActionSoundBoard sound_board_;
     PinballActionMainBoard main_board_;
+    TScheduler scheduler_;
+    TScheduledZ80 scheduled_cpu_[2];
     // Internal tables and structures for faster access to data
     unsigned char   video_rom_s_[24*1024];
     unsigned char   video_rom_j_[64*1024];
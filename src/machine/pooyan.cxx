@@ -12,7 +12,6 @@ enum {
     CoinMeter2          = 0x04,
     InterruptEnabled    = 0x08,
     SoundInterrupt      = 0x10,
-    HaveSoundInterrupt  = 0x20,
 };
 
 // Hardware info
@@ -191,17 +190,25 @@ void Pooyan::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRat
         refresh_roms_ = false;
     }
 
+    // Run the main CPU, the sound CPU only catches up when the main CPU talks to it
+    sound_board_.beginFrame( SoundCpuCyclesPerFrame, CpuCyclesPerFrame );
+
     main_board_->run();
 
-    if( main_board_->output_devices_ & HaveSoundInterrupt ) {
-        sound_board_.interrupt( 0xFF );
-    }
+    // Run the sound CPU to the end of the frame
+    sound_board_.endFrame( frame->getMixer(), samplesPerFrame, samplingRate );
 
-    sound_board_.run();
+    if( ! frame->isHeadless() ) {
+        frame->setVideo( renderVideo() );
+    }
+}
 
-    sound_board_.playSound( SoundCpuCyclesPerFrame, frame->getMixer(), samplesPerFrame, samplingRate );
+bool Pooyan::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+    sound_board_.serialize( state );
 
-    frame->setVideo( renderVideo() );
+    return true;
 }
 
 void Pooyan::decodeChar( const unsigned char * src, TBitBlock * bb, int ox, int oy )
@@ -347,7 +354,8 @@ void PooyanMainBoard::reset()
 
 void PooyanMainBoard::run()
 {
-    setOutputFlipFlop( HaveSoundInterrupt, 0 );
+    // Count cycles from the start of the frame, that's the time seen by the sound board
+    cpu_->setCycles( 0 );
 
     cpu_->run( CpuCyclesPerFrame );
 
@@ -358,6 +366,16 @@ void PooyanMainBoard::run()
     }
 }
 
+void PooyanMainBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+
+    state.bytes( ram_+32*1024, 6*1024 ); // Skip the ROM
+    state.value( output_devices_ );
+    state.value( coin_counter_1_ );
+    state.value( coin_counter_2_ );
+}
+
 void PooyanMainBoard::setOutputFlipFlop( unsigned char bit, unsigned char value )
 {
     if( value ) {
@@ -423,7 +441,7 @@ void PooyanMainBoard::writeByte( unsigned addr, unsigned char b )
             break;
         case 0xA100:
             // Audio CPU command
-            sound_board_->soundChip(0)->setRegister( AY_3_8910::PortA, b );
+            sound_board_->writeCommand( cpu_->getCycles(), b );
             break;
         case 0xA180:
             // Interrupt enable
@@ -432,7 +450,7 @@ void PooyanMainBoard::writeByte( unsigned addr, unsigned char b )
         case 0xA181:
             // Interrupt trigger on audio CPU
             if( (output_devices_ & SoundInterrupt) && (b == 0) ) {
-                setOutputFlipFlop( HaveSoundInterrupt, 1 );
+                sound_board_->triggerInterrupt( cpu_->getCycles(), 0xFF );
             }
             setOutputFlipFlop( SoundInterrupt, b & 0x01 );
             break;
@@ -473,6 +491,13 @@ void PooyanSoundBoard::run()
     Z80_AY3_SoundBoard::run();
 }
 
+void PooyanSoundBoard::serialize( TStateStream & state )
+{
+    Z80_AY3_SoundBoard::serialize( state );
+
+    state.value( timer_clock_ );
+}
+
 /*
     According to the MAME driver (timeplt.c) the clock that is connected
     to port B of the first AY-3-8910 uses the same (audio) CPU clock
@@ -507,11 +532,11 @@ unsigned char PooyanSoundBoard::onReadByte( unsigned addr )
 void PooyanSoundBoard::onWriteByte( unsigned addr, unsigned char value )
 {
     if( addr == 0x4000 )        // AY-3-8910/1 write port
-        soundChip(0)->writeData( value );
+        soundChip(0)->writeData( value, getFrameCycle() );
     else if( addr == 0x5000 ) // AY-3-8910/1 control port
         soundChip(0)->writeAddress( value );
     else if( addr == 0x6000 ) // AY-3-8910/2 write port
-        soundChip(1)->writeData( value );
+        soundChip(1)->writeData( value, getFrameCycle() );
     else if( addr == 0x7000 ) // AY-3-8910/2 control port
         soundChip(1)->writeAddress( value );
     
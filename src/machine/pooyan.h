@@ -19,6 +19,7 @@ struct PooyanSoundBoard : public Z80_AY3_SoundBoard
     virtual void run();
     unsigned char onReadByte( unsigned addr );
     void onWriteByte( unsigned addr, unsigned char value );
+    void serialize( TStateStream & state );
 
     // Member variables
     unsigned timer_clock_;
@@ -43,6 +44,8 @@ struct PooyanMainBoard : public Z80Environment
     // Utilities
     void setOutputFlipFlop( unsigned char bit, unsigned char value );
 
+    void serialize( TStateStream & state );
+
     // Member variables
     unsigned char   ram_[38*1024];          // ROM (32K) and RAM (6K)
     unsigned char   dip_switches_1_;        // DSW1
@@ -86,6 +89,8 @@ protected:
 
     virtual bool initialize( TMachineDriverInfo * info );
 
+    virtual bool serialize( TStateStream & state );
+
     void decodeChar( const unsigned char * src, TBitBlock * bb, int ox, int oy );
     void onVideoROMsChanged();
     TBitmapIndexed * renderVideo();
@@ -138,14 +138,16 @@ RallyXMainBoard::RallyXMainBoard() :
     // Reset the machine
     reset();
     
-    a_noise_ = new AWhiteNoise( 8000*6 ); // 4006 LFSR
+    a_noise_ = new AWhiteNoise( ase_context_, 8000*6 ); // 4006 LFSR
     a_noise_->setOutput( 3.4, 0.2 );
-    a_hit_latch_ = new ALatch; // Actually a 4066 switch in the schematics (no diode)
+    a_hit_latch_ = new ALatch( ase_context_ ); // Actually a 4066 switch in the schematics (no diode)
     a_hit_diode_ = new AClipperLo( *a_hit_latch_, 0.7 );
     a_hit_ = new ACapacitorWithSwitch( *a_hit_diode_, *a_noise_, Kilo(1), Kilo(172), Micro(1) );
     a_hit_filter_ = new AActiveBandPassFilter( *a_hit_, Kilo(150), Kilo(22), Kilo(470), Micro(0.01), Micro(0.01) );
     a_hit_filter_->setGain( HitFilterGain );
     a_rc_filter_1_ = new ALowPassRCFilter( *a_hit_filter_, Kilo(4.7), Micro(0.047) );
+    a_graph_.addOutput( a_rc_filter_1_ );
+    a_graph_.compile();
 }
 
 void RallyXMainBoard::reset()
@@ -161,6 +163,8 @@ void RallyXMainBoard::reset()
 
 void RallyXMainBoard::run()
 {
+    sound_chip_.beginFrame( cpu_->getCycles(), CpuCyclesPerFrame );
+
     cpu_->run( CpuCyclesPerFrame );
     
     if( irq_enabled_ ) {
@@ -216,7 +220,7 @@ void RallyXMainBoard::writeByte( unsigned addr, unsigned char b )
         radar_ram_[ addr-0xA000 ] = b;
     }
     else if( addr >= 0xA100 && addr < 0xA120 ) {
-        sound_chip_.setRegister( addr-0xA100, b );
+        sound_chip_.setRegister( addr-0xA100, b, cpu_->getCycles() );
     }
     else if( addr == 0xA130 ) {
         scroll_x_ = b;
@@ -248,11 +252,35 @@ void RallyXMainBoard::writePort( unsigned addr, unsigned char b )
     }
 }
 
+void RallyXMainBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+
+    state.bytes( ram_, sizeof(ram_) );
+    state.bytes( video_ram_, sizeof(video_ram_) );
+    state.bytes( radar_ram_, sizeof(radar_ram_) );
+    state.value( irq_opcode_ );
+    state.value( irq_enabled_ );
+    state.value( irq_missed_ );
+    state.value( scroll_x_ );
+    state.value( scroll_y_ );
+
+    sound_chip_.serialize( state );
+    ase_context_.serialize( state );
+}
+
 void RallyX::reset()
 {
     main_board_->reset();
 }
 
+bool RallyX::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+
+    return true;
+}
+
 void RallyX::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRate )
 {
     if( refresh_roms_ ) {
@@ -264,19 +292,22 @@ void RallyX::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRat
     main_board_->run();
 
     // Sound
-    TMixerBuffer * mixer_buffer = frame->getMixer()->getBuffer( chMono, samplesPerFrame, 3 );
+    TMixerBuffer * mixer_buffer = frame->getMixer()->getBus( "wsg", samplesPerFrame, 3 );
     
     main_board_->sound_chip_.setSamplingRate( samplingRate );
     main_board_->sound_chip_.playSound( mixer_buffer->data(), samplesPerFrame );
     
     // Bang
+    main_board_->ase_context_.setSamplingRate( samplingRate );
     main_board_->a_rc_filter_1_->resetStream();
-    main_board_->a_rc_filter_1_->updateTo( samplesPerFrame );
+    main_board_->a_graph_.updateTo( samplesPerFrame );
     main_board_->a_rc_filter_1_->mixStream( mixer_buffer->data(), HitStreamGain, 0, HitVolume ); // Noise must be clipped
     main_board_->a_hit_latch_->setValue(0.3);
     
     // Render the video
-    frame->setVideo( renderVideo() );
+    if( ! frame->isHeadless() ) {
+        frame->setVideo( renderVideo() );
+    }
 }
 
 TBitmapIndexed * RallyX::renderVideo()
@@ -16,6 +16,7 @@
 #include <ase/ase_latch.h>
 #include <ase/ase_noise.h>
 #include <ase/ase_capacitor_with_switch.h>
+#include <ase/ase_graph.h>
 #include <ase/ase_lowpass_filter.h>
 
 struct RallyXMainBoard : public Z80Environment
@@ -36,6 +37,8 @@ struct RallyXMainBoard : public Z80Environment
     void writePort( unsigned, unsigned char );
     void onInterruptsEnabled();
 
+    void serialize( TStateStream & state );
+
     // Member variables
     unsigned char   rom_[0x4000];       // ROM
     unsigned char   ram_[0x800];        // RAM (2K)
@@ -53,12 +56,14 @@ struct RallyXMainBoard : public Z80Environment
     Z80 * cpu_;
     
     // Bang
+    AContext ase_context_;
     AWhiteNoise * a_noise_;
     ALatch * a_hit_latch_;
     AClipperLo * a_hit_diode_;
     ACapacitorWithSwitch * a_hit_;
     AActiveBandPassFilter * a_hit_filter_;
     ALowPassRCFilter * a_rc_filter_1_;
+    AGraph a_graph_;
 };
 
 class RallyX : public TStandardMachine
@@ -83,6 +88,8 @@ protected:
 
     virtual bool initialize( TMachineDriverInfo * info );
 
+    virtual bool serialize( TStateStream & state );
+
     void onVideoROMsChanged();
     TBitmapIndexed * renderVideo();
 
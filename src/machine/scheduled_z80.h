@@ -0,0 +1,37 @@
+/*
+    Z80 adapter for the multi-CPU scheduler
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#ifndef SCHEDULED_Z80_H_
+#define SCHEDULED_Z80_H_
+
+#include <emu/emu_scheduler.h>
+#include <cpu/z80.h>
+
+/**
+    Lets a Z80 CPU be run by a TScheduler.
+*/
+class TScheduledZ80 : public TScheduledCpu
+{
+public:
+    TScheduledZ80( Z80 * cpu = 0 ) : cpu_(cpu) {
+    }
+
+    void setCpu( Z80 * cpu ) {
+        cpu_ = cpu;
+    }
+
+    virtual unsigned run( unsigned cycles ) {
+        return cpu_->run( cycles );
+    }
+
+    virtual unsigned getCycles() const {
+        return cpu_->getCycles();
+    }
+
+private:
+    Z80 * cpu_;
+};
+
+#endif // SCHEDULED_Z80_H_
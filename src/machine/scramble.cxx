@@ -12,7 +12,6 @@ enum {
     CoinMeter           = 0x04,
     InterruptEnabled    = 0x08,
     SoundInterrupt      = 0x10,
-    HaveSoundInterrupt  = 0x20,
     BackgroundEnabled   = 0x40,
     StarsEnabled        = 0x80,
 };
@@ -129,6 +128,7 @@ Scramble::Scramble( ScrambleMainBoard * board ) :
     sprite_data_( 16, 16*64 )   // 64 16x16 sprites
 {
     main_board_ = board;
+    main_board_->sound_board_ = &sound_board_;
     refresh_roms_ = false;
 
     createScreen( ScreenWidth, ScreenHeight, ScreenColors );
@@ -249,6 +249,12 @@ unsigned char ScrambleSoundBoard::readPort( unsigned addr )
     return 0;
 }
 
+void ScrambleSoundBoard::onCommand( unsigned char value )
+{
+    // The command latch is port A of the second sound chip
+    soundChip(1)->setRegister( AY_3_8910::PortA, value );
+}
+
 void ScrambleSoundBoard::writePort( unsigned addr, unsigned char value )
 {
     switch( addr & 0xFF ) {
@@ -256,17 +262,24 @@ void ScrambleSoundBoard::writePort( unsigned addr, unsigned char value )
         soundChip(0)->writeAddress( value );
         break;
     case 0x20: // AY-3-8910/1 write port
-        soundChip(0)->writeData( value );
+        soundChip(0)->writeData( value, getFrameCycle() );
         break;
     case 0x40: // AY-3-8910/2 control port
         soundChip(1)->writeAddress( value );
         break;
     case 0x80: // AY-3-8910/2 write port
-        soundChip(1)->writeData( value );
+        soundChip(1)->writeData( value, getFrameCycle() );
         break;
     }
 }
 
+void ScrambleSoundBoard::serialize( TStateStream & state )
+{
+    Z80_AY3_SoundBoard::serialize( state );
+
+    state.value( timer_clock_ );
+}
+
 ScrambleMainBoard::ScrambleMainBoard()
 {
     // Initialize the CPU and the RAM
@@ -280,7 +293,7 @@ ScrambleMainBoard::ScrambleMainBoard()
 
     coin_counter_ = 0;
 
-    sound_command_ = 0;
+    sound_board_ = 0;
 
     // Reset the machine
     reset();
@@ -294,7 +307,8 @@ void ScrambleMainBoard::reset()
 
 void ScrambleMainBoard::run()
 {
-    setOutputFlipFlop( HaveSoundInterrupt, 0 );
+    // Count cycles from the start of the frame, that's the time seen by the sound board
+    cpu_->setCycles( 0 );
 
     cpu_->run( CpuCyclesPerFrame - CpuCyclesAfterInterrupt );
 
@@ -308,6 +322,15 @@ void ScrambleMainBoard::run()
 
 }
 
+void ScrambleMainBoard::serialize( TStateStream & state )
+{
+    cpu_->serialize( state );
+
+    state.bytes( ram_+0x4000, sizeof(ram_)-0x4000 ); // Skip the ROM
+    state.value( output_devices_ );
+    state.value( coin_counter_ );
+}
+
 void ScrambleMainBoard::setOutputFlipFlop( unsigned char bit, unsigned char value )
 {
     if( value ) {
@@ -409,12 +432,12 @@ void ScrambleMainBoard::writeByte( unsigned addr, unsigned char b )
             break;
         case 0x8200:
             // 8255 chip #2 port A/AY-3-8910 #2 port A (sound command)
-            sound_command_ = b;
+            sound_board_->writeCommand( cpu_->getCycles(), b );
             break;
         case 0x8201:
             // 8255 chip #2 port A/AY-3-8910 #2 port B (interrupt trigger on audio CPU)
             if( (output_devices_ & SoundInterrupt) && (b == 0) ) {
-                setOutputFlipFlop( HaveSoundInterrupt, 1 );
+                sound_board_->triggerInterrupt( cpu_->getCycles(), 0x00 );
             }
             setOutputFlipFlop( SoundInterrupt, b & 0x08 );
             break;
@@ -439,19 +462,13 @@ void Scramble::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingR
         refresh_roms_ = false;
     }
 
-    // Run the main CPU
-    main_board_->run();
-
-    // Run the sound CPU
-    sound_board_.soundChip(1)->setRegister( AY_3_8910::PortA, main_board_->sound_command_ );
-    
-    if( main_board_->output_devices_ & HaveSoundInterrupt ) {
-        sound_board_.interrupt( 0x00 );
-    }
+    // Run the main CPU, the sound CPU only catches up when the main CPU talks to it
+    sound_board_.beginFrame( SoundCpuCyclesPerFrame, CpuCyclesPerFrame );
 
-    sound_board_.run();
+    main_board_->run();
 
-    sound_board_.playSound( SoundCpuCyclesPerFrame, frame->getMixer(), samplesPerFrame, samplingRate );
+    // Run the sound CPU to the end of the frame
+    sound_board_.endFrame( frame->getMixer(), samplesPerFrame, samplingRate );
 
     // Update the starfield state
     starfield_blink_timer_ += MicrosecondsPerFrame;
@@ -467,7 +484,21 @@ void Scramble::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingR
     }
 
     // Render the video
-    frame->setVideo( renderVideo() );
+    if( ! frame->isHeadless() ) {
+        frame->setVideo( renderVideo() );
+    }
+}
+
+bool Scramble::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+    sound_board_.serialize( state );
+
+    state.value( starfield_blink_state_ );
+    state.value( starfield_blink_timer_ );
+    state.value( starfield_scroll_pos_ );
+
+    return true;
 }
 
 void Scramble::decodeChar( const unsigned char * src, TBitBlock * bb, int ox, int oy, int planes, unsigned plane_size )
@@ -580,15 +611,14 @@ TBitmapIndexed * Scramble::renderVideo()
         for( int x=0; x<32; x++ ) {
             unsigned offset = 32*(31-x) + y;
 
-            int cx = ((x*8 + scroll) & 0xFF) - 16;
-            int cy = y*8;
-
-            if( cx >= -7 && cx < 224 ) {
-                if( mode & opFlipX ) cx = 216 - cx;
-                if( mode & opFlipY ) cy = 247 - cy;
-                screen()->bits()->copy( cx, cy, char_data_, 0, video[offset]*8, 8, 8, mode, blitter->color(color*4) );
-            }
+            tilemap_.setTile( x, y, video[offset], char_data_ );
         }
+
+        int cy = y*8;
+
+        if( mode & opFlipY ) cy = 247 - cy;
+
+        tilemap_.drawRow( screen()->bits(), y, scroll, cy, mode, color*4 );
     }
 
     // ...then the bullets...
@@ -643,6 +673,8 @@ void Scramble::onVideoROMsChanged()
     for( i=0; i<64; i++ ) {
         decodeSprite( video_rom_ + 32*i, &sprite_data_, 0, 16*i );
     }
+
+    tilemap_.invalidate();
 }
 
 AmidarOnScramble::AmidarOnScramble() : Scramble( new ScrambleMainBoard() )
@@ -9,6 +9,7 @@
 #include <emu/emu_standard_machine.h>
 #include <cpu/z80.h>
 
+#include "galaxian_tilemap.h"
 #include "z80_ay3_soundboard.h"
 
 struct ScrambleSoundBoard : public Z80_AY3_SoundBoard
@@ -19,6 +20,8 @@ struct ScrambleSoundBoard : public Z80_AY3_SoundBoard
     virtual void run();
     unsigned char readPort( unsigned addr );
     void writePort( unsigned addr, unsigned char value );
+    void onCommand( unsigned char value );
+    void serialize( TStateStream & state );
 
     // Member variables
     unsigned timer_clock_;
@@ -43,15 +46,17 @@ struct ScrambleMainBoard : public Z80Environment
     // Utilities
     void setOutputFlipFlop( unsigned char bit, unsigned char value );
 
+    void serialize( TStateStream & state );
+
     // Member variables
     unsigned char   ram_[0x50FF] ;          // ROM (16K), RAM (4K) and "special" RAM (sprites, stars, bullets)
     unsigned char   port0_;                 // IN0
     unsigned char   port1_;                 // IN1
     unsigned char   port2_;                 // IN2
     unsigned char   output_devices_;        // Output flip-flops set by the game program
-    unsigned char   sound_command_;
     unsigned        coin_counter_;          // Coin meter
     Z80 * cpu_;
+    ScrambleSoundBoard * sound_board_;
 };
 
 class Scramble : public TStandardMachine
@@ -76,6 +81,8 @@ protected:
 
     virtual bool initialize( TMachineDriverInfo * info );
 
+    virtual bool serialize( TStateStream & state );
+
     void decodeChar( const unsigned char * src, TBitBlock * bb, int ox, int oy, int planes = 2, unsigned plane_size = 0x800 );
     void decodeSprite( const unsigned char * src, TBitBlock * bb, int ox, int oy );
     void onVideoROMsChanged();
@@ -106,6 +113,7 @@ protected:
     unsigned char palette_prom_[32];
     TBitBlock     char_data_;           // Character data for 256 8x8 characters
     TBitBlock     sprite_data_;         // Sprite data for 64 16x16 sprites
+    GalaxianTilemap tilemap_;           // Pre-rendered character rows
     // Starfield emulation
     StarfieldItem starfield_[NumOfStars];   // Stars
     unsigned      starfield_blink_state_;   // Blink state
@@ -139,7 +139,8 @@ bool Vanguard::setResourceFile( int id, const unsigned char * buf, unsigned len
 Vanguard::Vanguard( VanguardBoard * board ) :
     main_board_( board ),
     back_char_data_( 8, 8*256 ),
-    fore_char_data_( 8, 256*8 )
+    fore_char_data_( 8, 256*8 ),
+    back_layer_( 256, 256 )
 {
     refresh_roms_ = false;
     back_color_ = (unsigned) -1;
@@ -177,6 +178,13 @@ void Vanguard::reset()
     main_board_->reset();
 }
 
+bool Vanguard::serialize( TStateStream & state )
+{
+    main_board_->serialize( state );
+
+    return true;
+}
+
 void Vanguard::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRate )
 {
     // Update if ROM changed since last frame
@@ -188,18 +196,20 @@ void Vanguard::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingR
     // Run the game for one frame
     main_board_->run();
 
-    frame->setVideo( renderVideo(), false );
+    if( ! frame->isHeadless() ) {
+        frame->setVideo( renderVideo(), false );
+    }
 
     // Play the explosion sound
-    if( main_board_->sn_bomb_.isOutputEnabled() ) {
-        TMixerBuffer * mixer_buffer = frame->getMixer()->getBuffer( chMono, samplesPerFrame, 1 );
+    if( main_board_->sn_bomb_.isOutputEnabled() || main_board_->sn_bomb_.hasLoggedChanges() ) {
+        TMixerBuffer * mixer_buffer = frame->getMixer()->getBus( "bomb", samplesPerFrame, 1 );
         
         main_board_->sn_bomb_.playSound( mixer_buffer->data(), samplesPerFrame, samplingRate );
     }
     
     // Play the "shot B" sound
-    if( main_board_->sn_shot_b_.isOutputEnabled() ) {
-        TMixerBuffer * mixer_buffer = frame->getMixer()->getBuffer( chMono, samplesPerFrame, 1 );
+    if( main_board_->sn_shot_b_.isOutputEnabled() || main_board_->sn_shot_b_.hasLoggedChanges() ) {
+        TMixerBuffer * mixer_buffer = frame->getMixer()->getBus( "shot_b", samplesPerFrame, 1 );
         
         main_board_->sn_shot_b_.playSound( mixer_buffer->data(), samplesPerFrame, samplingRate );
     }
@@ -218,19 +228,52 @@ void Vanguard::run( TFrame * frame, unsigned samplesPerFrame, unsigned samplingR
     main_board_->sample_bomb_.mix( frame->getMixer(), chMono, samplesPerFrame, samplingRate );
 }
 
+// Bit expansion tables for the two character planes (plane 0 is worth 1, plane 1 is worth 2)
+struct CharPlaneTables
+{
+    CharPlaneTables() {
+        buildBitExpansionTable( plane[0], 1, true );
+        buildBitExpansionTable( plane[1], 2, true );
+    }
+    
+    unsigned char plane[2][256][8];
+};
+
+static CharPlaneTables CharTables;
+
+void Vanguard::decodeChar( unsigned char * src, unsigned char * dst, unsigned plane_offset )
+{
+    unsigned char rows0[8];
+    unsigned char rows1[8];
+    
+    // Each source byte is a column of the character, turn columns into rows
+    transposeBits8x8( rows0, src+plane_offset, 1 );
+    transposeBits8x8( rows1, src, 1 );
+    
+    for( int y=0; y<8; y++ ) {
+        const unsigned char * p0 = CharTables.plane[0][ rows0[y] ];
+        const unsigned char * p1 = CharTables.plane[1][ rows1[y] ];
+        unsigned char * d = dst + 8*(7-y);
+        
+        for( int x=0; x<8; x++ ) {
+            d[x] = p0[x] | p1[x];
+        }
+    }
+}
+
 void Vanguard::decodeCharSet( unsigned char * b_src, unsigned char * b_dst, unsigned plane_offset )
 {
     for( int i=0; i<256; i++ ) {
-        unsigned char * src = b_src +  8*i;
-        unsigned char * dst = b_dst + 64*i;
-        
-        for( int y=0; y<8; y++ ) {
-            for( int x=0; x<8; x++ ) {
-                int o = 1 << y;
-                int b1 = src[x] & o ? 1 : 0;
-                int b0 = src[x+plane_offset] & o ? 1 : 0;
-                dst[ 8*(7-y) + 7-x ] = b0+b1*2;
-            }
+        decodeChar( b_src + 8*i, b_dst + 64*i, plane_offset );
+    }
+}
+
+void Vanguard::decodeDirtyChars( unsigned char * b_src, unsigned char * b_dst, unsigned plane_offset, unsigned char * dirty )
+{
+    for( int i=0; i<256; i++ ) {
+        if( dirty[i] ) {
+            decodeChar( b_src + 8*i, b_dst + 64*i, plane_offset );
+            dirty[i] = 0;
         }
     }
 }
@@ -248,41 +291,53 @@ void Vanguard::onVideoROMsChanged()
 
     // Decode character set
     decodeCharSet( main_board_->ram_ + 0x2000, (unsigned char *) back_char_data_.data(), 0x800 );
+    
+    main_board_->invalidateTiles();
 }
 
-TBitmapIndexed * Vanguard::renderVideo( TBitmapIndexed * screen, unsigned char * ram, TBitBlock & back_char_data, TBitBlock & fore_char_data, unsigned back_color, int scroll_x, int scroll_y )
+// Redraw the background tiles that have changed since last frame
+void Vanguard::updateBackground( TBitBlock & back_layer, unsigned char * ram, TBitBlock & back_char_data, unsigned char * dirty )
 {
-    // Render background characters
     unsigned char * video_ram = ram + 0x800;
     unsigned char * color_ram = ram + 0xC00;
     
-    TBltAdd bg_blitter_f(back_color);
-    TBltAdd * bg_blitter = &bg_blitter_f;
+    TBltAdd bg_blitter( 0 );
     
-    for( int cx=0; cx<32; cx++ ) {
-        for( int cy=0; cy<32; cy++ ) {
-            // Get the offset of this location in the video RAM
-            unsigned offset = 32*(31-cx) + cy;
-            
+    for( unsigned offset=0; offset<0x400; offset++ ) {
+        if( dirty[offset] ) {
             unsigned char v = video_ram[offset];
             unsigned char c = (color_ram[offset] & 0x38) >> 3;
             
-            int x = cx*8 + scroll_x;
-            int y = cy*8 - scroll_y;
+            int cx = 31 - (offset / 32);
+            int cy = offset % 32;
             
-            if( x <    0 ) x += 256;
-            if( x >= 256 ) x -= 256;
-            if( y <    0 ) y += 256;
-            if( y >= 256 ) y -= 256;
+            back_layer.copy( cx*8, cy*8, back_char_data, 0, 8*v, 8, 8, opAdd, bg_blitter.color(c*4+0x20) );
             
-            x -= 32;
-            
-            screen->bits()->copy( x, y, back_char_data, 0, 8*v, 8, 8, opAdd, bg_blitter->color(c*4+0x20) );
+            dirty[offset] = 0;
         }
     }
+}
+
+TBitmapIndexed * Vanguard::renderVideo( TBitmapIndexed * screen, unsigned char * ram, TBitBlock & back_layer, TBitBlock & fore_char_data, int scroll_x, int scroll_y )
+{
+    // Copy the background into the screen, wrapping around the edges of the layer
+    TBitBlock * bits = screen->bits();
+    
+    int vx = (32 - scroll_x) & 0xFF;
+    int w1 = TMath::min( bits->width(), back_layer.width() - vx );
+    int w2 = bits->width() - w1;
+    
+    for( int y=0; y<bits->height(); y++ ) {
+        unsigned char * src = back_layer.scanline_data( (y + scroll_y) & 0xFF );
+        unsigned char * dst = bits->scanline_data( y );
+        
+        memcpy( dst, src + vx, w1 );
+        memcpy( dst + w1, src, w2 );
+    }
     
     // Render foreground characters (sprites)
-    video_ram = ram + 0x400;
+    unsigned char * video_ram = ram + 0x400;
+    unsigned char * color_ram = ram + 0xC00;
     
     TBltAddSrcZeroTrans fg_blitter_f( 0 );
     TBltAddSrcZeroTrans * fg_blitter = &fg_blitter_f;
@@ -295,7 +350,7 @@ TBitmapIndexed * Vanguard::renderVideo( TBitmapIndexed * screen, unsigned char *
             unsigned char v = video_ram[offset];
             unsigned char c = color_ram[offset] & 0x07;
             
-            screen->bits()->copy( (cx-4)*8, cy*8, fore_char_data, 0, 8*v, 8, 8, opAdd, fg_blitter->color(c*4) );
+            bits->copy( (cx-4)*8, cy*8, fore_char_data, 0, 8*v, 8, 8, opAdd, fg_blitter->color(c*4) );
         }
     }
     
@@ -310,9 +365,19 @@ TBitmapIndexed * Vanguard::renderVideo()
         palette()->setColor( i, palette_rgb_[ main_board_->back_color_ * 4 + 0x20 ] );
     }
 
-    decodeCharSet( main_board_->ram_ + 0x1000, (unsigned char *) fore_char_data_.data(), 0x800 );
+    // Decode only the characters that have been modified by the CPU
+    if( main_board_->char_ram_dirty_ ) {
+        decodeDirtyChars( main_board_->ram_ + 0x1000, (unsigned char *) fore_char_data_.data(), 0x800, main_board_->char_dirty_ );
+        main_board_->char_ram_dirty_ = false;
+    }
+    
+    // Redraw only the background tiles that have been modified by the CPU
+    if( main_board_->tile_ram_dirty_ ) {
+        updateBackground( back_layer_, main_board_->ram_, back_char_data_, main_board_->tile_dirty_ );
+        main_board_->tile_ram_dirty_ = false;
+    }
 
-    return renderVideo( screen(), main_board_->ram_, back_char_data_, fore_char_data_, main_board_->back_color_, main_board_->scroll_x_, main_board_->scroll_y_ );
+    return renderVideo( screen(), main_board_->ram_, back_layer_, fore_char_data_, main_board_->scroll_x_, main_board_->scroll_y_ );
 }
 
 static const unsigned SpeechAddressTable[16] = {
@@ -353,6 +418,12 @@ VanguardBoard::VanguardBoard() :
     scroll_y_ = 0;
     frame_counter_ = 0;
     o_port_3100_ = 0;
+    
+    // Force a full decode of the character RAM on the first frame
+    memset( char_dirty_, 1, sizeof(char_dirty_) );
+    char_ram_dirty_ = true;
+    
+    invalidateTiles();
 
     hd38880_.setSamples( 16, SpeechAddressTable, speech_samples_ );
     
@@ -389,6 +460,9 @@ void VanguardBoard::run()
     frame_counter_++;
     
     // Run
+    sn_bomb_.beginFrame( cpu_->getCycles(), CpuCyclesPerFrame );
+    sn_shot_b_.beginFrame( cpu_->getCycles(), CpuCyclesPerFrame );
+
     cpu_->run( CpuCyclesPerFrame );
     
     unsigned char o_port2 = port2_ & 3;
@@ -404,6 +478,41 @@ void VanguardBoard::run()
     }
 }
 
+void VanguardBoard::serialize( TStateStream & state )
+{
+    int i;
+    
+    cpu_->serialize( state );
+    
+    state.bytes( ram_, 0x2000 ); // Skip the video and program ROMs
+    state.value( o_port_3100_ );
+    state.value( cheat_multi_fire_ );
+    state.value( back_color_ );
+    state.value( frame_counter_ );
+    state.value( scroll_x_ );
+    state.value( scroll_y_ );
+    
+    sn_bomb_.serialize( state );
+    sn_shot_b_.serialize( state );
+    sound_board_.serialize( state );
+    hd38880_.serialize( state );
+    
+    for( i=0; i<16; i++ ) {
+        speech_samples_[i].serialize( state );
+    }
+    
+    sample_bomb_.serialize( state );
+    sample_shot_a_.serialize( state );
+    
+    if( state.isLoading() ) {
+        // Redecode the character RAM and redraw the background
+        memset( char_dirty_, 1, sizeof(char_dirty_) );
+        char_ram_dirty_ = true;
+        
+        invalidateTiles();
+    }
+}
+
 unsigned char VanguardBoard::readByte( unsigned addr ) 
 {
     addr &= 0xFFFF;
@@ -449,6 +558,17 @@ void VanguardBoard::writeByte( unsigned addr, unsigned char b )
         // 0x0800-0x0BFF: Video RAM #2
         // 0x0C00-0x0FFF: Color RAM
         // 0x1000-0x1FFF: Character RAM
+        if( addr >= 0x1000 && ram_[addr] != b ) {
+            char_dirty_[ (addr >> 3) & 0xFF ] = 1;
+            char_ram_dirty_ = true;
+        }
+        
+        // Background tiles must be redrawn if their code or color changes
+        if( addr >= 0x0800 && addr < 0x1000 && ram_[addr] != b ) {
+            tile_dirty_[ addr & 0x3FF ] = 1;
+            tile_ram_dirty_ = true;
+        }
+        
         ram_[addr] = b;
     }
     
@@ -474,7 +594,7 @@ void VanguardBoard::writeByte( unsigned addr, unsigned char b )
                 sound_board_.channel(0)->setMuted(false);
             }
             
-            sn_shot_b_.enableOutput( (b & 0x40) !=0 );
+            sn_shot_b_.enableOutput( (b & 0x40) !=0, cpu_->getCycles() );
             
             if( b & 0x20 ) {
                 if( (o_port_3100_ & 0x20) == 0 ) sample_shot_a_.restart();
@@ -486,7 +606,7 @@ void VanguardBoard::writeByte( unsigned addr, unsigned char b )
                 sample_bomb_.play();
             }
             
-            sn_bomb_.enableOutput( (b & 0x80) != 0 );
+            sn_bomb_.enableOutput( (b & 0x80) != 0, cpu_->getCycles() );
             
             o_port_3100_ = b;
             break;
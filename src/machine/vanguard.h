@@ -28,6 +28,14 @@ struct VanguardBoard : public N6502Environment
     
     void writeToSpeechPort( unsigned char b );
     
+    void serialize( TStateStream & state );
+    
+    // Force a redraw of all the background tiles
+    void invalidateTiles() {
+        memset( tile_dirty_, 1, sizeof(tile_dirty_) );
+        tile_ram_dirty_ = true;
+    }
+    
     unsigned char   ram_[48*1024]; // RAM and ROM
     unsigned char   dsw0_;
     unsigned char   port0_;
@@ -42,6 +50,10 @@ struct VanguardBoard : public N6502Environment
     unsigned        frame_counter_; // How many times run() has been called since last reset() 
     int             scroll_x_;
     int             scroll_y_;
+    unsigned char   char_dirty_[256];   // Characters modified in the character RAM since last decoded
+    bool            char_ram_dirty_;    // True if any entry in char_dirty_ is set
+    unsigned char   tile_dirty_[0x400]; // Background tiles modified in the video or color RAM since last drawn
+    bool            tile_ram_dirty_;    // True if any entry in tile_dirty_ is set
     SN76477         sn_bomb_;
     SN76477         sn_shot_b_;
     N6502 *         cpu_;
@@ -75,13 +87,21 @@ public:
         return new Vanguard( new VanguardBoard );
     }
 
-    static TBitmapIndexed * renderVideo( TBitmapIndexed * screen, unsigned char * ram, TBitBlock & back_char_data, TBitBlock & fore_char_data, unsigned back_color, int scroll_x, int scroll_y );
+    static void updateBackground( TBitBlock & back_layer, unsigned char * ram, TBitBlock & back_char_data, unsigned char * dirty );
+
+    static TBitmapIndexed * renderVideo( TBitmapIndexed * screen, unsigned char * ram, TBitBlock & back_layer, TBitBlock & fore_char_data, int scroll_x, int scroll_y );
     
+    static void decodeChar( unsigned char * src, unsigned char * dst, unsigned plane_offset );
+
     static void decodeCharSet( unsigned char * b_src, unsigned char * b_dst, unsigned plane_offset );
     
+    static void decodeDirtyChars( unsigned char * b_src, unsigned char * b_dst, unsigned plane_offset, unsigned char * dirty );
+    
 protected:
     virtual bool initialize( TMachineDriverInfo * info );
 
+    virtual bool serialize( TStateStream & state );
+
     Vanguard( VanguardBoard * );
 
     void onVideoROMsChanged();
@@ -98,6 +118,7 @@ private:
     unsigned        palette_rgb_[64];   // Decoded palette PROM
     TBitBlock       back_char_data_;
     TBitBlock       fore_char_data_;
+    TBitBlock       back_layer_;        // Whole 256x256 background, scrolled into the screen
 };
 
 #endif // VANGUARD_H_
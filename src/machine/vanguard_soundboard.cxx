@@ -128,6 +128,18 @@ void VanguardMusicChannel::setWaveformData( const int * data, int scale )
     }
 }
 
+void VanguardMusicChannel::serialize( TStateStream & state )
+{
+    state.value( muted );
+    state.value( one_shot );
+    state.value( offset );
+    state.value( offset_curr );
+    state.value( offset_mask );
+    state.value( waveform_counter );
+    state.value( waveform_step );
+    state.bytes( waveform, sizeof(waveform) );
+}
+
 VanguardSoundBoard::VanguardSoundBoard( unsigned char * rom, unsigned num_channels )
 {
     unsigned max_channels = sizeof(ch_) / sizeof(ch_[0]);
@@ -183,6 +195,15 @@ void VanguardSoundBoard::play( TMixerBuffer * mixer_buffer, unsigned samplesPerF
     mixer_buffer->addVoices( ch_count_ );
 }
 
+void VanguardSoundBoard::serialize( TStateStream & state )
+{
+    for( unsigned i=0; i<ch_count_; i++ ) {
+        ch_[i]->serialize( state );
+    }
+    
+    state.value( tone_counter_ );
+}
+
 Hd38880_SimWithSamples::Hd38880_SimWithSamples()
 {
     speech_table_len_ = 0;
@@ -273,3 +294,12 @@ void Hd38880_SimWithSamples::play( TFrame * frame, unsigned samplesPerFrame, uns
     }
 }
 
+void Hd38880_SimWithSamples::serialize( TStateStream & state )
+{
+    state.value( speech_command_ );
+    state.value( speech_data_ );
+    state.value( speech_data_len_ );
+    state.value( speech_data_ofs_ );
+    state.value( speech_address_ );
+}
+
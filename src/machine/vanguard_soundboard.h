@@ -31,6 +31,7 @@ struct VanguardMusicChannel
     void setPitchFromCurrentRomOffset( unsigned sampling_rate );
     void setWaveform( int mask );
     void setWaveformData( const int * data, int scale );
+    void serialize( TStateStream & state );
             
     inline int getNextWaveformSample() {
         int result = waveform[ (waveform_counter >> 10) & 0x0F ];
@@ -53,6 +54,8 @@ struct VanguardSoundBoard
     
     void play( TMixerBuffer * mixer_buffer, unsigned samplesPerFrame, unsigned samplingRate );
     
+    void serialize( TStateStream & state );
+    
     VanguardMusicChannel * channel( int index ) {
         return ch_[index];
     }
@@ -77,6 +80,8 @@ struct Hd38880_SimWithSamples {
     void write( unsigned char );
     
     void play( TFrame * frame, unsigned samplesPerFrame, unsigned samplingRate );
+    
+    void serialize( TStateStream & state );
 };
 
 #endif // VANGUARD_SOUNDBOARD_H_
@@ -3,6 +3,8 @@
 
     Copyright (c) 2004 Alessandro Scotti
 */
+#include <string.h>
+
 #include "z80_ay3_soundboard.h"
 
 Z80_AY3_SoundBoard::Z80_AY3_SoundBoard( int numOfChips, unsigned chipClock, unsigned romSize, unsigned ramSize, unsigned ramStart )
@@ -26,10 +28,31 @@ Z80_AY3_SoundBoard::Z80_AY3_SoundBoard( int numOfChips, unsigned chipClock, unsi
     interrupts_pending_ = 0;
 
     sampling_steps_ = 12;
+
+    frame_cycles_ = 0;
+    main_frame_cycles_ = 1;
+    frame_cycle_ = 0;
+    step_ = 0;
+    slice_start_ = 0;
+    cpu_running_ = false;
+
+    worker_ = TWorker::create();
+    frame_log_index_ = 0;
+    frame_log_[0].count = 0;
+    frame_log_[0].started = false;
+    frame_log_[1].count = 0;
+    frame_log_[1].started = false;
+    job_ = 0;
+    audio_ = 0;
+    audio_size_ = 0;
+    audio_len_ = 0;
+    audio_rate_ = 0;
 }
 
 Z80_AY3_SoundBoard::~Z80_AY3_SoundBoard()
 {
+    delete worker_;
+    delete [] audio_;
     delete [] chip_;
     delete [] rom_;
     delete [] ram_;
@@ -79,6 +102,12 @@ void Z80_AY3_SoundBoard::onAfterSamplingStep( unsigned step )
 {
 }
 
+void Z80_AY3_SoundBoard::onCommand( unsigned char value )
+{
+    // Most boards latch the command into port A of the first sound chip
+    chip_[0].setRegister( AY_3_8910::PortA, value );
+}
+
 void Z80_AY3_SoundBoard::setPortData( unsigned index, unsigned char value )
 {
     port_data_[index] = value;
@@ -97,43 +126,265 @@ void Z80_AY3_SoundBoard::run()
 
 void Z80_AY3_SoundBoard::reset()
 {
+    if( worker_ != 0 ) {
+        worker_->wait();
+    }
+
     cpu_->reset();
 }
 
 void Z80_AY3_SoundBoard::interrupt( unsigned char vector )
 {
-    if( ! cpu_->interrupt( vector ) ) {
+    if( ! cpu_->interrupt( vector ) && (interrupts_pending_ < InterruptQueueSize) ) {
         interrupt_queue_[ interrupts_pending_++ ] = vector;
     }
 }
 
-void Z80_AY3_SoundBoard::playSound( unsigned cpuCycles, TMixer * mixer, unsigned len, unsigned samplingRate )
+void Z80_AY3_SoundBoard::serialize( TStateStream & state )
 {
-    TMixerBuffer * mixerBuffer = mixer->getBuffer( chMono, len, 3*num_of_chips_ );
-    int * dataBuffer = mixerBuffer->data();
-    unsigned stepSize = len / sampling_steps_;
-    unsigned cyclesPerStep = cpuCycles / sampling_steps_;
+    if( worker_ != 0 ) {
+        worker_->wait();
+    }
+
+    cpu_->serialize( state );
+
+    state.bytes( ram_, ram_size_ );
+
+    for( unsigned j=0; j<num_of_chips_; j++ ) {
+        chip_[j].serialize( state );
+    }
 
-    for( unsigned i=1; i<sampling_steps_; i++ ) {
-        cpu_->run( cyclesPerStep );
+    state.bytes( interrupt_queue_, sizeof(interrupt_queue_) );
+    state.bytes( port_data_, sizeof(port_data_) );
+    state.value( interrupts_pending_ );
+    state.value( frame_cycle_ );
 
-        for( unsigned j=0; j<num_of_chips_; j++ ) {
-            chip_[j].playSound( dataBuffer, stepSize, samplingRate );
+    if( interrupts_pending_ > InterruptQueueSize ) {
+        interrupts_pending_ = 0;
+        state.fail();
+    }
+
+    if( worker_ != 0 ) {
+        state.value( audio_len_ );
+        state.value( audio_rate_ );
+
+        if( audio_size_ < audio_len_ ) {
+            delete [] audio_;
+            audio_ = new int [audio_len_];
+            audio_size_ = audio_len_;
         }
 
-        dataBuffer += stepSize;
-        
-        onAfterSamplingStep( i-1 );
+        state.bytes( audio_, audio_len_ * sizeof(int) );
+    }
+}
+
+void Z80_AY3_SoundBoard::beginFrame( unsigned cyclesPerFrame, unsigned mainCyclesPerFrame )
+{
+    TFrameLog & log = frame_log_[frame_log_index_];
+
+    log.frame_cycles = cyclesPerFrame;
+    log.main_frame_cycles = mainCyclesPerFrame ? mainCyclesPerFrame : 1;
+    log.count = 0;
+    log.started = false;
+
+    if( worker_ == 0 ) {
+        startFrame( cyclesPerFrame );
+        log.started = true;
     }
+}
 
-    // Play last step outside the loop to avoid round-off errors
-    stepSize = len - stepSize*(sampling_steps_-1);
+void Z80_AY3_SoundBoard::writeCommand( unsigned mainCycle, unsigned char value )
+{
+    post( evCommand, mainCycle, value );
+}
 
-    cpu_->run( cyclesPerStep );
+void Z80_AY3_SoundBoard::triggerInterrupt( unsigned mainCycle, unsigned char vector )
+{
+    post( evInterrupt, mainCycle, vector );
+}
+
+void Z80_AY3_SoundBoard::triggerReset( unsigned mainCycle )
+{
+    post( evReset, mainCycle, 0 );
+}
+
+void Z80_AY3_SoundBoard::post( unsigned type, unsigned mainCycle, unsigned char value )
+{
+    TFrameLog & log = frame_log_[frame_log_index_];
+    TEvent event;
+
+    event.cycle = (unsigned) (((unsigned long long) mainCycle * log.frame_cycles) / log.main_frame_cycles);
+    event.type = (unsigned char) type;
+    event.value = value;
+
+    if( event.cycle > log.frame_cycles ) {
+        event.cycle = log.frame_cycles;
+    }
+
+    if( worker_ == 0 ) {
+        applyEvent( event );
+    }
+    else {
+        if( log.count >= MaxEvents ) {
+            flush();
+        }
+
+        log.events[log.count++] = event;
+    }
+}
+
+void Z80_AY3_SoundBoard::catchUp( unsigned mainCycle )
+{
+    TFrameLog & log = frame_log_[frame_log_index_];
+    unsigned cycle = (unsigned) (((unsigned long long) mainCycle * log.frame_cycles) / log.main_frame_cycles);
+
+    if( worker_ != 0 ) {
+        flush();
+    }
+
+    runTo( cycle < log.frame_cycles ? cycle : log.frame_cycles );
+}
+
+// Runs the logged events of the current frame on this thread
+void Z80_AY3_SoundBoard::flush()
+{
+    TFrameLog & log = frame_log_[frame_log_index_];
+
+    worker_->wait();
+
+    if( ! log.started ) {
+        startFrame( log.frame_cycles );
+        log.started = true;
+    }
+
+    for( unsigned i=0; i<log.count; i++ ) {
+        applyEvent( log.events[i] );
+    }
+
+    log.count = 0;
+}
+
+void Z80_AY3_SoundBoard::startFrame( unsigned cyclesPerFrame )
+{
+    run();
+
+    frame_cycles_ = cyclesPerFrame;
+    step_ = 0;
+
+    for( unsigned j=0; j<num_of_chips_; j++ ) {
+        chip_[j].beginFrame( 0, cyclesPerFrame );
+    }
+}
+
+void Z80_AY3_SoundBoard::applyEvent( const TEvent & event )
+{
+    runTo( event.cycle );
+
+    switch( event.type ) {
+    case evCommand:
+        onCommand( event.value );
+        break;
+    case evInterrupt:
+        interrupt( event.value );
+        break;
+    case evReset:
+        cpu_->reset();
+        break;
+    }
+}
+
+void Z80_AY3_SoundBoard::runTo( unsigned cycle )
+{
+    while( frame_cycle_ < cycle ) {
+        // Stop at the end of each sampling step, where children may raise periodic interrupts
+        unsigned end = step_ < sampling_steps_ ? getStepEnd( step_ ) : cycle;
+
+        if( end > cycle ) {
+            end = cycle;
+        }
+
+        if( frame_cycle_ < end ) {
+            unsigned cycles = end - frame_cycle_;
+
+            slice_start_ = cpu_->getCycles();
+            cpu_running_ = true;
+
+            frame_cycle_ += cycles + cpu_->run( cycles );
+
+            cpu_running_ = false;
+        }
+
+        while( (step_ < sampling_steps_) && (frame_cycle_ >= getStepEnd( step_ )) ) {
+            onAfterSamplingStep( step_++ );
+        }
+    }
+}
+
+void Z80_AY3_SoundBoard::finishFrame( int * buffer, unsigned len, unsigned samplingRate )
+{
+    runTo( frame_cycles_ );
+
+    while( step_ < sampling_steps_ ) {
+        onAfterSamplingStep( step_++ );
+    }
 
     for( unsigned j=0; j<num_of_chips_; j++ ) {
-        chip_[j].playSound( dataBuffer, stepSize, samplingRate );
+        chip_[j].playSound( buffer, len, samplingRate );
+    }
+
+    // Keep the cycles run past the end of the frame by the last instruction
+    frame_cycle_ -= frame_cycles_;
+}
+
+void Z80_AY3_SoundBoard::endFrame( TMixer * mixer, unsigned len, unsigned samplingRate )
+{
+    TMixerBuffer * mixerBuffer = mixer->getBus( "psg", len, 3*num_of_chips_ );
+
+    if( worker_ == 0 ) {
+        finishFrame( mixerBuffer->data(), len, samplingRate );
+        return;
     }
 
-    onAfterSamplingStep( sampling_steps_-1 );
+    // Play the previous frame, which the worker has finished meanwhile
+    worker_->wait();
+
+    if( (audio_len_ == len) && (audio_rate_ == samplingRate) ) {
+        int * data = mixerBuffer->data();
+
+        for( unsigned i=0; i<len; i++ ) {
+            data[i] += audio_[i];
+        }
+    }
+
+    if( audio_size_ < len ) {
+        delete [] audio_;
+        audio_ = new int [len];
+        audio_size_ = len;
+    }
+
+    // Pass this frame to the worker and go on with the next one
+    job_ = &frame_log_[frame_log_index_];
+    audio_len_ = len;
+    audio_rate_ = samplingRate;
+    frame_log_index_ ^= 1;
+
+    worker_->start( runFrameStub, this );
+}
+
+void Z80_AY3_SoundBoard::runFrameStub( void * context )
+{
+    Z80_AY3_SoundBoard * board = (Z80_AY3_SoundBoard *) context;
+    TFrameLog * log = board->job_;
+
+    if( ! log->started ) {
+        board->startFrame( log->frame_cycles );
+    }
+
+    for( unsigned i=0; i<log->count; i++ ) {
+        board->applyEvent( log->events[i] );
+    }
+
+    memset( board->audio_, 0, board->audio_len_ * sizeof(int) );
+
+    board->finishFrame( board->audio_, board->audio_len_, board->audio_rate_ );
 }
@@ -7,6 +7,8 @@
 #define Z80_AY3_SOUNDBOARD_H_
 
 #include <emu/emu_mixer.h>
+#include <emu/emu_state.h>
+#include <emu/emu_worker.h>
 #include <cpu/z80.h>
 #include <sound/ay-3-8910.h>
 
@@ -19,7 +21,70 @@ struct Z80_AY3_SoundBoard : public Z80Environment
     virtual void run();
     virtual void reset();
     virtual void interrupt( unsigned char vector );
-    virtual void playSound( unsigned cpuCycles, TMixer * mixer, unsigned len, unsigned samplingRate );
+
+    /**
+        Saves or loads the board state. States are taken between frames: in
+        threaded mode this waits for the worker, and the sound of the frame
+        it has run (not played yet) is part of the state.
+    */
+    virtual void serialize( TStateStream & state );
+
+    /**
+        Starts a new frame.
+
+        The sound CPU does not run until the main board talks to it or the
+        frame ends, and sound chip writes are logged so that the whole frame
+        is rendered in one pass by endFrame().
+
+        If a worker is available (see TWorker) the frame is run on the worker
+        thread while the main board runs the next frame, and its sound is
+        played one frame late.
+
+        @param cyclesPerFrame number of sound CPU cycles in a frame
+        @param mainCyclesPerFrame number of main CPU cycles in a frame
+    */
+    void beginFrame( unsigned cyclesPerFrame, unsigned mainCyclesPerFrame );
+
+    /**
+        Writes the command latch at the specified time (see onCommand()).
+
+        @param mainCycle main CPU cycles elapsed since the start of the frame
+        @param value command
+    */
+    void writeCommand( unsigned mainCycle, unsigned char value );
+
+    /**
+        Interrupts the sound CPU at the specified time.
+    */
+    void triggerInterrupt( unsigned mainCycle, unsigned char vector );
+
+    /**
+        Resets the sound CPU at the specified time.
+    */
+    void triggerReset( unsigned mainCycle );
+
+    /**
+        Runs the sound CPU up to the specified time, if it's not there already.
+
+        Main boards that read back from the sound board must call this first.
+        It's the only call that blocks the main board in threaded mode.
+
+        @param mainCycle main CPU cycles elapsed since the start of the frame
+    */
+    void catchUp( unsigned mainCycle );
+
+    /**
+        Runs the sound CPU to the end of the frame and plays the sound chips.
+    */
+    void endFrame( TMixer * mixer, unsigned len, unsigned samplingRate );
+
+    /**
+        Returns the sound CPU cycles elapsed since the start of the frame,
+        to be used as timestamp for sound chip writes.
+    */
+    unsigned getFrameCycle() const {
+        return cpu_running_ ? frame_cycle_ + (cpu_->getCycles() - slice_start_) : frame_cycle_;
+    }
 
     unsigned char getPortData( unsigned index ) {
         return port_data_[index];
@@ -57,12 +122,48 @@ protected:
     virtual unsigned char onReadByte( unsigned addr );
     virtual void onWriteByte( unsigned addr, unsigned char value );
     virtual void onAfterSamplingStep( unsigned step );
+    virtual void onCommand( unsigned char value );
 
     enum {
         PortDataSize = 8,
-        InterruptQueueSize = 4
+        InterruptQueueSize = 4,
+        MaxEvents = 256
+    };
+
+    enum {
+        evCommand,
+        evInterrupt,
+        evReset
+    };
+
+    // Command, interrupt or reset from the main board
+    struct TEvent {
+        unsigned cycle; // Sound CPU cycle, relative to the start of the frame
+        unsigned char type;
+        unsigned char value;
+    };
+
+    // Events of a frame, in the order they were posted
+    struct TFrameLog {
+        unsigned frame_cycles;
+        unsigned main_frame_cycles;
+        TEvent events[MaxEvents];
+        unsigned count;
+        bool started; // True if the frame has been started (by catchUp())
     };
 
+    void post( unsigned type, unsigned mainCycle, unsigned char value );
+    void flush();
+    void startFrame( unsigned cyclesPerFrame );
+    void applyEvent( const TEvent & event );
+    void finishFrame( int * buffer, unsigned len, unsigned samplingRate );
+    void runTo( unsigned cycle );
+    static void runFrameStub( void * context );
+
+    unsigned getStepEnd( unsigned step ) const {
+        return (unsigned) (((unsigned long long) frame_cycles_ * (step+1)) / sampling_steps_);
+    }
+
     // Member variables
     unsigned char * rom_;
     unsigned char * ram_;
@@ -77,6 +178,21 @@ protected:
     AY_3_8910 * chip_;
     Z80 * cpu_;
     unsigned sampling_steps_;
+    unsigned frame_cycles_;         // Sound CPU cycles per frame
+    unsigned main_frame_cycles_;    // Main CPU cycles per frame
+    unsigned frame_cycle_;          // Sound CPU cycles run in this frame
+    unsigned step_;                 // Next sampling step
+    unsigned slice_start_;          // CPU cycle counter at the start of the running slice
+    bool cpu_running_;
+
+    TWorker * worker_;              // Worker thread, 0 if not threaded
+    TFrameLog frame_log_[2];
+    unsigned frame_log_index_;      // Log of the frame being run by the main board
+    TFrameLog * job_;               // Log of the frame being run by the worker
+    int * audio_;                   // Sound of the frame run by the worker
+    unsigned audio_size_;
+    unsigned audio_len_;
+    unsigned audio_rate_;
 
     unsigned timer_clock_;
     bool interrupt_pending_;
@@ -0,0 +1,160 @@
+/*
+    Tickle 0.95
+    Analog sound emulation precision check
+
+    Renders a reference circuit (the Galaga hit sound: noise, capacitor and
+    bandpass filter, mixed to 8 bits like the driver does) and either saves
+    the output or compares it with the output saved by another build. The
+    regression Makefile builds this program with both the double and the
+    single precision (ASE_SINGLE_PRECISION) analog library, and checks that
+    the difference stays within the bound documented in ase/ase.h.
+
+    Copyright (c) 2014-2021 Alessandro Scotti
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ase/ase_bandpass_filter.h"
+#include "ase/ase_capacitor_with_switch.h"
+#include "ase/ase_clipper.h"
+#include "ase/ase_latch.h"
+#include "ase/ase_noise.h"
+
+enum {
+    SamplingRate = 44100,
+    FrameRate = 60,
+    SamplesPerFrame = SamplingRate / FrameRate,
+    Frames = 20 * FrameRate,
+    Samples = Frames * SamplesPerFrame,
+    MaxStepDifference = 5,  // Largest difference allowed on a single sample
+    MaxDifferentSamples = 2 // Percentage of samples allowed to differ
+};
+
+// Frames the explosion is triggered at, a few overlap the previous one
+static bool isTriggerFrame( unsigned frame )
+{
+    return ((frame % 97) == 0) || ((frame % 211) == 30);
+}
+
+static void render( unsigned char * output )
+{
+    AContext context( SamplingRate );
+
+    AWhiteNoise noise( context, 48000 );
+    noise.setOutput( 3.4, 0.3 );
+
+    ALatch latch( context );
+    AClipperLo diode( latch, 0.7 );
+    ACapacitorWithSwitch hit( diode, noise, Kilo(1), Kilo(100), Micro(2.2) );
+    AActiveBandPassFilter filter( hit, Kilo(150), Kilo(22), Kilo(470), Micro(0.01), Micro(0.01) );
+    filter.setGain( 1e+02 );
+
+    int buffer[SamplesPerFrame];
+
+    for( unsigned frame = 0; frame < Frames; frame++ ) {
+        if( isTriggerFrame( frame ) ) {
+            latch.setValue( 3.2 );
+        }
+
+        memset( buffer, 0, sizeof(buffer) );
+
+        filter.resetStream();
+        filter.updateTo( SamplesPerFrame );
+        filter.mixStream( buffer, 51, 0, 255 );
+
+        latch.setValue( 0.3 );
+
+        for( unsigned i = 0; i < SamplesPerFrame; i++ ) {
+            *output++ = (unsigned char) buffer[i];
+        }
+    }
+}
+
+static int save( const unsigned char * output, const char * name )
+{
+    FILE * f = fopen( name, "wb" );
+
+    if( f == 0 ) {
+        printf( "Cannot create: %s\n", name );
+        return EXIT_FAILURE;
+    }
+
+    bool ok = fwrite( output, 1, Samples, f ) == Samples;
+
+    if( fclose( f ) != 0 ) {
+        ok = false;
+    }
+
+    if( ! ok ) {
+        printf( "Cannot write: %s\n", name );
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int check( const unsigned char * output, const char * name )
+{
+    unsigned char * reference = new unsigned char [Samples];
+
+    FILE * f = fopen( name, "rb" );
+
+    if( f == 0 ) {
+        printf( "Cannot open: %s\n", name );
+        delete [] reference;
+        return EXIT_FAILURE;
+    }
+
+    bool ok = fread( reference, 1, Samples, f ) == Samples;
+
+    fclose( f );
+
+    if( ! ok ) {
+        printf( "Bad reference file: %s\n", name );
+        delete [] reference;
+        return EXIT_FAILURE;
+    }
+
+    unsigned maxDifference = 0;
+    unsigned differentSamples = 0;
+
+    for( unsigned i = 0; i < Samples; i++ ) {
+        unsigned d = (output[i] > reference[i]) ? output[i] - reference[i] : reference[i] - output[i];
+
+        if( d > 0 ) {
+            differentSamples++;
+        }
+
+        if( d > maxDifference ) {
+            maxDifference = d;
+        }
+    }
+
+    delete [] reference;
+
+    ok = (maxDifference <= MaxStepDifference) && (differentSamples * 100 <= Samples * MaxDifferentSamples);
+
+    printf( "%s: %u samples differ (%.2f%%), by at most %u steps\n", ok ? "OK" : "FAILED",
+        differentSamples, differentSamples * 100.0 / Samples, maxDifference );
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main( int argc, char ** argv )
+{
+    if( (argc != 3) || ((strcmp( argv[1], "-save" ) != 0) && (strcmp( argv[1], "-check" ) != 0)) ) {
+        printf( "Usage: %s -save|-check file\n", argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    unsigned char * output = new unsigned char [Samples];
+
+    render( output );
+
+    int result = (strcmp( argv[1], "-save" ) == 0) ? save( output, argv[2] ) : check( output, argv[2] );
+
+    delete [] output;
+
+    return result;
+}
@@ -0,0 +1,529 @@
+/*
+    Tickle 0.95
+    Golden output regression test
+
+    Runs the drivers without a display for a number of frames, hashes the
+    video and sound of every frame and compares the hashes with those saved
+    by a previous run, to check that changes to the emulation core are
+    bit-exact. Drivers run in parallel, one per thread.
+
+    Copyright (c) 2014-2021 Alessandro Scotti
+*/
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "emu/emu.h"
+#include "emu/emu_memory_iostream.h"
+
+// For some reasons g++ may get confused by the indirect reference and will not link the machines
+// (this happens e.g. on the RPI) so we have to include them explicitly.
+#include <machine/1942.h>
+#include <machine/fantasy.h>
+#include <machine/frogger.h>
+#include <machine/galaga.h>
+#include <machine/galaxian.h>
+#include <machine/invaders.h>
+#include <machine/nibbler.h>
+#include <machine/pacman.h>
+#include <machine/pengo.h>
+#include <machine/pinball_action.h>
+#include <machine/pooyan.h>
+#include <machine/rallyx.h>
+#include <machine/scramble.h>
+#include <machine/vanguard.h>
+
+void dummy()
+{
+    delete M1942::createInstance();
+    delete Fantasy::createInstance();
+    delete Frogger::createInstance();
+    delete Galaga::createInstance();
+    delete Galaxian::createInstance();
+    delete Nibbler::createInstance();
+    delete Pacman::createInstance();
+    delete Pengo::createInstance();
+    delete PinballAction::createInstance();
+    delete Pooyan::createInstance();
+    delete RallyX::createInstance();
+    delete Scramble::createInstance();
+    delete SpaceInvaders::createInstance();
+    delete Vanguard::createInstance();
+}
+
+enum {
+    SamplingRate = 44100,
+    MaxJobs = 64
+};
+
+typedef unsigned long long THash;
+
+const THash HashSeed = 0xCBF29CE484222325ULL;
+
+// 64-bit FNV-1a hash
+static THash hashBytes( THash h, const void * data, unsigned len )
+{
+    const unsigned char * p = (const unsigned char *) data;
+
+    while( len-- > 0 ) {
+        h = (h ^ *p++) * 0x100000001B3ULL;
+    }
+
+    return h;
+}
+
+// Frame that keeps the video and sound in memory, to hash them
+class RegressFrame : public TFrame {
+public:
+    RegressFrame() : video_(0), last_video_(0), flipped_(false), pcm_(0), pcm_size_(0) {
+    }
+
+    virtual ~RegressFrame() {
+        delete [] pcm_;
+    }
+
+    virtual void setVideo( TBitmap * screen, bool flipped ) {
+        video_ = screen;
+        last_video_ = screen;
+        flipped_ = flipped;
+    }
+
+    virtual TMixer * getMixer() {
+        return &mixer_;
+    }
+
+    // Prepare the frame to be filled again
+    void reset() {
+        mixer_.clear();
+        video_ = 0;
+    }
+
+    // Returns the hash of the video, 0 if the machine did not produce any in this frame
+    THash videoHash() const;
+
+    // Returns the hash of the sound, as played by the SDL front end
+    THash audioHash( unsigned samples );
+
+    // Returns the last video produced by the machine (it may be older than this frame)
+    TBitmap * lastVideo() const {
+        return last_video_;
+    }
+
+private:
+    TMixerMono mixer_;
+    TBitmap * video_;
+    TBitmap * last_video_;
+    bool flipped_;
+    int16_t * pcm_;
+    unsigned pcm_size_;
+};
+
+THash RegressFrame::videoHash() const
+{
+    if( video_ == 0 ) {
+        return 0;
+    }
+
+    int w = video_->width();
+    int h = video_->height();
+    THash hash = HashSeed;
+
+    hash = hashBytes( hash, &flipped_, sizeof(flipped_) );
+    hash = hashBytes( hash, &w, sizeof(w) );
+    hash = hashBytes( hash, &h, sizeof(h) );
+
+    if( video_->format() == bfIndexed ) {
+        // Hash the pixels and the palette separately, it's much faster than looking up every pixel
+        TBitmapIndexed * video = reinterpret_cast<TBitmapIndexed *>( video_ );
+
+        hash = hashBytes( hash, video->bits()->data(), w*h );
+        hash = hashBytes( hash, video->palette()->data(), video->palette()->colors()*sizeof(unsigned) );
+    }
+    else {
+        for( int y=0; y<h; y++ ) {
+            for( int x=0; x<w; x++ ) {
+                unsigned color = video_->pixel( x, y );
+
+                hash = hashBytes( hash, &color, sizeof(color) );
+            }
+        }
+    }
+
+    return hash;
+}
+
+THash RegressFrame::audioHash( unsigned samples )
+{
+    if( pcm_size_ < samples ) {
+        delete [] pcm_;
+        pcm_size_ = samples;
+        pcm_ = new int16_t [2*pcm_size_];
+    }
+
+    mixer_.renderStereo( pcm_, samples );
+
+    return hashBytes( HashSeed, pcm_, 2*samples*sizeof(int16_t) );
+}
+
+struct RegressOptions {
+    int frames; // Frames to run
+    const char * golden; // Folder of the golden hash files
+    bool update; // Save the hashes instead of checking them
+    const unsigned char * input; // Input log to play back (optional)
+    unsigned input_size;
+
+    RegressOptions() {
+        frames = 1800;
+        golden = "golden";
+        update = false;
+        input = 0;
+        input_size = 0;
+    }
+};
+
+enum RegressResult {
+    rrPassed,
+    rrFailed,
+    rrSkipped
+};
+
+RegressOptions options;
+char * basePath;
+
+// Jobs are assigned to the threads in order
+const TGameRegistryItem ** jobs;
+int jobCount = 0;
+int nextJob = 0;
+int passed = 0;
+int failed = 0;
+int skipped = 0;
+pthread_mutex_t jobLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t createLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Read the golden hashes of a driver, returns the number of frames read
+int loadGoldenHashes( const char * name, THash * hashes, int frames )
+{
+    int count = 0;
+    FILE * f = fopen( name, "r" );
+
+    if( f != 0 ) {
+        unsigned frame;
+        THash video;
+        THash audio;
+
+        while( (count < frames) && (fscanf( f, "%u %llx %llx", &frame, &video, &audio ) == 3) && (frame == (unsigned) count) ) {
+            hashes[2*count+0] = video;
+            hashes[2*count+1] = audio;
+            count++;
+        }
+
+        fclose( f );
+    }
+
+    return count;
+}
+
+bool saveGoldenHashes( const char * name, const THash * hashes, int frames )
+{
+    FILE * f = fopen( name, "w" );
+
+    if( f == 0 ) {
+        return false;
+    }
+
+    for( int i=0; i<frames; i++ ) {
+        fprintf( f, "%d %016llx %016llx\n", i, hashes[2*i+0], hashes[2*i+1] );
+    }
+
+    return fclose( f ) == 0;
+}
+
+// Save the video of the first frame that differs, so that it can be compared with a good run
+void saveFrame( RegressFrame & frame, const char * driver, int index, char * info, unsigned info_size )
+{
+    if( frame.lastVideo() == 0 ) {
+        return;
+    }
+
+    char name[PATH_MAX];
+
+    snprintf( name, sizeof(name), "%s-%d.png", driver, index );
+
+    TFileOutputStream * os = TFileOutputStream::open( name, false );
+
+    if( os != 0 ) {
+        if( writeBitmapToPNG( os, frame.lastVideo() ) ) {
+            snprintf( info, info_size, " (saved %s)", name );
+        }
+
+        delete os;
+    }
+}
+
+RegressResult runDriver( const TGameRegistryItem * item, char * message, unsigned message_size )
+{
+    const char * driver = item->info()->driver;
+
+    // Some drivers build shared tables when created, so machines are created one at a time
+    pthread_mutex_lock( &createLock );
+
+    TMachine * machine = TMachine::createInstance( item->factory() );
+    TList badFiles;
+    bool loaded = (machine != 0) && loadMachineResources( machine, basePath, badFiles );
+
+    pthread_mutex_unlock( &createLock );
+
+    if( ! loaded ) {
+        snprintf( message, message_size, "%s: skipped, files missing", driver );
+        delete machine;
+        return rrSkipped;
+    }
+
+    char golden_name[PATH_MAX];
+
+    snprintf( golden_name, sizeof(golden_name), "%s/%s.txt", options.golden, driver );
+
+    THash * golden = new THash [2*options.frames];
+    int golden_frames = options.update ? 0 : loadGoldenHashes( golden_name, golden, options.frames );
+    RegressResult result = rrPassed;
+
+    if( ! options.update && (golden_frames < options.frames) ) {
+        snprintf( message, message_size, "%s: failed, %s has %d of %d frames (use -update to create it)", driver, golden_name, golden_frames, options.frames );
+        result = rrFailed;
+    }
+
+    THash * hashes = new THash [2*options.frames];
+    TMemoryInputStream input( options.input, options.input_size );
+    TInputPlayer * player = (options.input != 0) ? new TInputPlayer( &input ) : 0;
+    RegressFrame frame;
+    int samplesPerFrame = SamplingRate / machine->getDriverInfo()->machineInfo()->framesPerSecond;
+
+    machine->reset();
+
+    for( int i=0; (i<options.frames) && (result == rrPassed); i++ ) {
+        frame.reset();
+
+        if( player != 0 ) {
+            player->play( machine );
+        }
+
+        machine->run( &frame, samplesPerFrame, SamplingRate );
+
+        hashes[2*i+0] = frame.videoHash();
+        hashes[2*i+1] = frame.audioHash( samplesPerFrame );
+
+        if( ! options.update ) {
+            bool video_ok = hashes[2*i+0] == golden[2*i+0];
+            bool audio_ok = hashes[2*i+1] == golden[2*i+1];
+
+            if( ! video_ok || ! audio_ok ) {
+                char info[PATH_MAX+16] = "";
+
+                saveFrame( frame, driver, i, info, sizeof(info) );
+
+                snprintf( message, message_size, "%s: failed, %s differs at frame %d%s", driver, video_ok ? "sound" : (audio_ok ? "video" : "video and sound"), i, info );
+                result = rrFailed;
+            }
+        }
+    }
+
+    if( result == rrPassed ) {
+        if( ! options.update ) {
+            snprintf( message, message_size, "%s: passed", driver );
+        }
+        else if( saveGoldenHashes( golden_name, hashes, options.frames ) ) {
+            snprintf( message, message_size, "%s: saved %s", driver, golden_name );
+        }
+        else {
+            snprintf( message, message_size, "%s: failed, cannot write %s", driver, golden_name );
+            result = rrFailed;
+        }
+    }
+
+    delete player;
+    delete [] hashes;
+    delete [] golden;
+    delete machine;
+
+    return result;
+}
+
+void * workerThread( void * )
+{
+    while( true ) {
+        pthread_mutex_lock( &jobLock );
+        int index = nextJob++;
+        pthread_mutex_unlock( &jobLock );
+
+        if( index >= jobCount ) {
+            break;
+        }
+
+        char message[2*PATH_MAX];
+        RegressResult result = runDriver( jobs[index], message, sizeof(message) );
+
+        pthread_mutex_lock( &jobLock );
+        printf( "%s\n", message );
+        fflush( stdout );
+        switch( result ) {
+            case rrPassed: passed++; break;
+            case rrFailed: failed++; break;
+            case rrSkipped: skipped++; break;
+        }
+        pthread_mutex_unlock( &jobLock );
+    }
+
+    return 0;
+}
+
+// Load the input log into memory, so that all threads can play it
+bool loadInputLog( const char * name, TMemoryOutputStream & log )
+{
+    TFileInputStream * is = TFileInputStream::open( name );
+
+    if( is == 0 ) {
+        return false;
+    }
+
+    char buf[4096];
+    unsigned n;
+
+    while( (n = is->read( buf, sizeof(buf) )) > 0 ) {
+        log.write( buf, n );
+    }
+
+    delete is;
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    printf( "Tickle 0.95 regression test\n" );
+
+    // Initialize base directory information
+    basePath = (char *) malloc(PATH_MAX+1);
+    getcwd(basePath, PATH_MAX+1);
+
+    TGameRegistry & reg = TGameRegistry::instance();
+    TMemoryOutputStream inputLog;
+    const char * playFile = 0;
+    int threads = (int) sysconf( _SC_NPROCESSORS_ONLN );
+
+    jobs = new const TGameRegistryItem * [reg.count()];
+
+    for( int i=1; i<argc; i++ ) {
+        const char * a = argv[i];
+
+        if( ! strcmp(a,"-help") || ! strcmp(a,"-?") ) {
+            printf( "Usage: tickle-regress [options] [driver...] (default is all drivers)\n" );
+            printf( "-frames n  number of frames to run (default is 1800)\n" );
+            printf( "-golden dir  folder of the golden hashes (default is \"golden\")\n" );
+            printf( "-jobs n  number of drivers to run in parallel (default is one per core)\n" );
+            printf( "-play file  play back the input recorded with -record, for its driver only\n" );
+            printf( "            (keep its golden hashes in a separate folder)\n" );
+            printf( "-update  save the hashes as the new golden hashes\n" );
+
+            return EXIT_SUCCESS;
+        }
+        else if( ! strcmp(a,"-frames") && (i+1 < argc) ) {
+            options.frames = TMath::max( 1, atoi(argv[++i]) );
+        }
+        else if( ! strcmp(a,"-golden") && (i+1 < argc) ) {
+            options.golden = argv[++i];
+        }
+        else if( ! strcmp(a,"-jobs") && (i+1 < argc) ) {
+            threads = atoi(argv[++i]);
+        }
+        else if( ! strcmp(a,"-play") && (i+1 < argc) ) {
+            playFile = argv[++i];
+        }
+        else if( ! strcmp(a,"-update") ) {
+            options.update = true;
+        }
+        else {
+            int index = reg.find( a );
+
+            if( index < 0 ) {
+                printf( "Cannot find driver: %s\n", a );
+                return EXIT_FAILURE;
+            }
+
+            // Each driver can be listed once, so the jobs always fit in the registry size
+            for( int j=0; j<jobCount; j++ ) {
+                if( jobs[j] == reg.item( index ) ) {
+                    printf( "Driver specified more than once: %s\n", a );
+                    return EXIT_FAILURE;
+                }
+            }
+
+            jobs[jobCount++] = reg.item( index );
+        }
+    }
+
+    if( playFile ) {
+        if( ! loadInputLog( playFile, inputLog ) ) {
+            printf( "Cannot read the input log: %s\n", playFile );
+            return EXIT_FAILURE;
+        }
+
+        TMemoryInputStream is( inputLog.data(), inputLog.size() );
+        TInputPlayer player( &is );
+
+        if( ! player.isValid() ) {
+            printf( "Cannot read the input log: %s\n", playFile );
+            return EXIT_FAILURE;
+        }
+
+        // The input only makes sense for the driver it was recorded with
+        int index = reg.find( player.driver() );
+
+        if( (index < 0) || (jobCount > 1) || ((jobCount == 1) && (jobs[0] != reg.item( index ))) ) {
+            printf( "The input log was recorded with another driver: %s\n", player.driver() );
+            return EXIT_FAILURE;
+        }
+
+        jobs[0] = reg.item( index );
+        jobCount = 1;
+
+        options.input = inputLog.data();
+        options.input_size = inputLog.size();
+    }
+
+    if( jobCount == 0 ) {
+        for( int i=0; i<reg.count(); i++ ) {
+            jobs[jobCount++] = reg.item( i );
+        }
+    }
+
+    if( options.update ) {
+#ifdef WIN32
+        mkdir( options.golden );
+#else
+        mkdir( options.golden, 0777 );
+#endif
+    }
+
+    threads = TMath::max( 1, TMath::min( threads, TMath::min( jobCount, (int) MaxJobs ) ) );
+
+    printf( "Running %d driver(s) for %d frames on %d thread(s)%s%s\n", jobCount, options.frames, threads, playFile ? ", input from " : "", playFile ? playFile : "" );
+
+    pthread_t tid[MaxJobs];
+
+    for( int i=0; i<threads; i++ ) {
+        pthread_create( &tid[i], 0, workerThread, 0 );
+    }
+
+    for( int i=0; i<threads; i++ ) {
+        pthread_join( tid[i], 0 );
+    }
+
+    printf( "Passed: %d, failed: %d, skipped: %d\n", passed, failed, skipped );
+
+    delete [] jobs;
+
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -13,15 +13,10 @@
 
 #include "emu/emu.h"
 #include "sdl_main.h"
+#include "sdl_worker.h"
 
 char * basePath;
 
-#ifdef WIN32
-const wchar_t PATH_SEPARATOR = '\\';
-#else
-const wchar_t PATH_SEPARATOR = '/';
-#endif
-
 // For some reasons g++ may get confused by the indirect reference and will not link the machines
 // (this happens e.g. on the RPI) so we have to include them explicitly.
 #include <machine/1942.h>
@@ -57,139 +52,6 @@ void dummy()
     delete Vanguard::createInstance();
 }
 
-// Load a file from an input stream into a newly allocated buffer
-// (which must be deleted by the caller)
-unsigned char * loadFileFromStream( TInputStream * is, unsigned size, TCRC32 * crc )
-{
-    unsigned char * result = new unsigned char [size];
-    
-    if( is->read( result, size ) == size ) {
-        crc->reset();
-        crc->update( result, size );
-    }
-    else {
-        delete [] result;
-        result = 0;
-    }
-    
-    return result;
-}
-
-unsigned getFileSize( const char * name )
-{
-    unsigned result = 0;
-    
-    FILE * f = fopen( name, "rb" );
-    
-    if( f != 0 ) {
-        fseek( f, 0L, SEEK_END );
-        result = (unsigned) ftell( f );
-        fclose( f );
-    }
-    
-    return result;
-}
-
-// Load a single file required by the driver
-unsigned char * loadFile( TMachine * machine, const TResourceFileInfo * info, const char * base, unsigned * bufsize )
-{
-    unsigned char * result = 0;
-    
-    TString home( basePath );
-
-    if( home.wstr()[home.length()-1] != PATH_SEPARATOR ) {
-        home.append(PATH_SEPARATOR);
-    }
-    
-    if( base != 0 ) {
-        home += base;
-        home.append(PATH_SEPARATOR);
-    }
-
-    TString file = home + info->name;
-    TCRC32 crc;
-    TInputStream * is = TFileInputStream::open( file.cstr() );
-    
-    if( is != 0 ) {
-        unsigned size = info->size;
-        
-        if( size == 0 ) {
-            size = getFileSize( file.cstr() );
-        }
-        
-        result = loadFileFromStream( is, size, &crc );
-        
-        *bufsize = size;
-        
-        delete is;
-    }
-    else {
-        for( int i=0; i<machine->getResourceCount(); i++ ) {
-            file = home + machine->getResourceName(i) + ".zip";
-            
-            TZipFile * zf = TZipFile::open( file.cstr() );
-            
-            if( zf != 0 ) {
-                const TZipEntry * ze = zf->entry( info->name, true );
-                
-                if( ze != 0 ) {
-                    is = ze->open();
-                    
-                    if( is != 0 ) {
-                        *bufsize = info->size ? info->size : ze->size();
-                        result = loadFileFromStream( is, *bufsize, &crc );
-                    }
-                    
-                    delete is;
-                }
-                
-                delete zf;
-            }
-            
-            if( result != 0 )
-                break;
-        }
-    }
-    
-    if( result != 0 ) {
-        // Delete buffer if CRC check fails
-        if( (info->crc != 0) && (crc.value() != info->crc) ) {
-            delete result;
-            result = 0;
-        }
-    }
-    
-    return result;
-}
-
-// Load the files required by the driver
-bool loadMachineFiles( TMachine * machine, TList & failedList )
-{
-    bool result = true;
-    const TMachineDriverInfo * info = machine->getDriverInfo();
-    
-    for( int i=0; i<info->resourceFileCount(); i++ ) {
-        const TResourceFileInfo * file = info->resourceFile( i );
-        unsigned size = 0;
-        unsigned char * buf = loadFile( machine, file, "roms", &size );
-        
-        if( (buf == 0) && (strstr(file->name,".wav") != 0) ) {
-            buf = loadFile( machine, file, "samples", &size );
-        }
-        
-        if( buf != 0 ) {
-            machine->setResourceFile( file->id, buf, size );
-            delete buf;
-        }
-        else {
-            failedList.add( (void *)file->name );
-            result = false;
-        }
-    }
-    
-    return result;
-}
-
 TMachine * loadGame( const char * name )
 {
     TMachine * m = 0;
@@ -209,7 +71,7 @@ TMachine * loadGame( const char * name )
     // Load machine
     if( m != 0 ) {
         TList badFiles;
-        bool ok = loadMachineFiles( m, badFiles );
+        bool ok = loadMachineResources( m, basePath, badFiles );
         
         if( ! ok ) {
             // Unable to load required files
@@ -256,6 +118,12 @@ int main(int argc, char** argv) {
     SDLMainOptions options;
     
     const char * driver = 0;
+    const char * recordFile = 0;
+    const char * playFile = 0;
+    TFileOutputStream * recordStream = 0;
+    TFileInputStream * playStream = 0;
+    TInputRecorder * recorder = 0;
+    TInputPlayer * player = 0;
     
     for( int i=1; i<argc; i++ ) {
         const char * a = argv[i];
@@ -275,17 +143,65 @@ int main(int argc, char** argv) {
         else if( ! strcmp(a,"-help") || ! strcmp(a,"-?") ) {
             printf( "-fs    fullscreen mode (default is windowed)\n" );
             printf( "-list  list available drivers\n" );
+            printf( "-play file  play back the input recorded with -record (the driver can be omitted)\n" );
+            printf( "-record file  record the input of the game session\n" );
+            printf( "-runahead n  run n frames ahead to reduce the input latency (1 to 4)\n" );
+            printf( "-rewind  keep the last 10 seconds of play, hold BACKSPACE to rewind\n" );
+            printf( "-rgbvideo  convert video frames to RGB as soon as they are produced\n" );
+            printf( "-soundthread  run sound boards on a separate thread (sound is one frame late)\n" );
             
             return  EXIT_SUCCESS;
         }
         else if( ! strcmp(a,"-fs") ) {
             options.fullscreen = true;
         }
+        else if( ! strcmp(a,"-play") && (i+1 < argc) ) {
+            playFile = argv[++i];
+        }
+        else if( ! strcmp(a,"-record") && (i+1 < argc) ) {
+            recordFile = argv[++i];
+        }
+        else if( ! strcmp(a,"-rewind") ) {
+            options.rewindseconds = 10;
+        }
+        else if( ! strcmp(a,"-runahead") && (i+1 < argc) ) {
+            options.runahead = TMath::max( 0, TMath::min( atoi(argv[++i]), 4 ) );
+        }
+        else if( ! strcmp(a,"-rgbvideo") ) {
+            options.indexedvideo = false;
+        }
+        else if( ! strcmp(a,"-soundthread") ) {
+            TWorker::setFactory( SDLWorker::create );
+        }
         else {
             driver = a;
         }
     }
     
+    if( playFile ) {
+        playStream = TFileInputStream::open( playFile );
+        if( playStream ) {
+            player = new TInputPlayer( playStream );
+        }
+        if( ! player || ! player->isValid() ) {
+            printf( "Cannot read the input log: %s\n", playFile );
+            return EXIT_FAILURE;
+        }
+        if( ! driver ) {
+            driver = player->driver();
+        }
+        else if( strcmp( driver, player->driver() ) ) {
+            printf( "The input log was recorded with another driver: %s\n", player->driver() );
+            return EXIT_FAILURE;
+        }
+    }
+    
+    if( (playFile || recordFile) && (options.rewindseconds > 0) ) {
+        // Rewinding would make the frame numbers of the events meaningless
+        printf( "Rewind is not available while recording or playing input\n" );
+        options.rewindseconds = 0;
+    }
+    
     if( driver ) {
         machine = loadGame( driver );
         if( ! machine ) {
@@ -340,6 +256,16 @@ int main(int argc, char** argv) {
     joy[1]->bindButtonToKey( 3, idKeyP2Action4 );
     joy[1]->bindButtonToKey( 6, idKeyStartPlayer2 );
     joy[1]->bindButtonToKey( 7, idCoinSlot1 );
+    
+    if( recordFile ) {
+        recordStream = TFileOutputStream::open( recordFile, false );
+        if( ! recordStream ) {
+            printf( "Cannot create the input log: %s\n", recordFile );
+            return EXIT_FAILURE;
+        }
+        recorder = new TInputRecorder( recordStream, machine->getDriverInfo()->machineInfo()->driver );
+        inputManager.setRecorder( recorder );
+    }
 
     // Initialize SDL
     SDLMain sdl;
@@ -367,27 +293,43 @@ int main(int argc, char** argv) {
                 case SDL_USEREVENT:
                     switch( e.user.code ) {
                         case SDLTickleEvent_AddFrame:
-                            // Update joystick status: for now, only 2 joysticks are supported
-                            for( int i=0; i<2; i++ ) {
-                                Sint16 x;
-                                Sint16 y;
-                                unsigned buttons;
+                            if( player ) {
+                                // Live input is ignored until the playback is over
+                                player->play( machine );
                                 
-                                if( sdl.joystick_status( i, &x, &y, &buttons ) ) {
-                                    joy[i]->setPosition( x, y );
-                                    joy[i]->setButtons( buttons );
+                                if( player->isFinished() ) {
+                                    printf( "Input playback finished at frame %u\n", player->frame() );
+                                    delete player;
+                                    player = 0;
                                 }
                             }
-                            
-                            inputManager.notifyJoysticks( machine );
+                            else {
+                                // Update joystick status: for now, only 2 joysticks are supported
+                                for( int i=0; i<2; i++ ) {
+                                    Sint16 x;
+                                    Sint16 y;
+                                    unsigned buttons;
+                                    
+                                    if( sdl.joystick_status( i, &x, &y, &buttons ) ) {
+                                        joy[i]->setPosition( x, y );
+                                        joy[i]->setButtons( buttons );
+                                    }
+                                }
+                                
+                                inputManager.notifyJoysticks( machine );
+                            }
                             
                             sdl.add_frame( machine );
+                            
+                            if( recorder ) {
+                                recorder->nextFrame();
+                            }
                             break;
-                        case SDLTickleEvent_RenderTexture:
-                            sdl.render( (SDL_Texture *) e.user.data1 );
+                        case SDLTickleEvent_RenderVideo:
+                            sdl.render( (SDLVideo *) e.user.data1 );
                             break;
-                        case SDLTickleEvent_DestroyTexture:
-                            SDL_DestroyTexture( (SDL_Texture *) e.user.data1 );
+                        case SDLTickleEvent_DestroyVideo:
+                            delete (SDLVideo *) e.user.data1;
                             break;
                     }
                     break;
@@ -395,17 +337,23 @@ int main(int argc, char** argv) {
                     running = false;
                     break;
                 case SDL_KEYUP:
-                    if( ! inputManager.handle( e.key.keysym.sym, 0, machine ) ) {
+                    if( player || ! inputManager.handle( e.key.keysym.sym, 0, machine ) ) {
                         // Unhandled key
+                        if( e.key.keysym.sym == SDLK_BACKSPACE ) {
+                            sdl.set_rewinding( false );
+                        }
                     }
                     break;
                 case SDL_KEYDOWN:
-                    if( ! inputManager.handle( e.key.keysym.sym, 1, machine ) ) {
+                    if( player || ! inputManager.handle( e.key.keysym.sym, 1, machine ) ) {
                         // Unhandled key
                         switch( e.key.keysym.sym ) {
                             case SDLK_ESCAPE:
                                 running = false;
                                 break;
+                            case SDLK_BACKSPACE:
+                                sdl.set_rewinding( true );
+                                break;
                             case SDLK_p:
                                 paused = ! paused;
                                 if( paused ) {
@@ -424,5 +372,18 @@ int main(int argc, char** argv) {
         }
     }
     
+    sdl.print_rewind_stats();
+    sdl.print_runahead_stats();
+    
+    if( recorder ) {
+        printf( "Input recorded: %u frames\n", recorder->frame() );
+        inputManager.setRecorder( 0 );
+        delete recorder;
+        delete recordStream;
+    }
+    
+    delete player;
+    delete playStream;
+    
     return EXIT_SUCCESS;
 }
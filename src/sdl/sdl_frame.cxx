@@ -8,15 +8,138 @@
 
 #include "sdl_frame.h"
 
-SDLFrame::SDLFrame( SDL_Renderer * rend, unsigned sampleCount ) {
+SDLVideo::SDLVideo( SDL_Texture * texture ) {
+    texture_ = texture;
+    bits_ = 0;
+    colors_ = 0;
+    width_ = 0;
+    height_ = 0;
+    
+    SDL_QueryTexture( texture, 0, 0, &width_, &height_ );
+}
+
+SDLVideo::SDLVideo( TBitmapIndexed * bitmap, bool flipped ) {
+    texture_ = 0;
+    width_ = bitmap->width();
+    height_ = bitmap->height();
+    
+    // Copy the index plane (64K or so, instead of 4 times as much for a RGB texture)
+    int n = width_ * height_;
+    const unsigned char * src = bitmap->bits()->data();
+    
+    bits_ = new unsigned char [n];
+    
+    if( flipped ) {
+        unsigned char * dst = bits_ + n;
+        for( ; n>0; n-- ) {
+            *--dst = *src++;
+        }
+    }
+    else {
+        memcpy( bits_, src, n );
+    }
+    
+    // Copy the palette
+    const TPalette * palette = bitmap->palette();
+    
+    colors_ = TMath::min( palette->colors(), 256 );
+    
+    for( int i=0; i<colors_; i++ ) {
+        TPalette::decodeColor( palette->color(i), &palette_[i].r, &palette_[i].g, &palette_[i].b );
+        palette_[i].a = 0xFF;
+    }
+}
+
+SDLVideo::~SDLVideo() {
+    if( texture_ ) {
+        SDL_DestroyTexture( texture_ );
+    }
+    
+    delete [] bits_;
+}
+
+SDL_Surface * SDLVideo::createSurface() {
+    SDL_Surface * surface = SDL_CreateRGBSurfaceWithFormatFrom( bits_, width_, height_, 8, width_, SDL_PIXELFORMAT_INDEX8 );
+    
+    if( surface != 0 ) {
+        SDL_SetPaletteColors( surface->format->palette, palette_, 0, colors_ );
+    }
+    
+    return surface;
+}
+
+bool SDLVideo::upload( SDL_Texture * texture ) {
+    void * pixels;
+    int pitch;
+    Uint32 format;
+    bool ok = false;
+    
+    if( SDL_QueryTexture( texture, &format, 0, 0, 0 ) != 0 || SDL_LockTexture( texture, 0, &pixels, &pitch ) != 0 ) {
+        return false;
+    }
+    
+    // Let the SDL blitter apply the palette while writing directly into the texture memory
+    SDL_Surface * src = createSurface();
+    SDL_Surface * dst = SDL_CreateRGBSurfaceWithFormatFrom( pixels, width_, height_, 32, pitch, format );
+    
+    if( src != 0 && dst != 0 ) {
+        ok = SDL_BlitSurface( src, 0, dst, 0 ) == 0;
+    }
+    
+    SDL_FreeSurface( dst );
+    SDL_FreeSurface( src );
+    SDL_UnlockTexture( texture );
+    
+    return ok;
+}
+
+SDL_Texture * SDLVideo::createTexture( SDL_Renderer * rend ) {
+    SDL_Texture * texture = 0;
+    SDL_Surface * surface = createSurface();
+    
+    if( surface != 0 ) {
+        texture = SDL_CreateTextureFromSurface( rend, surface );
+        SDL_FreeSurface( surface );
+    }
+    
+    return texture;
+}
+
+SDLFrame::SDLFrame( SDL_Renderer * rend, unsigned sampleCount, bool indexedVideo ) {
     rend_ = rend;
     user_data_ = 0;
     sample_count_ = sampleCount;
+    indexed_video_ = indexedVideo;
     video_ = 0;
+    pcm_ = 0;
 }
 
 SDLFrame::~SDLFrame() {
-    SDL_DestroyTexture( video_ );
+    delete video_;
+    delete [] pcm_;
+}
+
+void SDLFrame::reset( unsigned sampleCount, bool indexedVideo ) {
+    if( sample_count_ != sampleCount ) {
+        delete [] pcm_;
+        pcm_ = 0;
+        sample_count_ = sampleCount;
+    }
+    
+    delete video_;
+    video_ = 0;
+    user_data_ = 0;
+    indexed_video_ = indexedVideo;
+    
+    mixer_.clear();
+}
+
+void SDLFrame::renderAudio() {
+    if( pcm_ == 0 ) {
+        pcm_ = new int16_t [ sample_count_ > 0 ? 2*sample_count_ : 2 ];
+    }
+    
+    mixer_.renderStereo( pcm_, sample_count_ );
 }
 
 static SDL_Surface * assignTBitmapToSDLSurface( SDL_Surface * surface, TBitmap * bitmap, bool flip )
@@ -60,7 +183,9 @@ static SDL_Surface * assignTBitmapToSDLSurface( SDL_Surface * surface, TBitmap *
         // Set pixels
         Uint32 dest_palette[256];
         
-        for( int i=0; i<256; i++ ) {
+        memset( dest_palette, 0, sizeof(dest_palette) );
+        
+        for( int i=0; i<(int)bm->palette()->colors() && i<256; i++ ) {
             unsigned char r, g, b;
             TPalette::decodeColor( palette[i], &r, &g, &b );
             dest_palette[i] = SDL_MapRGB( surface->format, r, g, b );
@@ -99,10 +224,20 @@ static SDL_Surface * assignTBitmapToSDLSurface( SDL_Surface * surface, TBitmap *
 }
 
 void SDLFrame::setVideo( TBitmap * video, bool flipped ) {
+    // Indexed bitmaps can be converted at presentation time
+    if( indexed_video_ && video != 0 && video->format() == bfIndexed ) {
+        video_ = new SDLVideo( reinterpret_cast<TBitmapIndexed *>( video ), flipped );
+        return;
+    }
+    
     SDL_Surface * buffer = assignTBitmapToSDLSurface( 0, video, flipped );
     
     if( buffer ) {
-        video_ = SDL_CreateTextureFromSurface( rend_, buffer );
+        SDL_Texture * texture = SDL_CreateTextureFromSurface( rend_, buffer );
         SDL_FreeSurface(buffer );
+        
+        if( texture ) {
+            video_ = new SDLVideo( texture );
+        }
     }
 }
@@ -13,10 +13,59 @@
 #include <emu/emu_math.h>
 #include <emu/emu_mixer.h>
 
+/**
+    A video frame waiting to be presented.
+    
+    It holds either a texture that has already been converted to RGB by the CPU,
+    or a copy of the 8-bit indexed screen with its palette, which is converted
+    only if and when the frame is actually presented.
+*/
+class SDLVideo
+{
+public:
+    SDLVideo( SDL_Texture * texture );
+    
+    SDLVideo( TBitmapIndexed * bitmap, bool flipped );
+    
+    ~SDLVideo();
+    
+    bool isIndexed() const {
+        return bits_ != 0;
+    }
+    
+    int width() const {
+        return width_;
+    }
+    
+    int height() const {
+        return height_;
+    }
+    
+    SDL_Texture * getTexture() const {
+        return texture_;
+    }
+    
+    // Apply the palette to the indexed image and store the result into a streaming texture of the same size
+    bool upload( SDL_Texture * texture );
+    
+    // Create a new texture from the indexed image
+    SDL_Texture * createTexture( SDL_Renderer * rend );
+    
+private:
+    SDL_Surface * createSurface();
+    
+    SDL_Texture * texture_;
+    unsigned char * bits_;
+    SDL_Color palette_[256];
+    int colors_;
+    int width_;
+    int height_;
+};
+
 class SDLFrame : public TFrame
 {
 public:
-    SDLFrame( SDL_Renderer * rend, unsigned sampleCount );
+    SDLFrame( SDL_Renderer * rend, unsigned sampleCount, bool indexedVideo = false );
 
     virtual ~SDLFrame();
 
@@ -26,20 +75,37 @@ public:
         return &mixer_;
     }
     
-    SDL_Texture * getTexture() {
+    SDLVideo * getVideo() {
         return video_;
     }
     
-    SDL_Texture * getAndDetachTexture() {
-        SDL_Texture * txt = video_;
+    SDLVideo * getAndDetachVideo() {
+        SDLVideo * v = video_;
         video_ = 0;
-        return txt;
+        return v;
+    }
+    
+    // Replace the video with one taken from another frame
+    void attachVideo( SDLVideo * video ) {
+        delete video_;
+        video_ = video;
     }
     
     unsigned getSampleCount() const {
         return sample_count_;
     }
     
+    // Prepare a used frame to be filled again (keeps the mixer buffers)
+    void reset( unsigned sampleCount, bool indexedVideo );
+    
+    // Mix down the audio into interleaved stereo 16-bit samples, ready to be played
+    void renderAudio();
+    
+    // Returns the rendered audio (two samples per sample frame), or null if renderAudio() has not been called
+    const int16_t * getAudio() const {
+        return pcm_;
+    }
+    
     unsigned getUserData() const {
         return user_data_;
     }
@@ -50,8 +116,10 @@ public:
 
 private:
     SDL_Renderer * rend_;
-    SDL_Texture * video_;
+    SDLVideo * video_;
+    bool indexed_video_;
     TMixerMono mixer_;
+    int16_t * pcm_;
     unsigned sample_count_;
     unsigned user_data_;
 };
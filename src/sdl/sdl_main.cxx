@@ -18,9 +18,19 @@ void SDLMain::reset() {
     window_ = 0;
     window_flags_ = 0;
     rend_ = 0;
+    stream_texture_ = 0;
+    stream_w_ = 0;
+    stream_h_ = 0;
     adid_ = 0;
     frame_delay_ = 0;
     video_tid_ = 0;
+    rewind_ = 0;
+    rewinding_ = false;
+    ahead_frame_ = 0;
+    ahead_state_ = 0;
+    ahead_ticks_ = 0;
+    frame_ticks_ = 0;
+    ahead_count_ = 0;
     int maxj = sizeof(joystick_) / sizeof(joystick_[0]);
     for( int i=0; i<maxj; i++ ) {
         joystick_[i] = 0;
@@ -63,7 +73,7 @@ bool SDLMain::init( const SDLMainOptions & options ) {
         
         want.freq = options_.audiofreq;
         want.format = AUDIO_S16SYS;
-        want.channels = 1; // Mono
+        want.channels = 2; // Stereo
         want.samples = SamplesPerCallback;
         want.callback = audioCallbackStub;
         want.userdata = this;
@@ -126,6 +136,11 @@ void SDLMain::term() {
     SDL_CloseAudioDevice( adid_ );
     
     // TODO: empty queues
+    SDLFrame * frame;
+    
+    while( (frame = (SDLFrame *) free_q_.remove()) != 0 ) {
+        delete frame;
+    }
 
     int maxj = sizeof(joystick_) / sizeof(joystick_[0]);
     for( int i=0; i<maxj; i++ ) {
@@ -134,6 +149,14 @@ void SDLMain::term() {
         }
     }
 
+    if( stream_texture_ ) {
+        SDL_DestroyTexture( stream_texture_ );
+    }
+    
+    delete rewind_;
+    delete ahead_frame_;
+    delete ahead_state_;
+    
     SDL_DestroyRenderer( rend_ );
     SDL_DestroyWindow( window_ );
     SDL_Quit();
@@ -141,7 +164,38 @@ void SDLMain::term() {
     reset();
 }
 
-void SDLMain::render( SDL_Texture * texture ) const {
+SDL_Texture * SDLMain::getStreamingTexture( int w, int h ) {
+    if( stream_texture_ == 0 || stream_w_ != w || stream_h_ != h ) {
+        if( stream_texture_ ) {
+            SDL_DestroyTexture( stream_texture_ );
+        }
+        
+        stream_texture_ = SDL_CreateTexture( rend_, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h );
+        stream_w_ = w;
+        stream_h_ = h;
+    }
+    
+    return stream_texture_;
+}
+
+void SDLMain::render( SDLVideo * video ) {
+    if( video == 0 ) {
+        return;
+    }
+    
+    SDL_Texture * texture = video->getTexture();
+    SDL_Texture * temp_texture = 0;
+    
+    if( video->isIndexed() ) {
+        // Apply the palette directly into the streaming texture, if that fails
+        // fall back to a new texture converted by the CPU
+        texture = getStreamingTexture( video->width(), video->height() );
+        
+        if( texture == 0 || ! video->upload( texture ) ) {
+            texture = temp_texture = video->createTexture( rend_ );
+        }
+    }
+    
     if( texture != 0 ) {
         if( window_flags_ & (SDL_WINDOW_FULLSCREEN|SDL_WINDOW_FULLSCREEN_DESKTOP) ) {
             int aw, ah;
@@ -172,17 +226,89 @@ void SDLMain::render( SDL_Texture * texture ) const {
         }
         
         SDL_RenderPresent( rend_ );
-        SDL_DestroyTexture( texture );
     }
+    
+    if( temp_texture ) {
+        SDL_DestroyTexture( temp_texture );
+    }
+    
+    delete video;
 }
 
 void SDLMain::add_frame( TMachine * machine ) {
     int audioSamplesPerFrame = options_.audiofreq / machine->getDriverInfo()->machineInfo()->framesPerSecond;
-    SDLFrame * frame = new SDLFrame( rend_, audioSamplesPerFrame );
+    
+    // Reuse a played frame if possible, so that its buffers are not allocated again
+    audio_lock();
+    SDLFrame * frame = (SDLFrame *) free_q_.remove();
+    audio_unlock();
+    
+    if( frame != 0 ) {
+        frame->reset( audioSamplesPerFrame, options_.indexedvideo );
+    }
+    else {
+        frame = new SDLFrame( rend_, audioSamplesPerFrame, options_.indexedvideo );
+    }
+    
+    // Step back one frame if rewinding, otherwise save the state of this frame
+    bool rewound = rewinding_ && (rewind_ != 0) && rewind_->pop( machine );
+    
+    if( (rewind_ != 0) && ! rewound ) {
+        rewind_->push( machine );
+    }
+    
+    // When running ahead only the sound of this frame is used
+    bool ahead = (ahead_state_ != 0) && ! rewound;
+    
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    frame->setHeadless( ahead );
+    
     machine->run( frame, audioSamplesPerFrame, options_.audiofreq );
+    
+    if( rewound ) {
+        frame->getMixer()->clear(); // Mute the sound while rewinding
+    }
+    
+    frame->renderAudio();
+    
+    if( ahead ) {
+        frame_ticks_ += SDL_GetPerformanceCounter() - start;
+        
+        runAhead( machine, frame, audioSamplesPerFrame );
+    }
+    
     add_frame( frame );
 }
 
+// Run the machine a few frames ahead and show the last one, as if the
+// inputs had been received earlier, then go back to the current frame
+void SDLMain::runAhead( TMachine * machine, SDLFrame * frame, int audioSamplesPerFrame ) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    ahead_state_->clear();
+    
+    if( ! machine->saveState( ahead_state_ ) ) {
+        return;
+    }
+    
+    for( int i=1; i<=options_.runahead; i++ ) {
+        ahead_frame_->reset( audioSamplesPerFrame, options_.indexedvideo );
+        ahead_frame_->setHeadless( i < options_.runahead );
+        
+        machine->run( ahead_frame_, audioSamplesPerFrame, options_.audiofreq );
+    }
+    
+    frame->attachVideo( ahead_frame_->getAndDetachVideo() );
+    
+    TMemoryInputStream is( ahead_state_->data(), ahead_state_->size() );
+    
+    machine->loadState( &is );
+    
+    ahead_ticks_ += SDL_GetPerformanceCounter() - start;
+    ahead_count_++;
+}
+
 void SDLMain::add_frame( SDLFrame * frame ) {
     audio_lock();
     audio_q_.append( frame );
@@ -224,9 +350,41 @@ bool SDLMain::joystick_status( int joystick, Sint16 * x, Sint16 * y, unsigned *
     return ok;
 }
 
+void SDLMain::print_rewind_stats() const {
+    if( rewind_ != 0 ) {
+        printf( "Rewind buffer: %u frames, %u KB, %u bytes per frame\n", rewind_->count(), rewind_->bytesUsed() / 1024, rewind_->averageFrameBytes() );
+    }
+}
+
+void SDLMain::print_runahead_stats() const {
+    if( ahead_count_ > 0 ) {
+        double ms = (double) ahead_ticks_ * 1000.0 / (double) SDL_GetPerformanceFrequency() / ahead_count_;
+        double cost = frame_ticks_ > 0 ? (double) ahead_ticks_ * 100.0 / (double) frame_ticks_ : 0.0;
+        
+        printf( "Run-ahead: %d frames, %.2f ms per frame (+%.0f%% emulation time)\n", options_.runahead, ms, cost );
+    }
+}
+
 bool SDLMain::go( TMachine * machine ) {
     int audioSamplesPerFrame = options_.audiofreq / machine->getDriverInfo()->machineInfo()->framesPerSecond;
     
+    if( options_.runahead > 0 ) {
+        ahead_state_ = new TMemoryOutputStream;
+        
+        if( machine->saveState( ahead_state_ ) ) {
+            ahead_frame_ = new SDLFrame( rend_, audioSamplesPerFrame, options_.indexedvideo );
+        }
+        else {
+            printf( "Run-ahead is not supported by this driver\n" );
+            delete ahead_state_;
+            ahead_state_ = 0;
+        }
+    }
+    
+    if( options_.rewindseconds > 0 ) {
+        rewind_ = new TRewindBuffer( options_.rewindmemory, options_.rewindseconds * machine->getDriverInfo()->machineInfo()->framesPerSecond );
+    }
+    
     // Initialize the frame queue with enough frames
     for( int n=0; n<audioSamplesPerFrame; n+=SamplesPerCallback ) {
         add_frame( machine );
@@ -235,7 +393,7 @@ bool SDLMain::go( TMachine * machine ) {
     
     frame_delay_ = 1000 / machine->getDriverInfo()->machineInfo()->framesPerSecond;
     
-    cur_frame_ = new SDLFrame( rend_, 0 );
+    cur_frame_ = new SDLFrame( rend_, 0, options_.indexedvideo );
     
     audio_play();
     
@@ -251,21 +409,23 @@ Uint32 SDLMain::videoCallbackStub( Uint32 interval, void * param ) {
 unsigned SDLMain::videoStreamCallback( unsigned interval ) {
     if( ! video_q_.empty() ) {
         // Show last queued element
-        SDL_Texture * texture = 0;
+        SDLVideo * video = 0;
         
         do {
             audio_lock();
-            SDL_Texture * t = (SDL_Texture *) video_q_.remove();
+            SDLVideo * v = (SDLVideo *) video_q_.remove();
             audio_unlock();
             
-            if( t != 0 ) { // Texture may be null if the machine driver has skipped a video frame (e.g. Pacman)
-                push_user_event( SDLTickleEvent_DestroyTexture, texture );
-                texture = t;
+            if( v != 0 ) { // Video may be null if the machine driver has skipped a video frame (e.g. Pacman)
+                if( video != 0 ) {
+                    push_user_event( SDLTickleEvent_DestroyVideo, video );
+                }
+                video = v;
             }
         } while( ! video_q_.empty() );
 
         // Can't render inside a timer callback, send message to main loop
-        push_user_event( SDLTickleEvent_RenderTexture, texture );
+        push_user_event( SDLTickleEvent_RenderVideo, video );
     }
     
     return frame_delay_;
@@ -289,7 +449,7 @@ void SDLMain::audioStreamCallback( Uint8 * stream, int len ) {
     
     int16_t * stream16 = (int16_t *) stream;
     
-    len /= 2; // Convert bytes in samples
+    len /= 4; // Convert bytes in sample frames (16-bit stereo)
     
     while( len > 0 ) {
         unsigned cf_ofs = cur_frame_->getUserData();
@@ -300,42 +460,37 @@ void SDLMain::audioStreamCallback( Uint8 * stream, int len ) {
 
         cur_frame_->setUserData( cf_ofs + cf_avail );
         
-        // Copy into destination stream
-        int voices = cur_frame_->getMixer()->maxVoicesPerChannel();
-        const int * buf = cur_frame_->getMixer()->buffer(0);
+        // Copy into destination stream (audio has been mixed down when the frame was added)
+        const int16_t * buf = cur_frame_->getAudio();
         
         if( buf != 0 ) {
-            buf += cf_ofs;
-            
-            for( unsigned i=0; i<cf_avail; i++ ) {
-                *stream16++ = *buf++ * (128 / voices);
-            }
+            memcpy( stream16, buf + 2*cf_ofs, cf_avail*4 );
         }
         else {
-            for( unsigned i=0; i<cf_avail; i++ ) {
-                *stream16++ = 0;
-            }
+            memset( stream16, 0, cf_avail*4 );
         }
         
+        stream16 += 2*cf_avail;
+        
         // Update frame
         len -= cf_avail;
         
         // If current frame is empty, dispose it and get a new one from the queue
         if( cf_avail == 0 ) {
-            delete cur_frame_;
+            free_q_.append( cur_frame_ );
             
             cur_frame_ = (SDLFrame *) audio_q_.remove();
             
             if( cur_frame_ == 0 ) {
                 // Ouch, we run out of frames... request an extra frame, clear the rest of the buffer and return
                 push_user_event( SDLTickleEvent_AddFrame );
-                memset( stream16, 0, len*2 );
+                memset( stream16, 0, len*4 );
                 return;
             }
             
-            SDL_Texture * t = cur_frame_->getAndDetachTexture();
+            SDLVideo * v = cur_frame_->getAndDetachVideo();
             
-            video_q_.append( t );
+            video_q_.append( v );
             
             // Hmmm: shall this be moved to the event loop?
             if( video_tid_ == 0 ) {
@@ -14,25 +14,35 @@
 
 enum {
     SDLTickleEvent_AddFrame = 0,
-    SDLTickleEvent_RenderTexture,
-    SDLTickleEvent_DestroyTexture,
+    SDLTickleEvent_RenderVideo,
+    SDLTickleEvent_DestroyVideo,
     // Leave this line for last, it contains how many user events have been defined
     SDLTickleEvent_Count
 };
 
 class TMachine;
+class TRewindBuffer;
+class TMemoryOutputStream;
 
 struct SDLMainOptions {
     int w; // Window width
     int h; // Window height
     bool fullscreen; // Fullscreen on/off
     int audiofreq; // Audio frequency (sampling rate)
+    bool indexedvideo; // Queue 8-bit frames and apply the palette at presentation (otherwise convert to RGB right away)
+    int rewindseconds; // How far back the game can be rewound, 0 to disable
+    unsigned rewindmemory; // Maximum memory used by the rewind buffer
+    int runahead; // Frames emulated ahead of the displayed one to hide the input latency, 0 to disable
     
     SDLMainOptions() {
         w = 224;
         h = 288;
         fullscreen = false;
         audiofreq = 44100;
+        indexedvideo = true;
+        rewindseconds = 0;
+        rewindmemory = 8*1024*1024;
+        runahead = 0;
     }
     
     SDLMainOptions & operator = ( const SDLMainOptions & o ) {
@@ -40,6 +50,10 @@ struct SDLMainOptions {
         h = o.h;
         fullscreen = o.fullscreen;
         audiofreq = o.audiofreq;
+        indexedvideo = o.indexedvideo;
+        rewindseconds = o.rewindseconds;
+        rewindmemory = o.rewindmemory;
+        runahead = o.runahead;
         return *this;
     }
 };
@@ -58,7 +72,7 @@ public:
     
     bool go( TMachine * machine );
     
-    void render( SDL_Texture * texture ) const;
+    void render( SDLVideo * video );
     
     void sleep( unsigned ms ) const {
         SDL_Delay( (Uint32) ms );
@@ -90,6 +104,15 @@ public:
     
     void set_audio_rate( int rate );
     
+    // While rewinding, each new frame steps back one frame instead of going forward
+    void set_rewinding( bool rewinding ) {
+        rewinding_ = rewinding;
+    }
+    
+    void print_rewind_stats() const;
+    
+    void print_runahead_stats() const;
+    
     SDL_Window * window() {
         return window_;
     }
@@ -109,11 +132,18 @@ private:
     
     void audioStreamCallback( Uint8 * stream, int len );
     
+    SDL_Texture * getStreamingTexture( int w, int h );
+    
+    void runAhead( TMachine * machine, SDLFrame * frame, int audioSamplesPerFrame );
+    
     unsigned videoStreamCallback( unsigned interval );
     
     SDL_Window * window_;
     Uint32 window_flags_;
     SDL_Renderer * rend_;
+    SDL_Texture * stream_texture_; // Persistent texture for indexed video frames
+    int stream_w_;
+    int stream_h_;
     SDL_AudioDeviceID adid_;
     SDL_Joystick * joystick_[2];
     Uint32 user_event_type_;
@@ -121,8 +151,16 @@ private:
     SDL_TimerID video_tid_;
     unsigned frame_delay_;
     SDLFrame * cur_frame_;
+    TRewindBuffer * rewind_;
+    bool rewinding_;
+    SDLFrame * ahead_frame_; // Scratch frame for the frames run ahead
+    TMemoryOutputStream * ahead_state_;
+    Uint64 ahead_ticks_; // Time spent running ahead
+    Uint64 frame_ticks_; // Time spent running the displayed frames
+    unsigned ahead_count_;
     Fifo audio_q_;
     Fifo video_q_;
+    Fifo free_q_; // Played frames, ready to be reused
 };
 
 #endif /* defined(__tickle__sdl_main__) */
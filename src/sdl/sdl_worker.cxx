@@ -0,0 +1,79 @@
+/*
+    Tickle class library
+    Worker thread for the emulation library
+ 
+    Copyright (c) 2014 Alessandro Scotti
+*/
+#include <stdio.h>
+
+#include "sdl_worker.h"
+
+SDLWorker::SDLWorker() {
+    function_ = 0;
+    context_ = 0;
+    busy_ = false;
+    quit_ = false;
+    start_sem_ = SDL_CreateSemaphore( 0 );
+    done_sem_ = SDL_CreateSemaphore( 0 );
+    thread_ = 0;
+    
+    if( start_sem_ != 0 && done_sem_ != 0 ) {
+        thread_ = SDL_CreateThread( threadStub, "worker", this );
+    }
+}
+
+SDLWorker::~SDLWorker() {
+    if( thread_ != 0 ) {
+        wait();
+        quit_ = true;
+        SDL_SemPost( start_sem_ );
+        SDL_WaitThread( thread_, 0 );
+    }
+    
+    if( start_sem_ != 0 ) SDL_DestroySemaphore( start_sem_ );
+    if( done_sem_ != 0 ) SDL_DestroySemaphore( done_sem_ );
+}
+
+void SDLWorker::start( TWorkerFunction function, void * context ) {
+    function_ = function;
+    context_ = context;
+    busy_ = true;
+    SDL_SemPost( start_sem_ );
+}
+
+void SDLWorker::wait() {
+    if( busy_ ) {
+        SDL_SemWait( done_sem_ );
+        busy_ = false;
+    }
+}
+
+TWorker * SDLWorker::create() {
+    SDLWorker * worker = new SDLWorker();
+    
+    if( worker->thread_ == 0 ) {
+        printf( "Cannot create worker thread: %s\n", SDL_GetError() );
+        delete worker;
+        worker = 0;
+    }
+    
+    return worker;
+}
+
+int SDLWorker::threadStub( void * data ) {
+    SDLWorker * worker = (SDLWorker *) data;
+    
+    for( ;; ) {
+        SDL_SemWait( worker->start_sem_ );
+        
+        if( worker->quit_ ) {
+            break;
+        }
+        
+        worker->function_( worker->context_ );
+        
+        SDL_SemPost( worker->done_sem_ );
+    }
+    
+    return 0;
+}
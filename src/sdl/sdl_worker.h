@@ -0,0 +1,38 @@
+/*
+    Tickle class library
+ 
+    Copyright (c) 2014 Alessandro Scotti
+*/
+#ifndef __tickle__sdl_worker__
+#define __tickle__sdl_worker__
+
+#include <SDL2/SDL.h>
+
+#include <emu/emu_worker.h>
+
+class SDLWorker : public TWorker {
+public:
+    SDLWorker();
+    
+    virtual ~SDLWorker();
+    
+    virtual void start( TWorkerFunction function, void * context );
+    
+    virtual void wait();
+    
+    // Factory for TWorker::setFactory(), returns 0 if the thread cannot be created
+    static TWorker * create();
+    
+private:
+    static int threadStub( void * data );
+    
+    SDL_Thread * thread_;
+    SDL_sem * start_sem_;
+    SDL_sem * done_sem_;
+    TWorkerFunction function_;
+    void * context_;
+    bool busy_; // Only used by the owner thread
+    bool quit_;
+};
+
+#endif /* defined(__tickle__sdl_worker__) */
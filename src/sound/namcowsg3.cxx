@@ -5,6 +5,8 @@
 */
 #include <string.h>
 
+#include <emu/emu_state.h>
+
 #include "namcowsg3.h"
 
 NamcoWsg3::NamcoWsg3( unsigned masterClock )
@@ -18,15 +20,24 @@ NamcoWsg3::NamcoWsg3( unsigned masterClock )
 
     for( unsigned j=0; j<sizeof(sound_regs_); j++ ) {
         sound_regs_[j] = 0;
+        cpu_regs_[j] = 0;
     }
+
+    memset( scaled_wave_, 0, sizeof(scaled_wave_) );
 }
 
 void NamcoWsg3::setSoundPROM( const unsigned char * prom )
 {
     memcpy( sound_prom_, prom, sizeof(sound_prom_) );
 
-    for( int i=0; i<32*8; i++ ) {
-        sound_wave_data_[i] = (int)*prom++; // 4-bit data
+    // Precompute each waveform at each volume, so that rendering
+    // is reduced to a table lookup per voice
+    for( int w=0; w<8; w++ ) {
+        for( int v=0; v<16; v++ ) {
+            for( int i=0; i<32; i++ ) {
+                scaled_wave_[w][v][i] = (int) sound_prom_[32*w + i] * v; // 4-bit data
+            }
+        }
     }
 }
 
@@ -52,28 +63,128 @@ void NamcoWsg3::getVoice( NamcoWsg3Voice * voice, int index ) const
     voice->frequency = f;
 }
 
+static inline int nextSample( const int * wave, unsigned & offset, unsigned step )
+{
+    // Should be shifted right by 15, but we must also get rid
+    // of the 10 bits used for decimals
+    int result = wave[(offset >> 25) & 0x1F];
+
+    offset += step;
+
+    return result;
+}
+
+void NamcoWsg3::beginFrame( unsigned cycle, unsigned cyclesPerFrame )
+{
+    // Apply writes from a frame that has not been played
+    for( unsigned i=0; i<log_.count(); i++ ) {
+        sound_regs_[ log_[i].reg ] = log_[i].value;
+    }
+
+    endRegisterLog();
+
+    log_.begin( cycle, cyclesPerFrame );
+}
+
+void NamcoWsg3::endRegisterLog()
+{
+    if( log_.isOverflow() ) {
+        // Catch up with the writes that did not fit into the log
+        memcpy( sound_regs_, cpu_regs_, sizeof(sound_regs_) );
+    }
+
+    log_.end();
+}
+
 /*
-    Play and mix the sound voices into the specified buffer.
+    Play and mix the sound voices into the specified buffer, splitting
+    it at the logged register writes (if any).
 */
 void NamcoWsg3::playSound( int * buf, int len )
+{
+    int pos = 0;
+
+    for( unsigned i=0; i<log_.count(); i++ ) {
+        int offset = (int) log_.getSampleOffset( i, len );
+
+        if( offset > pos ) {
+            renderVoices( buf + pos, offset - pos );
+            pos = offset;
+        }
+
+        sound_regs_[ log_[i].reg ] = log_[i].value;
+    }
+
+    endRegisterLog();
+
+    renderVoices( buf + pos, len - pos );
+}
+
+/*
+    Render and mix the sound voices into the specified buffer.
+
+    All three voices are rendered in a single pass over the buffer, four
+    samples at a time. Inactive voices play the (silent) zero volume table
+    and do not advance.
+*/
+void NamcoWsg3::renderVoices( int * buf, int len )
 {
     NamcoWsg3Voice voice;
+    const int * wave[3];
+    unsigned step[3];
+    int active = 0;
 
     for( int index=0; index<3; index++ ) {
         getVoice( &voice, index );
         if( voice.isActive() ) {
-            unsigned offset = wave_offset_[index];
-            unsigned offset_step = voice.frequency * resample_step_;
-            int * wave_data = sound_wave_data_ + 32 * voice.waveform;
-
-            for( int i=0; i<len; i++ ) {
-                // Should be shifted right by 15, but we must also get rid
-                // of the 10 bits used for decimals
-                buf[i] += wave_data[(offset >> 25) & 0x1F] * (int) voice.volume;
-                offset += offset_step;
-            }
-
-            wave_offset_[index] = offset;
+            wave[index] = scaled_wave_[voice.waveform][voice.volume];
+            step[index] = voice.frequency * resample_step_;
+            active++;
+        }
+        else {
+            wave[index] = scaled_wave_[0][0];
+            step[index] = 0;
         }
     }
+
+    if( active == 0 ) {
+        return;
+    }
+
+    const int * w0 = wave[0];
+    const int * w1 = wave[1];
+    const int * w2 = wave[2];
+    unsigned o0 = wave_offset_[0];
+    unsigned o1 = wave_offset_[1];
+    unsigned o2 = wave_offset_[2];
+    unsigned s0 = step[0];
+    unsigned s1 = step[1];
+    unsigned s2 = step[2];
+    int i = 0;
+
+    for( ; i+4 <= len; i += 4 ) {
+        buf[i+0] += nextSample( w0, o0, s0 ) + nextSample( w1, o1, s1 ) + nextSample( w2, o2, s2 );
+        buf[i+1] += nextSample( w0, o0, s0 ) + nextSample( w1, o1, s1 ) + nextSample( w2, o2, s2 );
+        buf[i+2] += nextSample( w0, o0, s0 ) + nextSample( w1, o1, s1 ) + nextSample( w2, o2, s2 );
+        buf[i+3] += nextSample( w0, o0, s0 ) + nextSample( w1, o1, s1 ) + nextSample( w2, o2, s2 );
+    }
+
+    for( ; i < len; i++ ) {
+        buf[i] += nextSample( w0, o0, s0 ) + nextSample( w1, o1, s1 ) + nextSample( w2, o2, s2 );
+    }
+
+    wave_offset_[0] = o0;
+    wave_offset_[1] = o1;
+    wave_offset_[2] = o2;
+}
+
+void NamcoWsg3::serialize( TStateStream & state )
+{
+    state.bytes( sound_regs_, sizeof(sound_regs_) );
+    state.bytes( cpu_regs_, sizeof(cpu_regs_) );
+    state.bytes( wave_offset_, sizeof(wave_offset_) );
+
+    if( state.isLoading() ) {
+        log_.end();
+    }
 }
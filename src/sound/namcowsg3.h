@@ -6,6 +6,10 @@
 #ifndef NAMCO_WSG3_H_
 #define NAMCO_WSG3_H_
 
+#include "registerlog.h"
+
+class TStateStream;
+
 /**
     Namco 3-channel sound generator voice properties.    
 
@@ -72,14 +76,38 @@ public:
         Sets the value of the specified register.
     */
     void setRegister( unsigned reg, unsigned char value ) {
+        cpu_regs_[reg] = value;
         sound_regs_[reg] = value;
     }
 
+    /**
+        Sets the value of the specified register at the specified CPU cycle.
+
+        If a frame is being logged (see beginFrame()) the write will take effect
+        at the corresponding sample in the next call to playSound(), otherwise
+        it is applied immediately.
+    */
+    void setRegister( unsigned reg, unsigned char value, unsigned cycle ) {
+        cpu_regs_[reg] = value;
+
+        if( ! log_.add( cycle, reg, value ) ) {
+            sound_regs_[reg] = value;
+        }
+    }
+
+    /**
+        Starts logging register writes for a new frame.
+
+        @param cycle current value of the CPU cycle counter
+        @param cyclesPerFrame number of CPU cycles per frame
+    */
+    void beginFrame( unsigned cycle, unsigned cyclesPerFrame );
+
     /**
         Returns the value of the specified register.
     */
     unsigned char getRegister( unsigned reg ) const {
-        return sound_regs_[reg];
+        return cpu_regs_[reg];
     }
 
     /**
@@ -98,11 +126,21 @@ public:
         Note: this function does not clear the content of the output buffer before
         mixing voices into it.
 
+        If register writes have been logged since beginFrame(), the buffer is
+        assumed to span the whole frame and each write is applied at the
+        corresponding sample.
+
         @param buf pointer to sound buffer that receives the audio samples
         @param len length of the sound buffer
     */
     void playSound( int * buf, int len );
 
+    /**
+        Saves or loads the chip state. States must be taken between frames,
+        when no register writes are being logged.
+    */
+    void serialize( TStateStream & state );
+
     /**
         Returns a pointer to a structure describing the current status of the
         specified voice in the sound generator. 
@@ -138,14 +176,20 @@ public:
     }
 
 private:
+    void renderVoices( int * buf, int len );
+
+    void endRegisterLog();
+
     unsigned        master_clock_;          // Master clock of sound chip
     unsigned        sampling_rate_;         // Sampling rate for generated sound
     unsigned char   sound_regs_[0x20];      // Sound registers
+    unsigned char   cpu_regs_[0x20];        // Registers as written by the CPU (ahead of sound_regs_ while logging)
+    TRegisterLog    log_;                   // Writes not yet applied to sound_regs_
     unsigned char   sound_prom_[32*8];      // Sound chip wavetable PROM
     // Internal variable for faster sound generation
     unsigned        resample_step_;
     unsigned        wave_offset_[3];        // Current sample offset (for each voice)
-    int             sound_wave_data_[32*8]; // Wave data for sound generation
+    int             scaled_wave_[8][16][32];// Wave data premultiplied by volume (for each waveform)
 };
 
 #endif // NAMCO_WSG3_H_
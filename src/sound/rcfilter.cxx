@@ -5,6 +5,8 @@
 */
 #include <math.h>
 
+#include <emu/emu_state.h>
+
 #include "rcfilter.h"
 
 void RCFilter::apply( int * buf, unsigned len, unsigned samplingRate ) 
@@ -25,3 +27,14 @@ void RCFilter::apply( int * buf, unsigned len, unsigned samplingRate )
         len--;
     }
 }
+
+void RCFilter::serialize( TStateStream & state )
+{
+    state.value( y_ );
+    state.value( r_ );
+    state.value( c_ );
+
+    if( state.isLoading() ) {
+        sampling_rate_ = 0; // Force a refresh next time filter is applied
+    }
+}
@@ -6,6 +6,8 @@
 #ifndef RCFILTER_H_
 #define RCFILTER_H_
 
+class TStateStream;
+
 class RCFilter 
 {
 public:
@@ -26,6 +28,8 @@ public:
 
     void apply( int * buf, unsigned len, unsigned samplingRate );
 
+    void serialize( TStateStream & state );
+
 private:
     unsigned sampling_rate_;
     double y_; // Last sample
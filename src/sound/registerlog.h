@@ -0,0 +1,129 @@
+/*
+    Timestamped log of sound chip register writes
+
+    Copyright (c) 2004 Alessandro Scotti
+*/
+#ifndef REGISTERLOG_H_
+#define REGISTERLOG_H_
+
+/**
+    Register write, with the CPU cycle it happened at.
+*/
+struct TRegisterWrite
+{
+    /** CPU cycle of the write, relative to the start of the frame */
+    unsigned cycle;
+    /** Register index (or chip specific control line) */
+    unsigned reg;
+    /** Value written */
+    unsigned char value;
+};
+
+/**
+    Log of the register writes performed by the CPU during a frame.
+
+    Sound chips that support the log record writes while the CPU runs and
+    then render the whole frame in one pass, applying each write at the
+    sample it corresponds to. If the log fills up, the remaining writes are
+    only kept in the CPU view of the registers, and the chip catches up at
+    the end of the frame.
+*/
+class TRegisterLog
+{
+public:
+    enum {
+        MaxWrites = 512
+    };
+
+    TRegisterLog() {
+        cycles_per_frame_ = 1;
+        end();
+    }
+
+    /**
+        Starts recording a new frame.
+
+        @param cycle current value of the CPU cycle counter
+        @param cyclesPerFrame number of CPU cycles in a frame
+    */
+    void begin( unsigned cycle, unsigned cyclesPerFrame ) {
+        start_cycle_ = cycle;
+        cycles_per_frame_ = cyclesPerFrame ? cyclesPerFrame : 1;
+        count_ = 0;
+        overflow_ = false;
+        active_ = true;
+    }
+
+    /**
+        Stops recording and clears the log.
+    */
+    void end() {
+        start_cycle_ = 0;
+        count_ = 0;
+        overflow_ = false;
+        active_ = false;
+    }
+
+    /**
+        Records a write.
+
+        @return false if the log is not recording, in which case the write
+        should be applied immediately
+    */
+    bool add( unsigned cycle, unsigned reg, unsigned char value ) {
+        if( ! active_ ) {
+            return false;
+        }
+
+        if( count_ < MaxWrites ) {
+            writes_[count_].cycle = cycle - start_cycle_;
+            writes_[count_].reg = reg;
+            writes_[count_].value = value;
+            count_++;
+        }
+        else {
+            overflow_ = true;
+        }
+
+        return true;
+    }
+
+    bool isActive() const {
+        return active_;
+    }
+
+    bool isOverflow() const {
+        return overflow_;
+    }
+
+    unsigned count() const {
+        return count_;
+    }
+
+    const TRegisterWrite & operator [] ( unsigned index ) const {
+        return writes_[index];
+    }
+
+    /**
+        Returns the offset of the specified write in a frame of len samples.
+    */
+    unsigned getSampleOffset( unsigned index, unsigned len ) const {
+        unsigned cycle = writes_[index].cycle;
+
+        if( cycle >= cycles_per_frame_ ) {
+            return len;
+        }
+
+        return (unsigned) (((unsigned long long) cycle * len) / cycles_per_frame_);
+    }
+
+private:
+    TRegisterWrite writes_[MaxWrites];
+    unsigned start_cycle_;
+    unsigned cycles_per_frame_;
+    unsigned count_;
+    bool overflow_;
+    bool active_;
+};
+
+#endif // REGISTERLOG_H_
@@ -5,6 +5,8 @@
 */
 #include <math.h>
 
+#include <emu/emu_state.h>
+
 #include "sn76477.h"
 
 const unsigned LFSR_MASK = 0x30009;
@@ -14,6 +16,7 @@ SN76477::SN76477()
 {
     sampling_rate_ = 0;
     enabled_ = false;
+    cpu_enabled_ = false;
     env_c_ = 0; // Not connected (disables attack and decay)
     noise_shift_register_ = 1; // Any (17-bits) nonzero value
     noise_output_ = 0;
@@ -24,6 +27,14 @@ SN76477::SN76477()
     vco_output_ = 0;
     update_flags_ = ufUpdateAll;
 
+    for( int i=0; i<RcCacheSize; i++ ) {
+        rc_cache_[i].r = 0;
+        rc_cache_[i].c = 0;
+        rc_cache_[i].rate = 0; // Empty
+    }
+
+    rc_cache_next_ = 0;
+
     setAmplifier( 1.0, 3.4 ); // Set default volume to slightly less than half
     setMixer( snMixer_None ); // Disable output
 
@@ -94,6 +105,31 @@ void SN76477::setSLF( double r, double c )
     update_flags_ |= ufSLF;
 }
 
+/*
+    Returns the coefficient of an RC filter at the current sampling rate, 
+    i.e. exp(-1/(r*c*rate)). Values are cached, as the envelope control is
+    usually set over and over with the same few components.
+*/
+double SN76477::getDecayCoefficient( double r, double c )
+{
+    for( int i=0; i<RcCacheSize; i++ ) {
+        if( (rc_cache_[i].r == r) && (rc_cache_[i].c == c) && (rc_cache_[i].rate == sampling_rate_) ) {
+            return rc_cache_[i].value;
+        }
+    }
+
+    TRcCacheEntry & entry = rc_cache_[rc_cache_next_];
+
+    rc_cache_next_ = (rc_cache_next_ + 1) % RcCacheSize;
+
+    entry.r = r;
+    entry.c = c;
+    entry.rate = sampling_rate_;
+    entry.value = exp( -1 / (r * c * sampling_rate_) );
+
+    return entry.value;
+}
+
 void SN76477::refreshParameters()
 {
     if( update_flags_ & ufSLF ) {
@@ -148,15 +184,11 @@ void SN76477::refreshParameters()
 
         // Apply filters that are correctly defined
         if( (env_r_attack_ > 0) && (env_c_ > 0) ) {
-            double d = env_r_attack_ * env_c_ * sampling_rate_;
-            
-            envelope_coeff_b_[1] = exp( -1/d );
+            envelope_coeff_b_[1] = getDecayCoefficient( env_r_attack_, env_c_ );
         }
 
         if( (env_r_decay_ > 0) && (env_c_ > 0) ) {
-            double d = env_r_decay_ * env_c_ * sampling_rate_;
-            
-            envelope_coeff_b_[0] = exp( -1/d );
+            envelope_coeff_b_[0] = getDecayCoefficient( env_r_decay_, env_c_ );
         }
 
         envelope_coeff_a_[0] = 1 - envelope_coeff_b_[0];
@@ -166,9 +198,7 @@ void SN76477::refreshParameters()
     if( update_flags_ & ufNoise ) {
         noise_half_period_ = (unsigned) (0.5 + (sampling_rate_ / noise_freq_) / 2);
 
-        double d = noise_r_ * noise_c_ * sampling_rate_;
-        
-        noise_rc_b_ = exp( -1/d );
+        noise_rc_b_ = getDecayCoefficient( noise_r_, noise_c_ );
         noise_rc_a_ = 1 - noise_rc_b_;
         noise_rc_y_ = 0;
     }
@@ -240,6 +270,75 @@ void SN76477::setAmplifier( double rf, double rg )
 }
 
 void SN76477::enableOutput( bool enabled )
+{
+    cpu_enabled_ = enabled;
+    setEnabled( enabled );
+}
+
+void SN76477::enableOutput( bool enabled, unsigned cycle )
+{
+    cpu_enabled_ = enabled;
+
+    if( ! log_.add( cycle, lcEnable, enabled ? 1 : 0 ) ) {
+        setEnabled( enabled );
+    }
+}
+
+void SN76477::applyControl( unsigned line, unsigned char value )
+{
+    switch( line ) {
+    case lcEnable:
+        setEnabled( value != 0 );
+        break;
+    }
+}
+
+void SN76477::beginFrame( unsigned cycle, unsigned cyclesPerFrame )
+{
+    // Apply changes from a frame that has not been played
+    for( unsigned i=0; i<log_.count(); i++ ) {
+        applyControl( log_[i].reg, log_[i].value );
+    }
+
+    endControlLog();
+
+    log_.begin( cycle, cyclesPerFrame );
+}
+
+void SN76477::endControlLog()
+{
+    if( log_.isOverflow() ) {
+        // Catch up with the changes that did not fit into the log
+        setEnabled( cpu_enabled_ );
+    }
+
+    log_.end();
+}
+
+/*
+    Plays the sound, splitting the buffer at the logged changes (if any).
+*/
+void SN76477::playSound( int * buffer, int len, unsigned samplingRate )
+{
+    int pos = 0;
+
+    for( unsigned i=0; i<log_.count(); i++ ) {
+        int offset = (int) log_.getSampleOffset( i, len );
+
+        if( offset > pos ) {
+            renderSound( buffer + pos, offset - pos, samplingRate );
+            pos = offset;
+        }
+
+        applyControl( log_[i].reg, log_[i].value );
+    }
+
+    endControlLog();
+
+    renderSound( buffer + pos, len - pos, samplingRate );
+}
+
+void SN76477::setEnabled( bool enabled )
 {
     if( enabled_ != enabled ) {
         enabled_ = enabled;
@@ -254,36 +353,84 @@ void SN76477::enableOutput( bool enabled )
     }
 }
 
-void SN76477::playSound( int * buffer, int len, unsigned samplingRate )
+/*
+    Renders the oscillators for a block of samples, one generator at a time,
+    then mixes them and applies the envelope. The result is the same as 
+    running all generators together sample by sample.
+*/
+void SN76477::renderBlock( int * buffer, int len )
 {
-    if( ! enabled_ ) {
-        return;
-    }
+    unsigned char slf[BlockSize];
+    unsigned char vco[BlockSize];
+    unsigned char noise[BlockSize];
+    unsigned char env[BlockSize];
+    unsigned vco_period[BlockSize];
+    int i;
+
+    // Update SLF
+    if( vco_select_ && (slf_half_period_ > 0) ) {
+        // Internal control: SLF modulates VCO frequency. The VCO period is
+        // min + o*(max-min)/hp, where o moves by one at each sample, so the
+        // quotient is stepped rather than divided for every sample
+        unsigned hp = slf_half_period_;
+        unsigned k = vco_max_period_ - vco_min_period_;
+        unsigned q = 0;
+        unsigned r = 0;
+
+        for( i=0; i<len; i++ ) {
+            if( (i == 0) || (slf_offset_ >= hp) ) {
+                if( slf_offset_ >= hp ) {
+                    // Invert output
+                    slf_offset_ = 0;
+                    slf_output_ ^= 0xFF;
+                }
+
+                unsigned o = slf_output_ ? slf_offset_ : hp - slf_offset_;
+
+                q = o * k / hp;
+                r = o * k - q * hp;
+            }
 
-    // Refresh parameters if something has changed since last call
-    if( sampling_rate_ != samplingRate ) {
-        sampling_rate_ =  samplingRate;
-        update_flags_ = ufUpdateAll;
-    }
+            slf[i] = (unsigned char) slf_output_;
+            vco_period[i] = vco_min_period_ + q;
+            slf_offset_++;
 
-    if( update_flags_ ) {
-        refreshParameters();
+            if( slf_output_ ) {
+                r += k;
+
+                if( r >= hp ) {
+                    q += r / hp;
+                    r %= hp;
+                }
+            }
+            else {
+                while( (r < k) && (q > 0) ) {
+                    r += hp;
+                    q--;
+                }
+
+                r -= k;
+            }
+        }
     }
+    else {
+        for( i=0; i<len; i++ ) {
+            if( slf_offset_ >= slf_half_period_ ) {
+                // Invert output
+                slf_offset_ = 0;
+                slf_output_ ^= 0xFF;
+            }
 
-    // Play the sound
-    while( len > 0 ) {
-        // Update SLF
-        if( slf_offset_ >= slf_half_period_ ) {
-            // Invert output
-            slf_offset_ = 0;
-            slf_output_ ^= 0xFF;
+            slf[i] = (unsigned char) slf_output_;
+            vco_period[i] = vco_min_period_;
+            slf_offset_++;
         }
+    }
 
-        // Update VCO
+    // Update VCO
+    for( i=0; i<len; i++ ) {
         if( vco_select_ ) {
-            // Internal control: SLF modulates VCO frequency
-            unsigned o = slf_output_ ? slf_offset_ : slf_half_period_ - slf_offset_;
-            unsigned t = vco_min_period_ + (unsigned) (o * (vco_max_period_-vco_min_period_) / slf_half_period_);
+            unsigned t = vco_period[i];
 
             vco_half_period_[0] = t * vco_duty_cycle_ / 512;
             vco_half_period_[1] = t - vco_half_period_[0];
@@ -308,53 +455,193 @@ void SN76477::playSound( int * buffer, int len, unsigned samplingRate )
             }
         }
 
-        // Update noise
+        vco[i] = (unsigned char) vco_output_;
+        env[i] = (unsigned char) envelope_mask_[envelope_];
+        vco_offset_++;
+    }
+
+    // Update noise
+    for( i=0; i<len; i++ ) {
         if( noise_offset_ >= noise_half_period_ ) {
-            if( noise_shift_register_ & 1 ) {
-                noise_shift_register_ ^= LFSR_MASK;
-                noise_output_ = 0xFF;
-            }
-            else {
-                noise_output_ = 0x00;
-            }
+            // Shift the LFSR (without branches, as the output bit is random)
+            unsigned bit = 0 - (noise_shift_register_ & 1);
 
-            noise_shift_register_ >>= 1;
+            noise_shift_register_ = (noise_shift_register_ ^ (LFSR_MASK & bit)) >> 1;
+            noise_output_ = bit & 0xFF;
             noise_offset_ = 0;
         }
-        
-        // Bump offsets
-        slf_offset_++;
-        vco_offset_++;
+
+        noise[i] = (unsigned char) noise_output_;
         noise_offset_++;
+    }
 
-        // Update one-shot timer
-        if( oneshot_offset_ ) {
-            if( --oneshot_offset_ == 0 ) {
-                envelope_mask_[snEnv_OneShot] = 0x00;
+    // Update one-shot timer
+    if( envelope_ == snEnv_OneShot ) {
+        for( i=0; i<len; i++ ) {
+            if( oneshot_offset_ ) {
+                if( --oneshot_offset_ == 0 ) {
+                    envelope_mask_[snEnv_OneShot] = 0x00;
+                }
             }
+
+            env[i] = (unsigned char) envelope_mask_[snEnv_OneShot];
         }
+    }
+    else if( oneshot_offset_ > (unsigned) len ) {
+        oneshot_offset_ -= len;
+    }
+    else if( oneshot_offset_ ) {
+        oneshot_offset_ = 0;
+        envelope_mask_[snEnv_OneShot] = 0x00;
+    }
 
-        // Compute envelope
-        unsigned e = envelope_mask_[envelope_];
+    // Mix SLF, VCO and Noise according to mixer settings
+    for( i=0; i<len; i++ ) {
+        vco[i] = (unsigned char) ((vco[i] | vco_mixer_mask_) & (slf[i] | slf_mixer_mask_) & (noise[i] | noise_mixer_mask_));
+    }
 
-        if( e ^ envelope_value_ ) {
-            // Envelope changed, select attack/decay coefficients accordingly
-            envelope_a_ = envelope_coeff_a_[e & 0x01];
-            envelope_b_ = envelope_coeff_b_[e & 0x01];
-            envelope_value_ = e;
+    // Apply envelope and write to output buffer
+    if( (envelope_coeff_b_[0] == 0) && (envelope_coeff_b_[1] == 0) ) {
+        // No attack/decay filter: output follows the envelope
+        for( i=0; i<len; i++ ) {
+            buffer[i] = volume_table_[vco[i] & env[i]];
         }
 
-        // Apply attack/decay filter
-        envelope_y_ = envelope_a_ * e + envelope_b_ * envelope_y_;
+        unsigned e = env[len-1];
 
-        e = (unsigned) envelope_y_;
+        envelope_value_ = e;
+        envelope_a_ = envelope_coeff_a_[e & 0x01];
+        envelope_b_ = envelope_coeff_b_[e & 0x01];
+        envelope_y_ = envelope_a_ * e;
+    }
+    else {
+        for( i=0; i<len; i++ ) {
+            unsigned e = env[i];
+
+            if( e ^ envelope_value_ ) {
+                // Envelope changed, select attack/decay coefficients accordingly
+                envelope_a_ = envelope_coeff_a_[e & 0x01];
+                envelope_b_ = envelope_coeff_b_[e & 0x01];
+                envelope_value_ = e;
+            }
 
-        // Mix SLF, VCO and Noise according to mixer settings
-        unsigned s = (vco_output_ | vco_mixer_mask_) & (slf_output_ | slf_mixer_mask_) & (noise_output_ | noise_mixer_mask_);
+            // Apply attack/decay filter
+            envelope_y_ = envelope_a_ * e + envelope_b_ * envelope_y_;
 
-        // Combine mixer output with envelope and write to output buffer
-        *buffer++ = volume_table_[s & e];
+            buffer[i] = volume_table_[vco[i] & (unsigned) envelope_y_];
+        }
+    }
+}
 
-        len--;
+/*
+    Returns true if the output will stay at zero until the chip is retriggered.
+*/
+bool SN76477::isSettled() const
+{
+    return (envelope_ == snEnv_OneShot) && (oneshot_offset_ == 0) && (envelope_mask_[snEnv_OneShot] == 0) && (envelope_y_ < 1.0);
+}
+
+void SN76477::renderSound( int * buffer, int len, unsigned samplingRate )
+{
+    if( ! enabled_ ) {
+        return;
+    }
+
+    // Refresh parameters if something has changed since last call
+    if( sampling_rate_ != samplingRate ) {
+        sampling_rate_ =  samplingRate;
+        update_flags_ = ufUpdateAll;
+    }
+
+    if( update_flags_ ) {
+        refreshParameters();
+    }
+
+    // Play the sound
+    while( len > 0 ) {
+        if( isSettled() ) {
+            // One-shot has expired and the envelope has decayed: the output
+            // is silent until the next trigger, so skip the generators (their
+            // phase at trigger time is arbitrary anyway)
+            int v = volume_table_[0];
+
+            while( len > 0 ) {
+                *buffer++ = v;
+                len--;
+            }
+
+            break;
+        }
+
+        int n = len < BlockSize ? len : BlockSize;
+
+        renderBlock( buffer, n );
+
+        buffer += n;
+        len -= n;
+    }
+}
+
+void SN76477::serialize( TStateStream & state )
+{
+    // Parameters (the amplifier volume table is only set when the chip is configured)
+    state.value( slf_r_ );
+    state.value( slf_c_ );
+    state.value( vco_r_ );
+    state.value( vco_c_ );
+    state.value( vco_f_ );
+    state.value( vco_p_ );
+    state.value( oneshot_r_ );
+    state.value( oneshot_c_ );
+    state.value( env_r_attack_ );
+    state.value( env_r_decay_ );
+    state.value( env_c_ );
+    state.value( noise_r_ );
+    state.value( noise_c_ );
+    state.value( amp_rf_ );
+    state.value( amp_rg_ );
+    state.value( enabled_ );
+    state.value( cpu_enabled_ );
+    state.value( vco_select_ );
+    state.value( mixer_ );
+    state.value( envelope_ );
+
+    // Generators (the derived values are recomputed when parameters change)
+    state.value( update_flags_ );
+    state.value( sampling_rate_ );
+    state.bytes( envelope_mask_, sizeof(envelope_mask_) );
+    state.value( envelope_value_ );
+    state.value( envelope_y_ );
+    state.value( envelope_a_ );
+    state.value( envelope_b_ );
+    state.bytes( envelope_coeff_a_, sizeof(envelope_coeff_a_) );
+    state.bytes( envelope_coeff_b_, sizeof(envelope_coeff_b_) );
+    state.value( noise_half_period_ );
+    state.value( noise_offset_ );
+    state.value( noise_shift_register_ );
+    state.value( noise_output_ );
+    state.value( noise_mixer_mask_ );
+    state.value( noise_freq_ );
+    state.value( noise_rc_a_ );
+    state.value( noise_rc_b_ );
+    state.value( noise_rc_y_ );
+    state.value( oneshot_period_ );
+    state.value( oneshot_offset_ );
+    state.value( slf_half_period_ );
+    state.value( slf_offset_ );
+    state.value( slf_output_ );
+    state.value( slf_mixer_mask_ );
+    state.bytes( vco_half_period_, sizeof(vco_half_period_) );
+    state.value( vco_half_period_index_ );
+    state.value( vco_min_period_ );
+    state.value( vco_max_period_ );
+    state.value( vco_duty_cycle_ );
+    state.value( vco_offset_ );
+    state.value( vco_output_ );
+    state.value( vco_mixer_mask_ );
+    state.value( vco_alternate_index_ );
+
+    if( state.isLoading() ) {
+        log_.end();
     }
 }
@@ -6,6 +6,10 @@
 #ifndef SN76477_H_
 #define SN76477_H_
 
+#include "registerlog.h"
+
+class TStateStream;
+
 enum {
     // Mixer
     snMixer_VCO = 0,
@@ -128,14 +132,43 @@ public:
         @param enabled true to enable sound, false otherwise
     */
     void enableOutput( bool enabled );
-    
+
+    /**
+        Enables or disables sound output at the specified CPU cycle.
+
+        If a frame is being logged (see beginFrame()) the change will take effect
+        at the corresponding sample in the next call to playSound(), otherwise
+        it is applied immediately.
+
+        @param enabled true to enable sound, false otherwise
+        @param cycle current value of the CPU cycle counter
+    */
+    void enableOutput( bool enabled, unsigned cycle );
+
+    /**
+        Starts logging control changes for a new frame.
+
+        @param cycle current value of the CPU cycle counter
+        @param cyclesPerFrame number of CPU cycles per frame
+    */
+    void beginFrame( unsigned cycle, unsigned cyclesPerFrame );
+
     /**
         Returns true if the output is enabled, false otherwise.
+
+        While a frame is being logged, this is the state at the start of the frame.
     */
     bool isOutputEnabled() {
         return enabled_;
     }
 
+    /**
+        Returns true if there are logged changes waiting to be played.
+    */
+    bool hasLoggedChanges() const {
+        return (log_.count() > 0) || log_.isOverflow();
+    }
+
     /**
         Sets the envelope applied to the mixer output.
 
@@ -227,9 +260,21 @@ public:
     */
     void setAmplifier( int max );
 
-    /** */
+    /**
+        Plays the sound into the specified buffer.
+
+        If control changes have been logged since beginFrame(), the buffer is
+        assumed to span the whole frame and each change is applied at the
+        corresponding sample.
+    */
     void playSound( int * buffer, int len, unsigned samplingRate );
 
+    /**
+        Saves or loads the chip state. States must be taken between frames,
+        when no control changes are being logged.
+    */
+    void serialize( TStateStream & state );
+
     /** Returns the noise frequency set by specified resistor (at pin 4). */
     static double getNoiseFreqFromRes( double r );
 
@@ -244,7 +289,31 @@ private:
         ufUpdateAll = 0xFFFF
     };
 
+    // Control lines that can be logged
+    enum {
+        lcEnable
+    };
+
+    enum {
+        BlockSize = 64,     // Samples rendered per generator pass
+        RcCacheSize = 8     // Number of cached filter coefficients
+    };
+
+    struct TRcCacheEntry {
+        double r;
+        double c;
+        unsigned rate;
+        double value;
+    };
+
     void refreshParameters();
+    void setEnabled( bool enabled );
+    void applyControl( unsigned line, unsigned char value );
+    void endControlLog();
+    void renderSound( int * buffer, int len, unsigned samplingRate );
+    void renderBlock( int * buffer, int len );
+    bool isSettled() const;
+    double getDecayCoefficient( double r, double c );
 
     double slf_r_;
     double slf_c_;
@@ -262,6 +331,8 @@ private:
     double amp_rf_;
     double amp_rg_;
     bool enabled_;
+    bool cpu_enabled_; // Enabled state as set by the CPU (ahead of enabled_ while logging)
+    TRegisterLog log_; // Changes not yet applied
     int vco_select_;
     unsigned mixer_;
     int envelope_;
@@ -300,6 +371,8 @@ private:
     unsigned vco_mixer_mask_;
     unsigned vco_alternate_index_;
     int      volume_table_[256];
+    TRcCacheEntry rc_cache_[RcCacheSize];
+    unsigned rc_cache_next_;
 };
 
 #endif // SN76477_H_
@@ -3,6 +3,12 @@
 
     Copyright (c) 2004 Alessandro Scotti
 */
+#include <math.h>
+
+#include <emu/emu_blep.h>
+#include <emu/emu_math.h>
+#include <emu/emu_state.h>
+
 #include "waveform.h"
 
 TSquareWaveGenerator::TSquareWaveGenerator()
@@ -29,58 +35,108 @@ void TSquareWaveGenerator::setAmplitude( int hi, int lo )
 void TSquareWaveGenerator::apply( int op, int * data, unsigned len, unsigned samplingRate )
 {
     if( samplingRate != sampling_rate_ ) {
-        // Convert time from seconds to samples (note that we discard decimals here,
-        // so there may be errors if period is very small)
+        // Convert time from seconds to samples, keeping the fractional part
+        // (periods shorter than one sample are clamped, they would only alias)
         for( int i=0; i<3; i++ ) {
-            half_period_samples_[i] = (unsigned) (half_period_secs_[i] * samplingRate);
+            half_period_samples_[i] = half_period_secs_[i] * samplingRate;
+
+            if( half_period_samples_[i] < 1 ) {
+                half_period_samples_[i] = 1;
+            }
         }
 
         sampling_rate_ = samplingRate;
     }
 
     int value = (half_period_index_ == 1) ? value_lo_ : value_hi_;
+    double pending = blep_carry_;
+    unsigned pos = 0;
 
-    while( len > 0 ) {
-        // Get max number of samples with same value
-        unsigned count = half_period_samples_[half_period_index_] - current_offset_;
+    while( pos < len ) {
+        // Get time of next edge and first sample with the new value
+        double edge = pos + half_period_samples_[half_period_index_] - current_offset_;
 
-        if( count > len ) {
-            count = len;
+        if( edge < pos ) {
+            // Already past a shorter half period (e.g. after a change of period or sampling rate)
+            edge = pos;
         }
 
-        // Update counters
-        current_offset_ += count;
-        len -= count;
+        unsigned next = (edge >= len) ? len : (unsigned) ceil( edge );
 
-        // Apply selected operation to sample block
-        switch( op ) {
-        case 0:
-            // Set
-            for( ; count > 0; count-- ) *data++  = value;
-            break;
-        case 1:
-            // Add
-            for( ; count > 0; count-- ) *data++ += value;
-            break;
-        case 2:
-            // And
-            for( ; count > 0; count-- ) *data++ &= value;
-            break;
-        case 3:
-            // Sub
-            for( ; count > 0; count-- ) *data++ -= value;
+        if( next > pos ) {
+            unsigned count = next - pos;
+            int * p = data + pos;
+
+            // Apply selected operation to sample block
+            switch( op ) {
+            case 0:
+                // Set
+                for( ; count > 0; count-- ) *p++  = value;
+                break;
+            case 1:
+                // Add
+                for( ; count > 0; count-- ) *p++ += value;
+                break;
+            case 2:
+                // And
+                for( ; count > 0; count-- ) *p++ &= value;
+                break;
+            case 3:
+                // Sub
+                for( ; count > 0; count-- ) *p++ -= value;
+                break;
+            }
+
+            // Apply correction left over from previous edge
+            if( op != opAnd ) {
+                data[pos] += (op == opSub) ? -TMath::round( pending ) : TMath::round( pending );
+            }
+
+            pending = 0;
+        }
+
+        if( edge >= len ) {
+            current_offset_ += len - pos;
             break;
         }
 
-        // Invert value if needed
-        if( current_offset_ >= half_period_samples_[half_period_index_] ) {
-            current_offset_ = 0;
+        // Invert value
+        if( ++half_period_index_ > 2 ) {
+            half_period_index_ = 1;
+        }
+
+        int h = ((half_period_index_ == 1) ? value_lo_ : value_hi_) - value;
+        double x = next - edge;
+
+        value += h;
+        current_offset_ = x;
+
+        if( op != opAnd ) {
+            // Smooth the edge: the sample before it is already in the buffer,
+            // the one after will be written by the next run
+            if( next > 0 ) {
+                int r = TMath::round( h * TBlep::before( x - 1 ) );
 
-            if( ++half_period_index_ > 2 ) {
-                half_period_index_ = 1;
+                data[next-1] += (op == opSub) ? -r : r;
             }
 
-            value = (half_period_index_ == 1) ? value_lo_ : value_hi_;
+            pending += h * TBlep::after( x );
         }
+
+        pos = next;
     }
+
+    blep_carry_ = pending;
+}
+
+void TSquareWaveGenerator::serialize( TStateStream & state )
+{
+    state.bytes( half_period_samples_, sizeof(half_period_samples_) );
+    state.value( half_period_index_ );
+    state.value( current_offset_ );
+    state.value( blep_carry_ );
+    state.value( sampling_rate_ );
+    state.bytes( half_period_secs_, sizeof(half_period_secs_) );
+    state.value( value_lo_ );
+    state.value( value_hi_ );
 }
@@ -6,6 +6,16 @@
 #ifndef WAVEFORM_H_
 #define WAVEFORM_H_
 
+class TStateStream;
+
+/**
+    Square wave generator.
+
+    Periods are kept with fractional precision, so the frequency is exact at
+    any sampling rate, and each edge is rendered as a band-limited step at its
+    fractional position (except when and-ing with the buffer, where the
+    output is used as a mask).
+*/
 class TSquareWaveGenerator
 {
 public:
@@ -35,6 +45,7 @@ public:
     void reset() {
         current_offset_ = 0;
         half_period_index_ = 0;
+        blep_carry_ = 0;
     }
 
     void addToBuffer( int * data, unsigned len, unsigned samplingRate ) {
@@ -49,6 +60,8 @@ public:
         apply( opSet, data, len, samplingRate );
     }
 
+    void serialize( TStateStream & state );
+
 private:
     enum {
         opSet, opAdd, opAnd, opSub
@@ -56,9 +69,10 @@ private:
 
     void apply( int op, int * data, unsigned len, unsigned samplingRate );
 
-    unsigned half_period_samples_[3];
+    double half_period_samples_[3];
     unsigned half_period_index_;
-    unsigned current_offset_;
+    double current_offset_;     // Time elapsed in current half period (in samples)
+    double blep_carry_;         // Step correction pending for the next sample
     unsigned sampling_rate_;
     double half_period_secs_[3];
     int value_lo_;
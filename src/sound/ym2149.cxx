@@ -5,6 +5,10 @@
 */
 #include <math.h>
 
+#include <emu/emu_blep.h>
+#include <emu/emu_math.h>
+#include <emu/emu_state.h>
+
 #include "ym2149.h"
 
 /*
@@ -17,6 +21,41 @@ const unsigned LFSR_MASK = 0x30009;
 
 const unsigned MaxEnvelopeLevel = YM2149::EnvelopeSteps-1;
 
+// Below this half period (in samples) the output is rendered sample by sample
+const unsigned DenseEdgeSamples = 8;
+
+/*
+    Generators add step to their counter at each sample and flip (at most
+    once per sample) when it reaches the half period. These helpers compute
+    the same sequence for a whole run of samples.
+*/
+
+// Returns the number of samples until the next flip (at least one)
+static inline unsigned getSamplesToEdge( unsigned counter, unsigned half_period, unsigned step )
+{
+    if( counter + step >= half_period ) {
+        return 1;
+    }
+
+    return (half_period - counter + step - 1) / step;
+}
+
+// Advances the counter by the specified number of samples, returns the number of flips
+static inline unsigned advanceCounter( unsigned & counter, unsigned half_period, unsigned step, unsigned samples )
+{
+    if( step >= half_period ) {
+        // Flips at every sample
+        counter += samples * (step - half_period);
+        return samples;
+    }
+
+    unsigned long long total = counter + (unsigned long long) samples * step;
+
+    counter = (unsigned) (total % half_period);
+
+    return (unsigned) (total / half_period);
+}
+
 void YM2149::initializeVolumeTable() {
     for( int i=0; i<EnvelopeSteps; i++ ) {
         double v = 0.0055244 * pow( sqrt(2), (double)(i-1)/2.0 );
@@ -82,6 +121,17 @@ void YM2149::initializeEnvelopeTable() {
                 break;
             }
         }
+
+        // Check whether the shape holds a constant level after the first section
+        const unsigned * repeat = EnvelopeTable + shape*EnvelopeSteps*3 + EnvelopeSteps;
+
+        envelope_holds_[shape] = true;
+
+        for( int i=1; i<EnvelopeSteps*2; i++ ) {
+            if( repeat[i] != repeat[0] ) {
+                envelope_holds_[shape] = false;
+            }
+        }
     }
 }
 
@@ -119,22 +169,173 @@ void YM2149::reset()
 
     for( i=0; i<NumRegisters; i++ ) {
         reg_[i] = 0;
+        cpu_reg_[i] = 0;
     }
 
+    log_.end();
+    shape_overflow_ = false;
+
     for( i=0; i<NumChannels+2; i++ ) {
         tone_counter_[i] = 0;
     }
 
     envelope_shape_counter_ = 0;
+    blep_carry_ = 0;
 }
 
 void YM2149::setRegister( unsigned index, unsigned char value ) 
 {
     if( index < NumRegisters ) {
-        reg_[index] = value;
+        cpu_reg_[index] = value;
+        applyRegister( index, value );
+    }
+}
+
+void YM2149::setRegister( unsigned index, unsigned char value, unsigned cycle )
+{
+    if( index < NumRegisters ) {
+        cpu_reg_[index] = value;
+
+        if( ! log_.add( cycle, index, value ) ) {
+            applyRegister( index, value );
+        }
+        else if( (index == EnvelopeShape) && log_.isOverflow() ) {
+            // Dropped from the log, the envelope must restart even if the value is the same
+            shape_overflow_ = true;
+        }
+    }
+}
+
+// Updates the registers used for sound generation
+void YM2149::applyRegister( unsigned index, unsigned char value )
+{
+    reg_[index] = value;
+
+    if( index == EnvelopeShape ) envelope_shape_counter_ = 0;
+}
 
-        if( index == EnvelopeShape ) envelope_shape_counter_ = 0;
+void YM2149::beginFrame( unsigned cycle, unsigned cyclesPerFrame )
+{
+    // Apply writes from a frame that has not been played
+    for( unsigned i=0; i<log_.count(); i++ ) {
+        applyRegister( log_[i].reg, log_[i].value );
     }
+
+    endRegisterLog();
+
+    log_.begin( cycle, cyclesPerFrame );
+}
+
+void YM2149::endRegisterLog()
+{
+    if( log_.isOverflow() ) {
+        // Catch up with the writes that did not fit into the log
+        for( unsigned i=0; i<NumRegisters; i++ ) {
+            if( (reg_[i] != cpu_reg_[i]) || ((i == EnvelopeShape) && shape_overflow_) ) {
+                applyRegister( i, cpu_reg_[i] );
+            }
+        }
+    }
+
+    shape_overflow_ = false;
+    log_.end();
+}
+
+// Advances a counter with the specified distance to its next flip (updated
+// as well), returns the number of flips
+static inline unsigned advanceCounter( unsigned & counter, unsigned & edge, unsigned half_period, unsigned step, unsigned samples )
+{
+    unsigned flips;
+
+    if( edge > samples ) {
+        // Common case: no flip yet
+        counter += samples * step;
+        edge -= samples;
+        return 0;
+    }
+
+    if( edge == samples ) {
+        // Common case: run ends at the flip
+        counter += samples * step - half_period;
+        flips = 1;
+    }
+    else {
+        flips = advanceCounter( counter, half_period, step, samples );
+    }
+
+    edge = getSamplesToEdge( counter, half_period, step );
+
+    return flips;
+}
+
+// Clocks all generators for the specified number of samples
+void YM2149::advanceGenerators( const unsigned * half_period, unsigned step, unsigned samples, unsigned * edge )
+{
+    // Tones
+    for( int c=0; c<3; c++ ) {
+        if( advanceCounter( tone_counter_[c], edge[c], half_period[c], step, samples ) & 1 ) {
+            tone_value_ ^= 0xFF << (c*8);
+        }
+    }
+
+    // Noise
+    unsigned flips = advanceCounter( tone_counter_[3], edge[3], half_period[3], step, samples );
+
+    while( flips > 0 ) {
+        if( noise_shift_register_ & 1 ) {
+            noise_shift_register_ ^= LFSR_MASK;
+            noise_value_ = 0xFFFFFF;
+        }
+        else {
+            noise_value_ = 0x000000;
+        }
+        noise_shift_register_ >>= 1;
+        flips--;
+    }
+
+    // Envelope (repeats the second and third sections)
+    flips = advanceCounter( tone_counter_[4], edge[4], half_period[4], step, samples );
+
+    if( flips > 0 ) {
+        envelope_shape_counter_ += flips;
+
+        if( envelope_shape_counter_ >= (EnvelopeSteps*3) ) {
+            envelope_shape_counter_ = EnvelopeSteps + (envelope_shape_counter_ - EnvelopeSteps) % (EnvelopeSteps*2);
+        }
+    }
+}
+
+// Returns the output of all three channels (8 bits each)
+unsigned YM2149::mixChannels( unsigned tone_mixer_mask, unsigned noise_mixer_mask, unsigned tone_volume, unsigned envelope_mixer_mask, const unsigned * envelope ) const
+{
+    // Get output of tone and noise generators
+    unsigned sample = (tone_value_ | tone_mixer_mask) & (noise_value_ | noise_mixer_mask);
+
+    // Modulate with amplitude
+    return sample & (tone_volume | (envelope_mixer_mask & envelope[envelope_shape_counter_]));
+}
+
+/*
+    Plays the sound, splitting the buffer at the logged register writes (if any).
+*/
+void YM2149::playSound( int * buffer, int len, unsigned samplingRate )
+{
+    int pos = 0;
+
+    for( unsigned i=0; i<log_.count(); i++ ) {
+        int offset = (int) log_.getSampleOffset( i, len );
+
+        if( offset > pos ) {
+            renderSound( buffer + pos, offset - pos, samplingRate );
+            pos = offset;
+        }
+
+        applyRegister( log_[i].reg, log_[i].value );
+    }
+
+    endRegisterLog();
+
+    renderSound( buffer + pos, len - pos, samplingRate );
 }
 
 unsigned YM2149::getChannelPeriod( unsigned channel ) const
@@ -168,11 +369,28 @@ unsigned YM2149::getChannelPeriod( unsigned channel ) const
     channels is stored into a single variable (using 8 bits per channel) so that
     masking operations can be performed in parallel on all channels.
 
+    Rather than clocking the generators at every sample, the output is
+    produced a run at a time: the number of samples until the next flip of
+    any audible generator is computed, the samples up to there are constant,
+    and the generators are advanced over the whole run at once. Each change
+    in the output is rendered as a band-limited step placed at the time the
+    generator actually flipped within the sample. The step is shown one
+    sample late, so that the correction before it always falls in the
+    current buffer, while the correction after it is carried over to the
+    next call when the buffer ends.
 */
-void YM2149::playSound( int * buffer, int len, unsigned samplingRate )
+void YM2149::renderSound( int * buffer, int len, unsigned samplingRate )
 {
     unsigned step = (soundClock_ << 10) / samplingRate;
 
+    if( len <= 0 ) {
+        return;
+    }
+
+    // Finish the step that ended the previous buffer
+    *buffer += TMath::round( blep_carry_ );
+    blep_carry_ = 0;
+
     // Prepare the channel mixer masks that will be combined with the square wave
     unsigned tone_mixer_mask = 0x000000;
 
@@ -215,66 +433,206 @@ void YM2149::playSound( int * buffer, int len, unsigned samplingRate )
         }
     }
 
-    // Play the sounds
-    while( len > 0 ) {
-        // Channel A
-        tone_counter_[0] += step;
-        if( tone_counter_[0] >= half_period[0] ) {
-            tone_counter_[0] -= half_period[0];
-            tone_value_ ^= 0x0000FF;
-        }
-        
-        // Channel B
-        tone_counter_[1] += step;
-        if( tone_counter_[1] >= half_period[1] ) {
-            tone_counter_[1] -= half_period[1];
-            tone_value_ ^= 0x00FF00;
+    // Find out which generators can actually change the output: a tone is
+    // only heard if enabled in the mixer on a channel with some amplitude, and
+    // so on. The others are still clocked, but do not stop the bulk fill.
+    unsigned audible_mask = 0;
+    unsigned hold_level = EnvelopeSteps; // Envelope is constant from here on
+
+    for( int c=0; c<3; c++ ) {
+        if( (tone_volume | envelope_mixer_mask) & (0xFF << (c*8)) ) {
+            audible_mask |= 0xFF << (c*8);
         }
-        
-        // Channel C
-        tone_counter_[2] += step;
-        if( tone_counter_[2] >= half_period[2] ) {
-            tone_counter_[2] -= half_period[2];
-            tone_value_ ^= 0xFF0000;
+    }
+
+    if( ! envelope_holds_[getEnvelopeShape()] ) {
+        hold_level = EnvelopeSteps*3;
+    }
+
+    bool audible[5];
+    bool dense = false;
+
+    for( int c=0; c<3; c++ ) {
+        audible[c] = (~tone_mixer_mask & audible_mask & (0xFF << (c*8))) != 0;
+    }
+
+    audible[3] = (~noise_mixer_mask & audible_mask) != 0;
+    audible[4] = (envelope_mixer_mask != 0) && (envelope_shape_counter_ < hold_level);
+
+    for( int i=0; i<5; i++ ) {
+        if( audible[i] && (half_period[i] < DenseEdgeSamples*step) ) {
+            dense = true;
         }
-        
-        // Noise
-        tone_counter_[3] += step;
-        if( tone_counter_[3] >= half_period[3] ) {
-            tone_counter_[3] -= half_period[3];
-            if( noise_shift_register_ & 1 ) {
-                noise_shift_register_ ^= LFSR_MASK;
-                noise_value_ = 0xFFFFFF;
+    }
+
+    if( dense ) {
+        // Output changes every few samples (typically noise), it is cheaper
+        // to clock the generators one sample at a time
+        while( len > 0 ) {
+            // Channel A
+            tone_counter_[0] += step;
+            if( tone_counter_[0] >= half_period[0] ) {
+                tone_counter_[0] -= half_period[0];
+                tone_value_ ^= 0x0000FF;
             }
-            else {
-                noise_value_ = 0x000000;
+            
+            // Channel B
+            tone_counter_[1] += step;
+            if( tone_counter_[1] >= half_period[1] ) {
+                tone_counter_[1] -= half_period[1];
+                tone_value_ ^= 0x00FF00;
+            }
+            
+            // Channel C
+            tone_counter_[2] += step;
+            if( tone_counter_[2] >= half_period[2] ) {
+                tone_counter_[2] -= half_period[2];
+                tone_value_ ^= 0xFF0000;
+            }
+            
+            // Noise
+            tone_counter_[3] += step;
+            if( tone_counter_[3] >= half_period[3] ) {
+                tone_counter_[3] -= half_period[3];
+                if( noise_shift_register_ & 1 ) {
+                    noise_shift_register_ ^= LFSR_MASK;
+                    noise_value_ = 0xFFFFFF;
+                }
+                else {
+                    noise_value_ = 0x000000;
+                }
+                noise_shift_register_ >>= 1;
+            }
+
+            // Envelope
+            tone_counter_[4] += step;
+            if( tone_counter_[4] >= half_period[4] ) {
+                tone_counter_[4] -= half_period[4];
+                envelope_shape_counter_++;
+                if( envelope_shape_counter_ == (EnvelopeSteps*3) ) {
+                    envelope_shape_counter_ = EnvelopeSteps;
+                }
+            }
+
+            // Get output of tone and noise generators
+            unsigned sample = (tone_value_ | tone_mixer_mask) & (noise_value_ | noise_mixer_mask);
+
+            // Modulate with amplitude
+            sample &= tone_volume | (envelope_mixer_mask & envelope[envelope_shape_counter_]);
+
+            // Write all three channels in the output buffer
+            *buffer += (sample      ) & 0xFF;
+            *buffer += (sample >>  8) & 0xFF;
+            *buffer += (sample >> 16);
+
+            buffer++;
+
+            len--;
+        }
+
+        return;
+    }
+
+    unsigned sample = mixChannels( tone_mixer_mask, noise_mixer_mask, tone_volume, envelope_mixer_mask, envelope );
+    int value = (int) ((sample & 0xFF) + ((sample >> 8) & 0xFF) + (sample >> 16));
+
+    // Play the sounds, one run of constant output at a time
+    double inv_step = 1.0 / step;
+    unsigned edge[5];
+
+    for( int i=0; i<5; i++ ) {
+        edge[i] = getSamplesToEdge( tone_counter_[i], half_period[i], step );
+    }
+
+    while( len > 0 ) {
+        audible[4] = (envelope_mixer_mask != 0) && (envelope_shape_counter_ < hold_level);
+
+        // Find the next sample where an audible generator flips
+        unsigned n = (unsigned) len + 1;
+
+        for( int i=0; i<5; i++ ) {
+            if( audible[i] && (edge[i] < n) ) {
+                n = edge[i];
             }
-            noise_shift_register_ >>= 1;
         }
 
-        // Envelope
-        tone_counter_[4] += step;
-        if( tone_counter_[4] >= half_period[4] ) {
-            tone_counter_[4] -= half_period[4];
-            envelope_shape_counter_++;
-            if( envelope_shape_counter_ == (EnvelopeSteps*3) ) {
-                envelope_shape_counter_ = EnvelopeSteps;
+        // Output is constant until then (including the sample of the flip)
+        unsigned count = (n <= (unsigned) len) ? n : (unsigned) len;
+
+        if( value != 0 ) {
+            for( unsigned i=0; i<count; i++ ) {
+                buffer[i] += value;
             }
         }
 
-        // Get output of tone and noise generators
-        unsigned sample = (tone_value_ | tone_mixer_mask) & (noise_value_ | noise_mixer_mask);
+        if( n > (unsigned) len ) {
+            advanceGenerators( half_period, step, count, edge );
+            break;
+        }
+
+        bool flipped[5];
+
+        for( int i=0; i<5; i++ ) {
+            flipped[i] = (edge[i] == n);
+        }
+
+        advanceGenerators( half_period, step, n, edge );
+
+        unsigned new_sample = mixChannels( tone_mixer_mask, noise_mixer_mask, tone_volume, envelope_mixer_mask, envelope );
+
+        buffer += count;
+        len -= count;
+
+        if( new_sample != sample ) {
+            double before = 0;
+            double after = 0;
+
+            // Smooth the step on each channel, using the time (within the sample) of the
+            // flip that caused it
+            for( int c=0; c<3; c++ ) {
+                int h = (int) ((new_sample >> (c*8)) & 0xFF) - (int) ((sample >> (c*8)) & 0xFF);
+
+                if( h != 0 ) {
+                    // The counter is now past the half period by the time elapsed since the flip
+                    int g = flipped[c] ? c : flipped[3] ? 3 : 4;
+                    double t = 1.0 - tone_counter_[g] * inv_step;
+
+                    t = (t < 0) ? 0 : t;
 
-        // Modulate with amplitude
-        sample &= tone_volume | (envelope_mixer_mask & envelope[envelope_shape_counter_]);
+                    before += h * TBlep::before( -t );
+                    after += h * TBlep::after( 1 - t );
+                }
+            }
+
+            sample = new_sample;
+            value = (int) ((sample & 0xFF) + ((sample >> 8) & 0xFF) + (sample >> 16));
 
-        // Write all three channels in the output buffer
-        *buffer += (sample      ) & 0xFF;
-        *buffer += (sample >>  8) & 0xFF;
-        *buffer += (sample >> 16);
+            buffer[-1] += TMath::round( before );
 
-        buffer++;
+            if( len > 0 ) {
+                *buffer += TMath::round( after );
+            }
+            else {
+                blep_carry_ = after;
+            }
+        }
+    }
+}
 
-        len--;
+void YM2149::serialize( TStateStream & state )
+{
+    state.bytes( reg_, sizeof(reg_) );
+    state.bytes( cpu_reg_, sizeof(cpu_reg_) );
+    state.value( address_latch_ );
+    state.value( envelope_shape_counter_ );
+    state.value( noise_shift_register_ );
+    state.value( noise_value_ );
+    state.value( tone_value_ );
+    state.bytes( tone_counter_, sizeof(tone_counter_) );
+    state.value( blep_carry_ );
+
+    if( state.isLoading() ) {
+        log_.end();
+        shape_overflow_ = false;
     }
 }
@@ -6,6 +6,10 @@
 #ifndef YM2149_H_
 #define YM2149_H_
 
+#include "registerlog.h"
+
+class TStateStream;
+
 class YM2149
 {
 public:
@@ -76,9 +80,30 @@ public:
     */
     void setRegister( unsigned index, unsigned char value );
 
+    /**
+        Sets a register value at the specified CPU cycle.
+
+        If a frame is being logged (see beginFrame()) the write will take effect
+        at the corresponding sample in the next call to playSound(), otherwise
+        it is applied immediately.
+
+        @param index register index
+        @param value value to write into the register
+        @param cycle current value of the CPU cycle counter
+    */
+    void setRegister( unsigned index, unsigned char value, unsigned cycle );
+
+    /**
+        Starts logging register writes for a new frame.
+
+        @param cycle current value of the CPU cycle counter
+        @param cyclesPerFrame number of CPU cycles per frame
+    */
+    void beginFrame( unsigned cycle, unsigned cyclesPerFrame );
+
     /** Returns the current value of the specified register. */
     unsigned char getRegister( unsigned index ) const {
-        return (index < NumRegisters) ? reg_[index] : 0x00;
+        return (index < NumRegisters) ? cpu_reg_[index] : 0x00;
     }
 
     /** 
@@ -108,13 +133,23 @@ public:
         setRegister( address_latch_, data );
     }
 
+    /**
+        Sets the register currently being addressed by the internal latch
+        at the specified CPU cycle.
+
+        @see #setRegister
+    */
+    void writeData( unsigned char data, unsigned cycle ) {
+        setRegister( address_latch_, data, cycle );
+    }
+
     /**
         Reads the register currently being addressed by the internal latch.
 
         @see #writeAddress
     */
     unsigned char readData() const {
-        return reg_[address_latch_];
+        return cpu_reg_[address_latch_];
     }
 
     /** Resets the sound chip. */
@@ -126,9 +161,19 @@ public:
         @param buffer buffer where sound output is mixed
         @param len length of buffer (in samples)
         @param samplingRate sampling rate (in Hz) at which output must be produced
+
+        If register writes have been logged since beginFrame(), the buffer is
+        assumed to span the whole frame and each write is applied at the
+        corresponding sample.
     */
     void playSound( int * buffer, int len, unsigned samplingRate );
 
+    /**
+        Saves or loads the chip state. States must be taken between frames,
+        when no register writes are being logged.
+    */
+    void serialize( TStateStream & state );
+
 protected:
     unsigned getChannelPeriod( unsigned channel ) const;
 
@@ -151,14 +196,23 @@ protected:
     unsigned getEnvelopeTableEntryForLevel( unsigned level );
     void initializeVolumeTable();
     void initializeEnvelopeTable();
+    void applyRegister( unsigned index, unsigned char value );
+    void endRegisterLog();
+    void renderSound( int * buffer, int len, unsigned samplingRate );
+    void advanceGenerators( const unsigned * half_period, unsigned step, unsigned samples, unsigned * edge );
+    unsigned mixChannels( unsigned tone_mixer_mask, unsigned noise_mixer_mask, unsigned tone_volume, unsigned envelope_mixer_mask, const unsigned * envelope ) const;
 
 protected:
     unsigned EnvelopeTable[16*EnvelopeSteps*3];
     int VolumeTable[16];
     int EnvelopeVolumeTable[EnvelopeSteps];
+    bool envelope_holds_[16]; // True if shape holds a constant level after the first section
     
 private:
     unsigned char reg_[NumRegisters]; // Registers
+    unsigned char cpu_reg_[NumRegisters]; // Registers as written by the CPU (ahead of reg_ while logging)
+    TRegisterLog log_; // Writes not yet applied to reg_
+    bool shape_overflow_; // Envelope shape written after the log overflowed (restarts the envelope)
     unsigned char address_latch_; // Internal register address latch
     unsigned masterClock_; // Master clock
     unsigned soundClock_; // Clock used for sound generation (master/16)
@@ -168,6 +222,7 @@ private:
     unsigned tone_value_; // Output of all three tone generators (8 bits each)
     // Note: all counters are in fixed point format with 10 bits reserved for decimals
     unsigned tone_counter_[NumChannels+2]; // Tone channels plus noise and envelope
+    double blep_carry_; // Step correction pending for the first sample of the next buffer
 };
 
 #endif // YM2149_H_